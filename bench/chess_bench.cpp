@@ -0,0 +1,520 @@
+#include <array>
+#include <vector>
+#include <memory>
+#include <cctype>
+#include <string>
+#include <unordered_map>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <dirent.h>
+
+#include <benchmark/benchmark.h>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "piece.hpp"
+#include "square.hpp"
+#include "move.hpp"
+#include "search.hpp"
+#include "perft.hpp"
+#include "journal.hpp"
+#include "render.hpp"
+#include "eval.hpp"
+#include "batch.hpp"
+
+
+// Microbenchmarks for the rules engine's hot paths.
+// Each benchmark iteration runs over every position in a fixed corpus, so results are comparable between commits.
+//
+// To save results as JSON for comparison:
+//   chess_bench --benchmark_out=results.json --benchmark_out_format=json
+// and compare 2 result files with Google Benchmark's tools/compare.py.
+
+
+// Opening, middlegame and endgame positions, including the standard perft test positions
+// (which are dense with checks, pins, castling, en passant and promotions).
+static const char* CORPUS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+    "2r2rk1/pp1bqpp1/2n1pn1p/3p4/2PP4/P1NBPN2/1P3PPP/2RQ1RK1 b - - 0 14",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/4k3/8/2p5/8/1P2K3/8 b - - 0 50",
+    "4k3/8/8/8/8/8/8/4K2R w K - 0 1",
+    "r1b1k2r/ppppnppp/2n2q2/2b5/3NP3/2P1B3/PP3PPP/RN1QKB1R w KQkq - 1 7",
+};
+
+
+// Depth of the searches in BM_SearchNodes
+static const int SEARCH_DEPTH = 3;
+
+
+// A game set up in a corpus position. The players are kept alongside it, as the game points to them.
+struct CorpusPosition{
+    Player white;
+    Player black;
+    Game game;
+
+    CorpusPosition(const char* fen) : white(PieceColor::WHITE), black(PieceColor::BLACK), game(&white, &black, fen) {}
+};
+
+
+static std::vector<std::unique_ptr<CorpusPosition>>& corpus(){
+    static std::vector<std::unique_ptr<CorpusPosition>> positions;
+    if (positions.empty()){
+        for (const char* fen: CORPUS){
+            positions.push_back(std::unique_ptr<CorpusPosition>(new CorpusPosition(fen)));
+        }
+    }
+    return positions;
+}
+
+
+// Squares holding pieces of the player whose turn it is, optionally only those of one kind (by lowercase piece letter)
+static std::vector<Square> friendlySquares(Game& game, char pieceLetter = '\0'){
+    std::vector<Square> squares;
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            Piece* piece = board[i][j];
+            if (piece == nullptr || piece->getColor() != game.getTurn()->getColor()){ continue; }
+            if (pieceLetter != '\0' && tolower(piece->toChar()) != pieceLetter){ continue; }
+            squares.push_back(square(i, j));
+        }
+    }
+    return squares;
+}
+
+
+// isAttacked() on every square of every position
+static void BM_IsAttacked(benchmark::State& state){
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (auto& pos: corpus()){
+            std::array<std::array<Piece*, 8>, 8> board = pos->game.getBoard();
+            PieceColor color = pos->game.getTurn()->getColor();
+            for (int i = 0; i < 8; i++){
+                for (int j = 0; j < 8; j++){
+                    benchmark::DoNotOptimize(isAttacked(square(i, j), board, color));
+                    calls++;
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_IsAttacked);
+
+
+// legalDests() for every piece of one kind, belonging to the player whose turn it is, in every position
+static void BM_LegalDests(benchmark::State& state, char pieceLetter){
+    std::vector<std::vector<Square>> squares;
+    for (auto& pos: corpus()){
+        squares.push_back(friendlySquares(pos->game, pieceLetter));
+    }
+
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (size_t p = 0; p < corpus().size(); p++){
+            std::array<std::array<Piece*, 8>, 8> board = corpus()[p]->game.getBoard();
+            for (auto& sq: squares[p]){
+                benchmark::DoNotOptimize(board[sq.row][sq.col]->legalDests(squareIndex(sq), board));
+                calls++;
+            }
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK_CAPTURE(BM_LegalDests, pawn, 'p');
+BENCHMARK_CAPTURE(BM_LegalDests, knight, 'n');
+BENCHMARK_CAPTURE(BM_LegalDests, bishop, 'b');
+BENCHMARK_CAPTURE(BM_LegalDests, rook, 'r');
+BENCHMARK_CAPTURE(BM_LegalDests, queen, 'q');
+BENCHMARK_CAPTURE(BM_LegalDests, king, 'k');
+
+
+// isValidMove() from every friendly piece to every square, as a front end validating arbitrary player input would
+static void BM_IsValidMove(benchmark::State& state){
+    std::vector<std::vector<Square>> squares;
+    for (auto& pos: corpus()){
+        squares.push_back(friendlySquares(pos->game));
+    }
+
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (size_t p = 0; p < corpus().size(); p++){
+            Game& game = corpus()[p]->game;
+            for (auto& start: squares[p]){
+                for (int i = 0; i < 8; i++){
+                    for (int j = 0; j < 8; j++){
+                        benchmark::DoNotOptimize(game.isValidMove(squareIndex(start), squareIndex(i, j)));
+                        calls++;
+                    }
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_IsValidMove);
+
+
+// moveResultsInCheck() for every destination returned by legalDests()
+static void BM_MoveResultsInCheck(benchmark::State& state){
+    std::vector<std::vector<std::pair<SquareIndex, SquareIndex>>> moves;
+    for (auto& pos: corpus()){
+        std::array<std::array<Piece*, 8>, 8> board = pos->game.getBoard();
+        std::vector<std::pair<SquareIndex, SquareIndex>> posMoves;
+        for (auto& start: friendlySquares(pos->game)){
+            for (SquareIndex dest: board[start.row][start.col]->legalDests(squareIndex(start), board)){
+                posMoves.push_back(std::make_pair(squareIndex(start), dest));
+            }
+        }
+        moves.push_back(posMoves);
+    }
+
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (size_t p = 0; p < corpus().size(); p++){
+            Game& game = corpus()[p]->game;
+            for (auto& m: moves[p]){
+                benchmark::DoNotOptimize(game.moveResultsInCheck(m.first, m.second));
+                calls++;
+            }
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_MoveResultsInCheck);
+
+
+// staticExchange() for every capture in every position
+static void BM_StaticExchange(benchmark::State& state){
+    std::vector<std::vector<Move>> captures;
+    for (auto& pos: corpus()){
+        std::array<std::array<Piece*, 8>, 8> board = pos->game.getBoard();
+        std::vector<Move> posCaptures;
+        for (auto& m: pos->game.legalMoves()){
+            if (board[rankOf(m.dest)][fileOf(m.dest)] != nullptr){
+                posCaptures.push_back(m);
+            }
+        }
+        captures.push_back(posCaptures);
+    }
+
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (size_t p = 0; p < corpus().size(); p++){
+            Game& game = corpus()[p]->game;
+            for (auto& m: captures[p]){
+                benchmark::DoNotOptimize(game.staticExchange(m));
+                calls++;
+            }
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_StaticExchange);
+
+
+// getGameState() on every position
+static void BM_GetGameState(benchmark::State& state){
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (auto& pos: corpus()){
+            benchmark::DoNotOptimize(pos->game.getGameState());
+            calls++;
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_GetGameState);
+
+
+// legalMoves() on every position
+static void BM_LegalMoves(benchmark::State& state){
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (auto& pos: corpus()){
+            benchmark::DoNotOptimize(pos->game.legalMoves());
+            calls++;
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_LegalMoves);
+
+
+// countLegalMoves() on every position, to compare with generating the moves
+static void BM_CountLegalMoves(benchmark::State& state){
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (auto& pos: corpus()){
+            benchmark::DoNotOptimize(pos->game.countLegalMoves());
+            calls++;
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_CountLegalMoves);
+
+
+// perft() of every position to depth 3, which counts the last ply without generating it
+static void BM_Perft(benchmark::State& state){
+    uint64_t nodes = 0;
+    for (auto _ : state){
+        for (auto& pos: corpus()){
+            nodes += perft(pos->game, 3);
+        }
+    }
+    state.counters["nodes_per_second"] = benchmark::Counter((double)nodes, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Perft)->Unit(benchmark::kMillisecond);
+
+
+// makeMove() followed by unmakeMove() for every legal move in every position
+static void BM_MakeUnmake(benchmark::State& state){
+    std::vector<std::vector<Move>> moves;
+    for (auto& pos: corpus()){
+        moves.push_back(pos->game.legalMoves());
+    }
+
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (size_t p = 0; p < corpus().size(); p++){
+            Game& game = corpus()[p]->game;
+            for (auto& m: moves[p]){
+                game.makeMove(m);
+                game.unmakeMove();
+                calls++;
+            }
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_MakeUnmake);
+
+
+// Copy-make: restore() of a scratch game to a snapshot of the position, then makeMove(), for every legal move in every position.
+// Once the scratch game's piece pool has warmed up, this allocates nothing.
+static void BM_CopyMake(benchmark::State& state){
+    std::vector<Position> snapshots;
+    std::vector<std::vector<Move>> moves;
+    for (auto& pos: corpus()){
+        snapshots.push_back(pos->game.snapshot());
+        moves.push_back(pos->game.legalMoves());
+    }
+    Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+    Game scratch(&white, &black, snapshots[0]);
+
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (size_t p = 0; p < snapshots.size(); p++){
+            for (auto& m: moves[p]){
+                scratch.restore(snapshots[p]);
+                scratch.makeMove(m);
+                calls++;
+            }
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_CopyMake);
+
+
+// Copying the board array, as getBoard() does
+static void BM_BoardCopy(benchmark::State& state){
+    int64_t calls = 0;
+    for (auto _ : state){
+        for (auto& pos: corpus()){
+            std::array<std::array<Piece*, 8>, 8> board = pos->game.getBoard();
+            benchmark::DoNotOptimize(board);
+            calls++;
+        }
+    }
+    state.SetItemsProcessed(calls);
+}
+BENCHMARK(BM_BoardCopy);
+
+
+// Alpha-beta search of every position to a fixed depth, with move ordering techniques added one at a time
+// (0: none, 1: captures by MVV-LVA and SEE, 2: + killers, 3: + history and counter-moves, 4: + hash move).
+// The "nodes" counter gives the positions searched, to compare how much each technique prunes,
+// and "pawn_hit_rate" the fraction of evaluations that found their pawn structure in the pawn table.
+static void BM_SearchNodes(benchmark::State& state){
+    SearchOptions options;
+    int techniques = state.range(0);
+    options.ordering.captures = techniques >= 1;
+    options.ordering.killers = techniques >= 2;
+    options.ordering.history = techniques >= 3;
+    options.ordering.hashMove = techniques >= 4;
+
+    uint64_t nodes = 0;
+    uint64_t pawnHits = 0;
+    uint64_t pawnProbes = 0;
+    for (auto _ : state){
+        nodes = 0;
+        pawnHits = 0;
+        pawnProbes = 0;
+        for (auto& pos: corpus()){
+            if (pos->game.getGameState() != GameState::CONTESTED){
+                continue;
+            }
+            Searcher searcher(options);
+            nodes += searcher.search(pos->game, SEARCH_DEPTH).nodes;
+            pawnHits += searcher.getPawnTable().getHits();
+            pawnProbes += searcher.getPawnTable().getHits() + searcher.getPawnTable().getMisses();
+        }
+    }
+    state.counters["nodes"] = nodes;
+    state.counters["pawn_hit_rate"] = (pawnProbes == 0) ? 0 : (double)pawnHits / pawnProbes;
+}
+BENCHMARK(BM_SearchNodes)->DenseRange(0, 4)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+
+// Building the frame for the board after each legal move in each position, and after taking it back: the whole board
+// (0), or only the squares that changed (1). The "bytes" counter gives the average size of a frame.
+static void BM_RenderBoard(benchmark::State& state){
+    BoardRenderer renderer((state.range(0) == 0) ? BoardRenderer::Mode::FULL : BoardRenderer::Mode::DIFF);
+    int64_t frames = 0, bytes = 0;
+    for (auto _ : state){
+        for (auto& pos: corpus()){
+            for (auto& m: pos->game.legalMoves()){
+                pos->game.makeMove(m);
+                bytes += renderer.frame(pos->game).size();
+                pos->game.unmakeMove();
+                bytes += renderer.frame(pos->game).size();
+                frames += 2;
+            }
+        }
+    }
+    state.SetItemsProcessed(frames);
+    state.counters["bytes"] = (frames == 0) ? 0 : (double)bytes / frames;
+}
+BENCHMARK(BM_RenderBoard)->Arg(0)->Arg(1);
+
+
+// Scoring every corpus position from its FEN: one at a time, setting up a Game and calling evaluate() (0), or all together,
+// adding them to a PositionBatch and calling evaluateBatch() (1). The two don't compute the same terms; what this compares is
+// the cost per position of getting from a FEN to a score.
+static void BM_ScoreFens(benchmark::State& state){
+    PositionBatch batch;
+    BatchFeatures features;
+    int64_t scored = 0;
+    for (auto _ : state){
+        if (state.range(0) == 0){
+            for (const char* fen: CORPUS){
+                Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+                Game game(&white, &black, fen);
+                benchmark::DoNotOptimize(evaluate(game));
+            }
+        } else {
+            batch.clear();
+            for (const char* fen: CORPUS){
+                batch.add(fen);
+            }
+            evaluateBatch(batch, features);
+            benchmark::DoNotOptimize(features.score.data());
+        }
+        scored += sizeof(CORPUS) / sizeof(CORPUS[0]);
+    }
+    state.SetItemsProcessed(scored);
+}
+BENCHMARK(BM_ScoreFens)->Arg(0)->Arg(1);
+
+
+// evaluateBatch() alone, on a batch of the corpus positions repeated to 4096 positions
+static void BM_EvaluateBatch(benchmark::State& state){
+    PositionBatch batch;
+    while (batch.size() < 4096){
+        for (auto& pos: corpus()){
+            batch.add(pos->game);
+        }
+    }
+    BatchFeatures features;
+    for (auto _ : state){
+        evaluateBatch(batch, features);
+        benchmark::DoNotOptimize(features.score.data());
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_EvaluateBatch);
+
+
+// A directory made with mkdtemp(), removed with everything in it when this goes out of scope. The journal only writes
+// files directly in its directory, so there are no subdirectories to walk.
+struct TempDir{
+    std::string path;
+
+    TempDir(const std::string& pattern) : path(pattern) {
+        if (mkdtemp(&path[0]) == nullptr){
+            path.clear();
+        }
+    }
+
+    ~TempDir(){
+        if (path.empty()){
+            return;
+        }
+        if (DIR* d = opendir(path.c_str())){
+            while (dirent* entry = readdir(d)){
+                std::string name = entry->d_name;
+                if (name != "." && name != ".."){
+                    unlink((path + "/" + name).c_str());
+                }
+            }
+            closedir(d);
+        }
+        rmdir(path.c_str());
+    }
+};
+
+
+// Moves durably logged to a MoveJournal, committing (one write and one fdatasync) every N moves, as the server does once
+// per batch of requests. The journal is kept in a temporary directory (under $TMPDIR, or /tmp), so what it measures is
+// the disk that is on: items_per_second is the moves logged per second of wall-clock time.
+static void BM_JournalCommit(benchmark::State& state){
+    const char* tmp = getenv("TMPDIR");
+    TempDir dir(std::string((tmp != nullptr) ? tmp : "/tmp") + "/chess_bench_journal_XXXXXX");
+    if (dir.path.empty()){
+        state.SkipWithError("could not create a temporary directory");
+        return;
+    }
+
+    std::vector<Move> moves;
+    for (auto& pos: corpus()){
+        for (auto& m: pos->game.legalMoves()){
+            moves.push_back(m);
+        }
+    }
+
+    int64_t logged = 0;
+    {
+        MoveJournal journal(dir.path, 0);
+        std::unordered_map<uint32_t, PackedGame> games;
+        uint32_t maxGameId = 0;
+        if (!journal.open(games, maxGameId)){
+            state.SkipWithError("could not open the journal");
+            return;
+        }
+        size_t next = 0;
+        for (auto _ : state){
+            for (int i = 0; i < state.range(0); i++){
+                journal.logMove(logged % 1024, moves[next]);
+                next = (next + 1) % moves.size();
+                logged++;
+            }
+            journal.commit();
+        }
+    }
+    state.SetItemsProcessed(logged);
+}
+BENCHMARK(BM_JournalCommit)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+
+BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,348 @@
+#include <string>
+#include <vector>
+#include <ostream>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include "annotate.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+#include "movepick.hpp"
+#include "search.hpp"
+#include "pgn.hpp"
+
+
+std::string judgementToStr(MoveJudgement judgement){
+    switch (judgement){
+        case MoveJudgement::INACCURACY: return "inaccuracy";
+        case MoveJudgement::MISTAKE: return "mistake";
+        case MoveJudgement::BLUNDER: return "blunder";
+        default: return "good";
+    }
+}
+
+
+AnalysisCache::AnalysisCache(size_t maxEntries) : shards(new Shard[NUM_SHARDS]) {
+    maxShardEntries = std::max<size_t>(1, maxEntries / NUM_SHARDS);
+    hits = 0;
+    misses = 0;
+}
+
+
+// The shard is picked by the top bits of the hash, as the unordered_map within it uses the low bits
+bool AnalysisCache::probe(uint64_t hash, Entry& entry){
+    Shard& shard = shards[hash >> 58];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(hash);
+    if (it == shard.entries.end()){
+        misses++;
+        return false;
+    }
+    hits++;
+    entry = it->second;
+    return true;
+}
+
+
+void AnalysisCache::store(uint64_t hash, const Entry& entry){
+    Shard& shard = shards[hash >> 58];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.size() >= maxShardEntries){
+        shard.entries.clear();
+    }
+    shard.entries[hash] = entry;
+}
+
+
+void AnalysisCache::clear(){
+    for (int s = 0; s < NUM_SHARDS; s++){
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        shards[s].entries.clear();
+    }
+    hits = 0;
+    misses = 0;
+}
+
+
+uint64_t AnalysisCache::getHits(){
+    return hits;
+}
+
+
+uint64_t AnalysisCache::getMisses(){
+    return misses;
+}
+
+
+GameAnnotator::GameAnnotator(const AnnotateConfig& config) : config(config), cache(config.cacheEntries) {
+    positionsSearched = 0;
+    elapsedSeconds = 0;
+}
+
+
+// Games are handed out to the workers one at a time through a shared counter, as some are much longer than others
+std::vector<GameAnnotation> GameAnnotator::annotate(const std::vector<PgnGame>& games){
+    std::vector<GameAnnotation> annotations(games.size());
+    std::atomic<size_t> nextGame(0);
+
+    auto worker = [&](){
+        Searcher searcher(config.searchOptions);
+        while (true){
+            size_t i = nextGame++;
+            if (i >= games.size()){
+                break;
+            }
+            annotations[i] = annotateGame(searcher, games[i]);
+        }
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    int numThreads = std::max(1, config.numThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; t++){
+        workers.push_back(std::thread(worker));
+    }
+    for (auto& w: workers){
+        w.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    elapsedSeconds = elapsed.count();
+    return annotations;
+}
+
+
+GameAnnotation GameAnnotator::annotate(const PgnGame& game){
+    Searcher searcher(config.searchOptions);
+    return annotateGame(searcher, game);
+}
+
+
+AnalysisCache& GameAnnotator::getCache(){
+    return cache;
+}
+
+
+uint64_t GameAnnotator::getPositionsSearched(){
+    return positionsSearched;
+}
+
+
+double GameAnnotator::getElapsedSeconds(){
+    return elapsedSeconds;
+}
+
+
+// A finished position (checkmate or a draw) is scored without searching, and isn't cached
+AnalysisCache::Entry GameAnnotator::analyse(Searcher& searcher, Game& game){
+    AnalysisCache::Entry entry;
+    GameState state = game.getGameState();
+    if (state != GameState::CONTESTED){
+        entry.score = (state == GameState::CHECKMATE) ? -MATE_SCORE : 0;
+        entry.bestMove = noMove();
+        return entry;
+    }
+
+    uint64_t hash = game.getHash();
+    if (cache.probe(hash, entry)){
+        return entry;
+    }
+    SearchResult result = searcher.search(game, config.limits);
+    positionsSearched++;
+    entry.score = result.score;
+    entry.bestMove = result.bestMove;
+    cache.store(hash, entry);
+    return entry;
+}
+
+
+// The searcher's transposition table is kept from one position to the next, as each position is the last one's child
+// A game goes on past a threefold repetition or the fifty move rule unless a player claims the draw, so only a move
+// moveFromSan() can't find among the legal ones (none after checkmate or stalemate) stops the replay.
+GameAnnotation GameAnnotator::annotateGame(Searcher& searcher, const PgnGame& pgn){
+    GameAnnotation annotation;
+    std::string fen = pgnTag(pgn, "FEN");
+    std::string variant = pgnTag(pgn, "Variant");
+    bool chess960 = variant.find("960") != std::string::npos || variant == "fischerandom";
+    if (!fen.empty() && !Game::isValidFen(fen)){
+        return annotation;
+    }
+
+    Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+    std::unique_ptr<Game> game(fen.empty() ? new Game(&white, &black) : new Game(&white, &black, fen, chess960));
+    bool whiteFirst = game->getTurn()->getColor() == PieceColor::WHITE;
+
+    // Score and best move of each position, the last being the one after the last move
+    std::vector<AnalysisCache::Entry> positions;
+    std::vector<Move> moves;
+    std::vector<std::string> sanMoves;
+    annotation.valid = true;
+    positions.push_back(analyse(searcher, *game));
+    for (auto& san: pgn.sanMoves){
+        Move m;
+        if (!moveFromSan(*game, san, m)){
+            annotation.valid = false;
+            break;
+        }
+        std::string played = moveToSan(*game, m);
+        moves.push_back(m);
+        game->makeMove(m);
+        if (game->isCheck()){
+            played += (game->countLegalMoves() == 0) ? "#" : "+";
+        }
+        sanMoves.push_back(played);
+        positions.push_back(analyse(searcher, *game));
+    }
+
+    // Best moves in SAN, playing back through the game from the end
+    std::vector<std::string> bestMoves(moves.size());
+    for (size_t i = moves.size(); i-- > 0; ){
+        game->unmakeMove();
+        bestMoves[i] = isNoMove(positions[i].bestMove) ? "" : moveToSan(*game, positions[i].bestMove);
+    }
+
+    std::array<int, 2> totalLoss{}, numMoves{};
+    for (size_t i = 0; i < moves.size(); i++){
+        MoveAnnotation move;
+        move.san = sanMoves[i];
+        move.bestMove = bestMoves[i];
+        move.score = positions[i].score;
+        move.playedScore = -positions[i + 1].score;
+
+        int before = std::max(-config.maxScore, std::min(config.maxScore, move.score));
+        int after = std::max(-config.maxScore, std::min(config.maxScore, move.playedScore));
+        move.loss = (moves[i] == positions[i].bestMove) ? 0 : std::max(0, before - after);
+
+        int color = ((i % 2 == 0) == whiteFirst) ? 0 : 1;
+        totalLoss[color] += move.loss;
+        numMoves[color]++;
+        if (move.loss >= config.blunderLoss){
+            move.judgement = MoveJudgement::BLUNDER;
+            annotation.blunders[color]++;
+        } else if (move.loss >= config.mistakeLoss){
+            move.judgement = MoveJudgement::MISTAKE;
+            annotation.mistakes[color]++;
+        } else if (move.loss >= config.inaccuracyLoss){
+            move.judgement = MoveJudgement::INACCURACY;
+            annotation.inaccuracies[color]++;
+        } else {
+            move.judgement = MoveJudgement::GOOD;
+        }
+        annotation.moves.push_back(move);
+    }
+    for (int color = 0; color < 2; color++){
+        annotation.averageLoss[color] = (numMoves[color] == 0) ? 0 : (double)totalLoss[color] / numMoves[color];
+    }
+    return annotation;
+}
+
+
+// Scores are written in pawns, from white's point of view, as is usual in annotations
+static std::string scoreToStr(int score){
+    std::ostringstream out;
+    if (std::abs(score) > MATE_SCORE - MAX_PLY){
+        out << "#" << ((score < 0) ? "-" : "") << (MATE_SCORE - std::abs(score) + 1) / 2;
+    } else {
+        out << std::showpos << std::fixed << std::setprecision(2) << score / 100.0;
+    }
+    return out.str();
+}
+
+
+static std::string lossToStr(double loss){
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << loss;
+    return out.str();
+}
+
+
+// Whether white made the ply-th move (counting from 0) of a game
+static bool whiteMoved(const PgnGame& game, size_t ply){
+    std::string fen = pgnTag(game, "FEN");
+    bool whiteFirst = fen.empty() || fen.find(" b ") == std::string::npos;
+    return (ply % 2 == 0) == whiteFirst;
+}
+
+
+void writeAnnotatedPgn(std::ostream& out, const PgnGame& game, const GameAnnotation& annotation){
+    std::vector<std::pair<std::string, std::string>> tags;
+    for (auto& tag: game.tags){
+        if (tag.first != "Result" && tag.first != "WhiteACPL" && tag.first != "BlackACPL"){
+            tags.push_back(tag);
+        }
+    }
+    tags.push_back(std::make_pair("WhiteACPL", lossToStr(annotation.averageLoss[0])));
+    tags.push_back(std::make_pair("BlackACPL", lossToStr(annotation.averageLoss[1])));
+
+    static const char* NAGS[] = {"", "$6", "$2", "$4"};
+    static const char* NAMES[] = {"", "Inaccuracy", "Mistake", "Blunder"};
+    std::vector<std::string> sanMoves, annotations;
+    for (size_t i = 0; i < annotation.moves.size(); i++){
+        const MoveAnnotation& move = annotation.moves[i];
+        sanMoves.push_back(move.san);
+        int j = (int)move.judgement;
+        if (move.judgement == MoveJudgement::GOOD){
+            annotations.push_back("");
+            continue;
+        }
+        int sign = whiteMoved(game, i) ? 1 : -1;
+        annotations.push_back(std::string(NAGS[j]) + " {" + NAMES[j] + " (" + scoreToStr(sign * move.score) + " -> "
+                              + scoreToStr(sign * move.playedScore) + "). " + move.bestMove + " was best.}");
+    }
+    if (!annotation.valid && !annotations.empty() && annotation.moves.size() < game.sanMoves.size()){
+        annotations.back() += " {Stopped before " + game.sanMoves[annotation.moves.size()] + ", which is not a legal move.}";
+    }
+    writePgn(out, tags, sanMoves, annotations, annotation.valid ? game.result : GameResult::UNFINISHED);
+}
+
+
+// Escapes a string for a JSON string literal
+static std::string jsonString(const std::string& s){
+    std::ostringstream out;
+    out << '"';
+    for (char c: s){
+        if (c == '"' || c == '\\'){
+            out << '\\' << c;
+        } else if ((unsigned char)c < 0x20){
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+
+void writeAnnotatedJson(std::ostream& out, const PgnGame& game, const GameAnnotation& annotation){
+    out << "{\"tags\":{";
+    for (size_t i = 0; i < game.tags.size(); i++){
+        out << ((i > 0) ? "," : "") << jsonString(game.tags[i].first) << ":" << jsonString(game.tags[i].second);
+    }
+    out << "},\"result\":" << jsonString(resultToStr(game.result)) << ",\"valid\":" << (annotation.valid ? "true" : "false");
+
+    static const char* COLORS[] = {"white", "black"};
+    for (int color = 0; color < 2; color++){
+        out << ",\"" << COLORS[color] << "\":{\"acpl\":" << lossToStr(annotation.averageLoss[color])
+            << ",\"inaccuracies\":" << annotation.inaccuracies[color] << ",\"mistakes\":" << annotation.mistakes[color]
+            << ",\"blunders\":" << annotation.blunders[color] << "}";
+    }
+
+    out << ",\"moves\":[";
+    for (size_t i = 0; i < annotation.moves.size(); i++){
+        const MoveAnnotation& move = annotation.moves[i];
+        out << ((i > 0) ? "," : "") << "{\"ply\":" << i + 1 << ",\"san\":" << jsonString(move.san)
+            << ",\"best\":" << jsonString(move.bestMove) << ",\"score\":" << move.score << ",\"played_score\":" << move.playedScore
+            << ",\"loss\":" << move.loss << ",\"judgement\":" << jsonString(judgementToStr(move.judgement)) << "}";
+    }
+    out << "]}" << std::endl;
+}
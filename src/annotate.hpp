@@ -0,0 +1,169 @@
+#include <string>
+#include <vector>
+#include <ostream>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "game.hpp"
+#include "move.hpp"
+#include "search.hpp"
+#include "pgn.hpp"
+
+#pragma once
+
+
+// How bad a move was, by its centipawn loss
+enum class MoveJudgement{
+    GOOD,
+    INACCURACY,
+    MISTAKE,
+    BLUNDER
+};
+
+// Returns the name of a judgement in lowercase, e.g. "blunder"
+std::string judgementToStr(MoveJudgement judgement);
+
+
+struct AnnotateConfig{
+    SearchOptions searchOptions;
+
+    // Budget for analysing each position
+    SearchLimits limits;
+
+    // Least centipawn loss for each judgement
+    int inaccuracyLoss = 50;
+    int mistakeLoss = 100;
+    int blunderLoss = 300;
+
+    // Scores are capped at +/- this many centipawns before working out the loss, so that a forced mate counts as a big
+    // advantage rather than an infinite one (and e.g. a slower mate while still a queen up is no blunder)
+    int maxScore = 1000;
+
+    // Positions kept in the cache shared by the threads
+    size_t cacheEntries = 1 << 20;
+
+    int numThreads = 1;
+};
+
+
+struct MoveAnnotation{
+    std::string san;
+    std::string bestMove;  // The search's choice, in SAN
+    int score;             // Of the position before the move, for the player making it, with the search's best move
+    int playedScore;       // Of the position after the move, for the player who made it
+    int loss;              // Centipawn loss, from the capped scores: 0 if the move was the best move or scored as well
+    MoveJudgement judgement;
+};
+
+
+struct GameAnnotation{
+    bool valid = false; // False if the starting position or a move couldn't be read; moves then holds the moves before it
+    std::vector<MoveAnnotation> moves;
+
+    // For white [0] and black [1]
+    std::array<double, 2> averageLoss{};
+    std::array<int, 2> inaccuracies{};
+    std::array<int, 2> mistakes{};
+    std::array<int, 2> blunders{};
+};
+
+
+// Search results shared by all the threads of an annotator, so a position reached in several games (e.g. the openings)
+// is only searched once. The table is split into shards, each with its own lock, so that threads rarely wait on each other.
+// A shard that fills up is emptied and starts again.
+class AnalysisCache{
+
+    public:
+
+        struct Entry{
+            int score; // For the player to move
+            Move bestMove;
+        };
+
+        AnalysisCache(size_t maxEntries = 1 << 20);
+
+        // Looks up a position by its hash. Returns true and sets entry if it was found.
+        bool probe(uint64_t hash, Entry& entry);
+
+        void store(uint64_t hash, const Entry& entry);
+
+        void clear();
+
+        uint64_t getHits();
+
+        uint64_t getMisses();
+
+    private:
+
+        static const int NUM_SHARDS = 64;
+
+        struct Shard{
+            std::mutex mutex;
+            std::unordered_map<uint64_t, Entry> entries;
+        };
+
+        std::unique_ptr<Shard[]> shards;
+
+        size_t maxShardEntries;
+
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+};
+
+
+// Annotates games: replays each one, searches every position in it with a bounded search, and scores each move by how much
+// worse it was than the search's best move. Games are spread over a pool of worker threads, each with its own searcher,
+// and the searches are shared between them through the cache.
+//
+// The score of a move is that of the position it leads to (as searched, for the player who made it), so the centipawn
+// loss is the score before the move less the score after it. As the cache is shared, a position's score may come from
+// a search made in another game, so the results depend a little on the order the games are annotated in.
+class GameAnnotator{
+
+    public:
+
+        GameAnnotator(const AnnotateConfig& config);
+
+        // Annotates every game. The annotations are in the same order as the games.
+        std::vector<GameAnnotation> annotate(const std::vector<PgnGame>& games);
+
+        // Annotates a single game, on the calling thread
+        GameAnnotation annotate(const PgnGame& game);
+
+        AnalysisCache& getCache();
+
+        // Positions searched (not found in the cache), over all calls
+        uint64_t getPositionsSearched();
+
+        // Wall-clock duration of the last call to annotate(games), in seconds
+        double getElapsedSeconds();
+
+    private:
+
+        GameAnnotation annotateGame(Searcher& searcher, const PgnGame& game);
+
+        // Scores the current position for the player to move, from the cache or by searching it
+        AnalysisCache::Entry analyse(Searcher& searcher, Game& game);
+
+        AnnotateConfig config;
+
+        AnalysisCache cache;
+
+        std::atomic<uint64_t> positionsSearched;
+
+        double elapsedSeconds;
+};
+
+
+// Writes a game in PGN, with NAGs and a comment after each inaccuracy ($6, ?!), mistake ($2, ?) and blunder ($4, ??)
+// giving the loss and the best move, and tags with each player's average centipawn loss
+void writeAnnotatedPgn(std::ostream& out, const PgnGame& game, const GameAnnotation& annotation);
+
+// Writes a game as a JSON object on a single line: its tags, result, each player's average loss and counts,
+// and every move with its scores, loss, judgement and the best move
+void writeAnnotatedJson(std::ostream& out, const PgnGame& game, const GameAnnotation& annotation);
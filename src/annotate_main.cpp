@@ -0,0 +1,102 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+#include "annotate.hpp"
+#include "search.hpp"
+#include "pgn.hpp"
+
+
+// Annotates games in PGN: searches every position of every game, and marks each inaccuracy, mistake and blunder with
+// its centipawn loss and the best move. Writes the games back in the same order as annotated PGN, or as JSON (one object
+// per line), then a summary on standard error.
+//
+// Usage: chess_annotate [options]
+//   --input FILE         read games from FILE (default: standard input)
+//   --format pgn|json    output format (default pgn)
+//   --time MS            time limit per position, in milliseconds
+//   --nodes N            node limit per position (default 5000, unless --time or --depth is given)
+//   --depth N            depth limit per position
+//   --hash BITS          size of each thread's transposition table, as a power of 2 entries (default 16)
+//   --cache N            positions kept in the cache shared by the threads (default 1048576)
+//   --threads N          number of worker threads (default: number of hardware threads)
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_annotate [--input FILE] [--format pgn|json] [--time MS] [--nodes N] [--depth N] [--hash BITS] "
+              << "[--cache N] [--threads N]" << std::endl;
+}
+
+
+int main(int argc, char* argv[]){
+    AnnotateConfig config;
+    config.numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::string inputPath;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--input"){ inputPath = value; }
+        else if (arg == "--format" && (value == "pgn" || value == "json")){ json = value == "json"; }
+        else if (arg == "--time"){ config.limits.timeMs = atoll(value.c_str()); }
+        else if (arg == "--nodes"){ config.limits.nodes = strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--depth"){ config.limits.depth = std::min(MAX_PLY - 1, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--hash"){ config.searchOptions.hashBits = std::min(30, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--cache"){ config.cacheEntries = std::max<size_t>(1, strtoull(value.c_str(), nullptr, 10)); }
+        else if (arg == "--threads"){ config.numThreads = std::max(1, atoi(value.c_str())); }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (config.limits.timeMs == 0 && config.limits.nodes == 0 && config.limits.depth == MAX_PLY - 1){
+        config.limits.nodes = 5000;
+    }
+
+    std::ifstream file;
+    if (!inputPath.empty()){
+        file.open(inputPath);
+        if (!file){
+            std::cerr << "ERROR: COULD NOT OPEN INPUT FILE " << inputPath << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = inputPath.empty() ? std::cin : file;
+
+    std::vector<PgnGame> games;
+    PgnGame game;
+    while (readPgn(in, game)){
+        games.push_back(game);
+    }
+
+    GameAnnotator annotator(config);
+    std::vector<GameAnnotation> annotations = annotator.annotate(games);
+
+    int invalid = 0;
+    for (size_t i = 0; i < games.size(); i++){
+        if (json){ writeAnnotatedJson(std::cout, games[i], annotations[i]); }
+        else { writeAnnotatedPgn(std::cout, games[i], annotations[i]); }
+        if (!annotations[i].valid){
+            invalid++;
+            std::cerr << "ERROR: INVALID MOVE OR POSITION IN GAME " << i + 1 << std::endl;
+        }
+    }
+
+    AnalysisCache& cache = annotator.getCache();
+    uint64_t lookups = cache.getHits() + cache.getMisses();
+    std::cerr << "GAMES: " << games.size() << "  INVALID: " << invalid << "  POSITIONS SEARCHED: " << annotator.getPositionsSearched()
+              << "  CACHE HITS: " << cache.getHits() << " OF " << lookups << " (THREADS: " << config.numThreads << ")" << std::endl;
+    std::cerr << "TIME: " << annotator.getElapsedSeconds() << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <array>
+#include <cstdint>
+
+#include "piece.hpp"
+#include "square.hpp"
+
+#pragma once
+
+
+// Attack tables for the pieces whose attacks don't depend on the rest of the board: knights, kings, and pawns of each color.
+// Each is indexed by square (a SquareIndex), and each entry is a mask with bit row*8 + col set for every square attacked
+// from that square. The tables are worked out at compile time, so looking up a piece's attacks costs a single load,
+// with the edges of the board already taken into account.
+
+
+// The square as a bit of a 64-bit mask
+constexpr uint64_t squareBit(int row, int col){
+    return (uint64_t)1 << (row*8 + col);
+}
+
+constexpr uint64_t squareBit(SquareIndex sq){
+    return (uint64_t)1 << sq;
+}
+
+constexpr uint64_t squareBit(const Square& sq){
+    return squareBit(sq.row, sq.col);
+}
+
+
+// Squares attacked from each square by a piece stepping by any one of steps ({row, col} displacements)
+constexpr std::array<uint64_t, 64> stepAttacks(const int (&steps)[8][2]){
+    std::array<uint64_t, 64> table{};
+    for (int sq = 0; sq < 64; sq++){
+        for (int d = 0; d < 8; d++){
+            int r = sq / 8 + steps[d][0], c = sq % 8 + steps[d][1];
+            if (r >= 0 && r < 8 && c >= 0 && c < 8){
+                table[sq] |= squareBit(r, c);
+            }
+        }
+    }
+    return table;
+}
+
+
+// Squares attacked from each square by a pawn advancing by dir rows. A pawn on the last row attacks nothing.
+constexpr std::array<uint64_t, 64> pawnAttacks(int dir){
+    std::array<uint64_t, 64> table{};
+    for (int sq = 0; sq < 64; sq++){
+        int r = sq / 8 + dir, c = sq % 8;
+        if (r >= 0 && r < 8){
+            if (c > 0){ table[sq] |= squareBit(r, c - 1); }
+            if (c < 7){ table[sq] |= squareBit(r, c + 1); }
+        }
+    }
+    return table;
+}
+
+
+constexpr int KNIGHT_STEPS[8][2] = { {1,2}, {2,1}, {2,-1}, {1,-2}, {-1,-2}, {-2,-1}, {-2,1}, {-1,2} };
+constexpr int KING_STEPS[8][2] = { {1,0}, {-1,0}, {0,1}, {0,-1}, {1,1}, {1,-1}, {-1,1}, {-1,-1} };
+
+inline constexpr std::array<uint64_t, 64> KNIGHT_ATTACKS = stepAttacks(KNIGHT_STEPS);
+inline constexpr std::array<uint64_t, 64> KING_ATTACKS = stepAttacks(KING_STEPS);
+
+// By color: white [0] pawns attack up the board, black [1] down
+inline constexpr std::array<std::array<uint64_t, 64>, 2> PAWN_ATTACKS = { pawnAttacks(1), pawnAttacks(-1) };
+
+
+// Squares a pawn of the given color on sq attacks
+inline uint64_t pawnAttacksFrom(PieceColor color, int sq){
+    return PAWN_ATTACKS[(color == PieceColor::WHITE) ? 0 : 1][sq];
+}
+
+
+static_assert(KNIGHT_ATTACKS[0] == (squareBit(1, 2) | squareBit(2, 1)), "a knight on a1 attacks b3 and c2");
+static_assert(KING_ATTACKS[63] == (squareBit(6, 7) | squareBit(7, 6) | squareBit(6, 6)), "a king on h8 attacks g8, h7 and g7");
+static_assert(PAWN_ATTACKS[0][8] == squareBit(2, 1) && PAWN_ATTACKS[1][8] == squareBit(0, 1), "pawns on a2 attack b3 (white) and b1 (black)");
+static_assert(PAWN_ATTACKS[0][56] == 0 && PAWN_ATTACKS[1][0] == 0, "pawns on their last row attack nothing");
@@ -0,0 +1,283 @@
+#include <array>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include "batch.hpp"
+#include "game.hpp"
+#include "piece.hpp"
+#include "eval.hpp"
+#include "attacks.hpp"
+
+
+// One mask per position, for PositionBatch::LANES positions
+typedef uint64_t Lanes __attribute__((vector_size(PositionBatch::LANES * sizeof(uint64_t))));
+
+static const uint64_t FILE_A = 0x0101010101010101ULL;
+static const uint64_t FILE_B = FILE_A << 1;
+static const uint64_t FILE_G = FILE_A << 6;
+static const uint64_t FILE_H = FILE_A << 7;
+
+// Weights of the mobility and attacks features in the score, in centipawns
+static const int MOBILITY_WEIGHT = 4;
+static const int ATTACK_WEIGHT = 10;
+
+
+// Index of a piece letter in the order of zobristPieceIndex(), or -1
+static int pieceKind(char c){
+    static const char ORDER[] = "PNBRQKpnbrqk";
+    const char* found = strchr(ORDER, c);
+    return (c != '\0' && found != nullptr) ? found - ORDER : -1;
+}
+
+
+PositionBatch::PositionBatch(){
+    count = 0;
+}
+
+
+void PositionBatch::clear(){
+    for (auto& kind: pieces){
+        kind.clear();
+    }
+    whiteTurn.clear();
+    count = 0;
+}
+
+
+void PositionBatch::reserve(size_t positions){
+    size_t padded = (positions + LANES - 1) / LANES * LANES;
+    for (auto& kind: pieces){
+        kind.reserve(padded);
+    }
+    whiteTurn.reserve(padded);
+}
+
+
+size_t PositionBatch::size(){
+    return count;
+}
+
+
+size_t PositionBatch::append(){
+    if (count == whiteTurn.size()){
+        for (auto& kind: pieces){
+            kind.resize(count + LANES, 0);
+        }
+        whiteTurn.resize(count + LANES, 0);
+    }
+    return count++;
+}
+
+
+void PositionBatch::add(Game& game){
+    size_t p = append();
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            if (board[i][j] != nullptr){
+                pieces[pieceKind(board[i][j]->toChar())][p] |= squareBit(i, j);
+            }
+        }
+    }
+    whiteTurn[p] = game.getTurn()->getColor() == PieceColor::WHITE;
+}
+
+
+// The placement field lists the ranks from 8 down to 1, each from file a to h
+bool PositionBatch::add(const std::string& fen){
+    if (!Game::isValidFen(fen)){
+        return false;
+    }
+    size_t p = append();
+    int row = 7, col = 0;
+    size_t i = 0;
+    for (; fen[i] != ' '; i++){
+        char c = fen[i];
+        if (c == '/'){
+            row--;
+            col = 0;
+        } else if (c >= '1' && c <= '8'){
+            col += c - '0';
+        } else {
+            pieces[pieceKind(c)][p] |= squareBit(row, col);
+            col++;
+        }
+    }
+    whiteTurn[p] = fen[i + 1] == 'w';
+    return true;
+}
+
+
+const uint64_t* PositionBatch::masks(int kind){
+    return pieces[kind].data();
+}
+
+
+bool PositionBatch::whiteToMove(size_t position){
+    return whiteTurn[position];
+}
+
+
+// The kernels below take vectors by const reference and write their results to out parameters rather than returning them:
+// passing or returning a vector wider than the target's registers (256 bits without AVX) by value has a different ABI,
+// which GCC warns about (-Wpsabi).
+
+
+// Shifts every mask by s squares: up the board (towards h8) if s is positive, down if negative
+template<int s>
+static inline void shift(const Lanes& b, Lanes& out){
+    out = (s > 0) ? (b << s) : (b >> -s);
+}
+
+
+// Adds the number of bits set in each mask, times weight, to total. There is no vector popcount before AVX-512,
+// so the bits are added up in ever wider fields: pairs, nibbles, bytes, then the 8 bytes.
+static inline void addPopcount(const Lanes& masks, uint64_t weight, Lanes& total){
+    Lanes x = masks - ((masks >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = x + (x >> 8);
+    x = x + (x >> 16);
+    x = x + (x >> 32);
+    total += (x & 0x7F) * weight;
+}
+
+
+// Adds the squares attacked by the sliders along one direction (a step of s squares, landing only on squares in onBoard,
+// which leaves out those that wrap around to the other side of the board) to out, stopping at the first occupied square.
+// The sliders are spread along the empty squares in 3 doubling steps (Kogge-Stone), so a slider reaches as far as 7 squares.
+template<int s>
+static inline void slide(const Lanes& sliders, const Lanes& empty, uint64_t onBoard, Lanes& out){
+    Lanes reach = sliders, open = empty & onBoard, step;
+    shift<s>(reach, step);
+    reach |= open & step;
+    shift<s>(open, step);
+    open &= step;
+    shift<2*s>(reach, step);
+    reach |= open & step;
+    shift<2*s>(open, step);
+    open &= step;
+    shift<4*s>(reach, step);
+    reach |= open & step;
+    shift<s>(reach, step);
+    out |= step & onBoard;
+}
+
+
+static inline void straightAttacks(const Lanes& sliders, const Lanes& empty, Lanes& out){
+    slide<8>(sliders, empty, ~0ULL, out);
+    slide<-8>(sliders, empty, ~0ULL, out);
+    slide<1>(sliders, empty, ~FILE_A, out);
+    slide<-1>(sliders, empty, ~FILE_H, out);
+}
+
+
+static inline void diagonalAttacks(const Lanes& sliders, const Lanes& empty, Lanes& out){
+    slide<9>(sliders, empty, ~FILE_A, out);
+    slide<7>(sliders, empty, ~FILE_H, out);
+    slide<-7>(sliders, empty, ~FILE_A, out);
+    slide<-9>(sliders, empty, ~FILE_H, out);
+}
+
+
+static inline void knightAttacks(const Lanes& knights, Lanes& out){
+    Lanes one = ((knights << 1) & ~FILE_A) | ((knights >> 1) & ~FILE_H);
+    Lanes two = ((knights << 2) & ~(FILE_A | FILE_B)) | ((knights >> 2) & ~(FILE_G | FILE_H));
+    out = (one << 16) | (one >> 16) | (two << 8) | (two >> 8);
+}
+
+
+static inline void kingAttacks(const Lanes& kings, Lanes& out){
+    Lanes row = kings | ((kings << 1) & ~FILE_A) | ((kings >> 1) & ~FILE_H);
+    out = (row | (row << 8) | (row >> 8)) & ~kings;
+}
+
+
+static inline void pawnAttacks(const Lanes& pawns, bool white, Lanes& out){
+    if (white){
+        out = ((pawns << 9) & ~FILE_A) | ((pawns << 7) & ~FILE_H);
+    } else {
+        out = ((pawns >> 7) & ~FILE_A) | ((pawns >> 9) & ~FILE_H);
+    }
+}
+
+
+// Features of one color, for LANES positions
+struct ColorFeatures{
+    Lanes material;
+    Lanes mobility;
+    Lanes attacks;
+};
+
+
+// kinds points to the masks of the color's 6 kinds of piece, at the first of the positions
+static inline ColorFeatures colorFeatures(const uint64_t* const* kinds, size_t p, bool white, const Lanes& own, const Lanes& opp){
+    Lanes k[6];
+    for (int t = 0; t < 6; t++){
+        memcpy(&k[t], kinds[t] + p, sizeof(Lanes));
+    }
+    Lanes empty = ~(own | opp);
+
+    Lanes pawns, knights, bishops = {}, rooks = {}, queens = {}, king;
+    pawnAttacks(k[0], white, pawns);
+    knightAttacks(k[1], knights);
+    diagonalAttacks(k[2], empty, bishops);
+    straightAttacks(k[3], empty, rooks);
+    diagonalAttacks(k[4], empty, queens);
+    straightAttacks(k[4], empty, queens);
+    kingAttacks(k[5], king);
+    Lanes all = pawns | knights | bishops | rooks | queens | king;
+
+    ColorFeatures res = {};
+    for (int t = 0; t < 5; t++){
+        addPopcount(k[t], PIECE_VALUES[t], res.material);
+    }
+    addPopcount(knights & ~own, 1, res.mobility);
+    addPopcount(bishops & ~own, 1, res.mobility);
+    addPopcount(rooks & ~own, 1, res.mobility);
+    addPopcount(queens & ~own, 1, res.mobility);
+    addPopcount(all & opp, 1, res.attacks);
+    return res;
+}
+
+
+void evaluateBatch(PositionBatch& batch, BatchFeatures& features){
+    size_t n = batch.size();
+    features.material.resize(n);
+    features.mobility.resize(n);
+    features.attacks.resize(n);
+    features.score.resize(n);
+
+    const uint64_t* kinds[12];
+    for (int kind = 0; kind < 12; kind++){
+        kinds[kind] = batch.masks(kind);
+    }
+
+    for (size_t p = 0; p < n; p += PositionBatch::LANES){
+        Lanes white = {}, black = {};
+        for (int t = 0; t < 6; t++){
+            Lanes w, b;
+            memcpy(&w, kinds[t] + p, sizeof(Lanes));
+            memcpy(&b, kinds[6 + t] + p, sizeof(Lanes));
+            white |= w;
+            black |= b;
+        }
+        ColorFeatures w = colorFeatures(kinds, p, true, white, black);
+        ColorFeatures b = colorFeatures(kinds + 6, p, false, black, white);
+
+        // The differences wrap around in unsigned arithmetic, and come out right once converted back to signed
+        Lanes material = w.material - b.material;
+        Lanes mobility = w.mobility - b.mobility;
+        Lanes attacks = w.attacks - b.attacks;
+        for (size_t l = 0; l < PositionBatch::LANES && p + l < n; l++){
+            features.material[p + l] = (int32_t)(int64_t)material[l];
+            features.mobility[p + l] = (int32_t)(int64_t)mobility[l];
+            features.attacks[p + l] = (int32_t)(int64_t)attacks[l];
+            int32_t score = features.material[p + l] + MOBILITY_WEIGHT * features.mobility[p + l] + ATTACK_WEIGHT * features.attacks[p + l];
+            features.score[p + l] = batch.whiteToMove(p + l) ? score : -score;
+        }
+    }
+}
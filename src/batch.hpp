@@ -0,0 +1,83 @@
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "game.hpp"
+
+#pragma once
+
+
+// Positions to be scored together, kept as a structure of arrays: for each of the 12 kinds of piece (in the order of
+// zobristPieceIndex(), white pawn first), an array holding a mask per position, with bit row*8 + col set for each square
+// that kind of piece is on. A position only costs 12 masks and a byte, and adding one from a FEN doesn't set up a Game.
+//
+// The arrays are padded with empty positions to a whole number of LANES, so evaluateBatch() can always work on LANES
+// positions at a time.
+class PositionBatch{
+
+    public:
+
+        // Number of positions evaluateBatch() works on at once
+        static const size_t LANES = 4;
+
+        PositionBatch();
+
+        // Removes every position (keeping the arrays' capacity)
+        void clear();
+
+        void reserve(size_t positions);
+
+        // Number of positions added
+        size_t size();
+
+        // Adds the game's current position
+        void add(Game& game);
+
+        // Adds the position in a FEN string, of which only the piece placement and active color fields are used.
+        // Returns false, and adds nothing, if the FEN isn't valid (see Game::isValidFen()).
+        bool add(const std::string& fen);
+
+        // The masks of one kind of piece (0-11, in the order of zobristPieceIndex()), one per position plus the padding
+        const uint64_t* masks(int kind);
+
+        bool whiteToMove(size_t position);
+
+    private:
+
+        // Appends an empty position, first padding the arrays out by LANES if they are full
+        size_t append();
+
+        std::array<std::vector<uint64_t>, 12> pieces;
+
+        std::vector<uint8_t> whiteTurn;
+
+        size_t count;
+};
+
+
+// Features of each position in a batch, as arrays indexed by position. The first 3 are from white's point of view
+// (white's count less black's), and score is from the point of view of the player to move, as with evaluate().
+struct BatchFeatures{
+
+    // Material, in centipawns, using PIECE_VALUES (the kings cancel out)
+    std::vector<int32_t> material;
+
+    // For each kind of piece other than pawns and the king, the number of squares not holding a friendly piece
+    // that pieces of that kind attack. A square attacked by 2 knights counts once for knights.
+    std::vector<int32_t> mobility;
+
+    // Number of opposition pieces attacked (including the king, if it is in check)
+    std::vector<int32_t> attacks;
+
+    // material plus weighted mobility and attacks
+    std::vector<int32_t> score;
+};
+
+
+// Works out the features of every position in the batch. Each step applies to LANES positions at once, as operations
+// on GCC vector types, which the compiler turns into SIMD instructions (SSE2, or AVX2 when built with CHESS_NATIVE on
+// a machine that has it). Attacks are worked out a set of pieces at a time, with shifts of the masks rather than a loop
+// over the pieces, so no step depends on what is on the board.
+void evaluateBatch(PositionBatch& batch, BatchFeatures& features);
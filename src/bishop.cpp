@@ -5,6 +5,7 @@
 
 #include "piece.hpp"
 #include "bishop.hpp"
+#include "instrument.hpp"
 
 
 Bishop::Bishop(PieceColor color) : Piece(color){}
@@ -16,7 +17,7 @@ Bishop::Bishop() : Piece(){}
 char Bishop::toChar(){ return (color==PieceColor::WHITE) ? 'B' : 'b'; }
 
 
-bool Bishop::isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
+bool Bishop::isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board){
     // BISHOP MOVE CONDITIONS: Can move by the same number of rows as columns e.g. (1,1), (3,3), if it's path is not blocked by another piece.
     std::array<int, 2> disp = displacement(start, dest);
     if (abs(disp[0]) == abs(disp[1])){ // Move is diagonal if absolute value of row (vertical) displacement = absolute value of column (horizontal) displacement
@@ -53,49 +54,52 @@ bool Bishop::isLegalMove(const Square& start, const Square& dest, const std::arr
 // Then we apply this same process, but along the topleft-bottomright axis
 // (i.e. starting i and j at topleftmost point on axis, then decrementing i while incrementing j to 
 // traverse the axis until we reach the other end of the board, when either i=0 or j=7)
-std::vector<Square> Bishop::legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board){
+std::vector<SquareIndex> Bishop::legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board){
+    CHESS_TIME(LEGAL_DESTS);
+    CHESS_COUNT(LEGAL_DESTS_BISHOP);
+    CHESS_COUNT_BY(VECTORS_ALLOCATED, 3);
     
     // 1ST (BOTTOMLEFT-TOPRIGHT) AXIS
-    std::vector<Square> dests1stAxis; // Legal destination squares on the 1st (bottomleft-topright) axis
+    std::vector<SquareIndex> dests1stAxis; // Legal destination squares on the 1st (bottomleft-topright) axis
 
     // Get bottom-left-most point on the bottomleft-topright axis
     // By getting the displacement array from the bottomleft square of the board to the start square,
     // then scalar subtracting the smaller component from the start square
     // we get the bottomleftmost square on the axis.
-    std::array<int, 2> dispFromBottomLeft = displacement(square(0, 0), start);
+    std::array<int, 2> dispFromBottomLeft = displacement(squareIndex(0, 0), start);
     int subtractor = std::min(dispFromBottomLeft[0], dispFromBottomLeft[1]);
-    Square bottomLeftOnAxis = square(start.row - subtractor, start.col - subtractor);
+    SquareIndex bottomLeftOnAxis = squareIndex(rankOf(start) - subtractor, fileOf(start) - subtractor);
 
     // Starting from bottomleft, iterate over axis until the other end of the board is reached
-    int i = bottomLeftOnAxis.row;
-    int j = bottomLeftOnAxis.col;
+    int i = rankOf(bottomLeftOnAxis);
+    int j = fileOf(bottomLeftOnAxis);
     while (i < 8 && j < 8){
 
         // If encounters non-empty square before reaching rook's position
-        if (board[i][j] != nullptr && i < start.row){
+        if (board[i][j] != nullptr && i < rankOf(start)){
             dests1stAxis.clear(); // Clear dests - Those squares are not valid dests if there is a piece between them and the start square
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
             if (board[i][j]->getColor() != color){
-                    dests1stAxis.push_back( square(i, j) );
+                    dests1stAxis.push_back( squareIndex(i, j) );
             }
         }
 
         // If encounters non-empty square after bishop's position
-        else if (board[i][j] != nullptr && i > start.row){
+        else if (board[i][j] != nullptr && i > rankOf(start)){
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
             if (board[i][j]->getColor() != color){
-                    dests1stAxis.push_back( square(i, j) );
+                    dests1stAxis.push_back( squareIndex(i, j) );
             }
             break; // Stop scanning - found all possible destinations on this column
         }
         
         // If i and j on an empty square
         else if (board[i][j] == nullptr){
-            dests1stAxis.push_back( square(i, j) );
+            dests1stAxis.push_back( squareIndex(i, j) );
         }
 
         i++;
@@ -103,48 +107,43 @@ std::vector<Square> Bishop::legalDests(const Square& start, const std::array<std
     }
 
     // 2ND (TOPLEFT-BOTTOMRIGHT) AXIS
-    std::vector<Square> dests2ndAxis; // Legal destination squares on the 2nd (topleft-bottomright) axis
-    // Get top-left-most point on the topleft-bottomright axis
-    // By iterating topleft-wards from start square until we reach the edge of the board i.e. when either i or j equals 0
-
-    // Get top-left-most point on the topleft-bottomright axis.
-    // By getting the displacement array from the topleft square of the board to the start square,
-    // then adding the component with the smaller absolute value to the start square's row 
-    // and subtracting it from the start square's column, we get the bottomleftmost square on the axis.
-    std::array<int, 2> dispFromTopLeft = displacement(square(7, 0), start);
-    int difference = ( abs(dispFromTopLeft[0]) < abs(dispFromTopLeft[1]) ) ? dispFromTopLeft[0] : dispFromTopLeft[1];
-    Square topLeftOnAxis = square(start.row + difference, start.col - difference);
+    std::vector<SquareIndex> dests2ndAxis; // Legal destination squares on the 2nd (topleft-bottomright) axis
+
+    // Get top-left-most point on the topleft-bottomright axis,
+    // by moving up and left from the start square until either the last row or the first column is reached.
+    int difference = std::min(7 - rankOf(start), fileOf(start));
+    SquareIndex topLeftOnAxis = squareIndex(rankOf(start) + difference, fileOf(start) - difference);
 
     // Starting from topleft, iterate over axis until the other end of the board is reached
-    i = topLeftOnAxis.row;
-    j = topLeftOnAxis.col;
+    i = rankOf(topLeftOnAxis);
+    j = fileOf(topLeftOnAxis);
     while (i >= 0 && j < 8){
 
         // If encounters non-empty square before reaching bishop's position
-        if (board[i][j] != nullptr && i > start.row){
+        if (board[i][j] != nullptr && i > rankOf(start)){
             dests2ndAxis.clear(); // Clear dests - Those squares are not valid dests if there is a piece between them and the start square
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
             if (board[i][j]->getColor() != color){
-                    dests2ndAxis.push_back( square(i, j) );
+                    dests2ndAxis.push_back( squareIndex(i, j) );
             }
         }
 
         // If encounters non-empty square after bishop's position
-        else if (board[i][j] != nullptr && i < start.row){
+        else if (board[i][j] != nullptr && i < rankOf(start)){
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
             if (board[i][j]->getColor() != color){
-                    dests2ndAxis.push_back( square(i, j) );
+                    dests2ndAxis.push_back( squareIndex(i, j) );
             }
             break; // Stop scanning - found all possible destinations on this column
         }
         
         // If i and j on an empty square
         else if (board[i][j] == nullptr){
-            dests2ndAxis.push_back( square(i, j) );
+            dests2ndAxis.push_back( squareIndex(i, j) );
         }
 
         i--;
@@ -152,25 +151,23 @@ std::vector<Square> Bishop::legalDests(const Square& start, const std::array<std
     }
 
     // Concatenate 1st and 2nd axes' destinations into single dests vector, then return
-    std::vector<Square> dests;
+    std::vector<SquareIndex> dests;
     dests.insert(dests.end(), dests1stAxis.begin(), dests1stAxis.end());
     dests.insert(dests.end(), dests2ndAxis.begin(), dests2ndAxis.end());
     return dests;
 }
 
 
-bool Bishop::isPathClear(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
-
-    std::array<int, 2> disp = displacement(start, dest);
+bool Bishop::isPathClear(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board){
 
-    bool incI = start.row < dest.row; // Whether to increment or decrement i to scan from start to dest
-    bool incJ = start.col < dest.col; // Whether to increment or decrement j to scan from start to dest
+    bool incI = rankOf(start) < rankOf(dest); // Whether to increment or decrement i to scan from start to dest
+    bool incJ = fileOf(start) < fileOf(dest); // Whether to increment or decrement j to scan from start to dest
 
-    int i = (incI) ? start.row+1 : start.row-1;
-    int j = (incJ) ? start.col+1 : start.col-1;
+    int i = (incI) ? rankOf(start)+1 : rankOf(start)-1;
+    int j = (incJ) ? fileOf(start)+1 : fileOf(start)-1;
 
     // Scan path from start to dest
-    while(i != dest.row && j != dest.col){
+    while(i != rankOf(dest) && j != fileOf(dest)){
         if ( board[i][j] != nullptr ){ // If piece encountered
             return false;
         }
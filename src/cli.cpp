@@ -0,0 +1,332 @@
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+
+#include "cli.hpp"
+#include "io.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "square.hpp"
+#include "piece.hpp"
+#include "move.hpp"
+#include "clock.hpp"
+#include "timeman.hpp"
+#include "search.hpp"
+#include "ponder.hpp"
+#include "render.hpp"
+
+
+static const std::string SEPARATOR = "-------------------------------------------------------------------------------------------------\n";
+
+// Valid user inputs, listed under the board
+static const std::string COMMANDS = "(m) move (cs) castle short (cl) castle long (r) resign (od) offer draw \n";
+
+// Depth the engine searches to in an untimed game
+static const int ENGINE_DEPTH = 4;
+
+
+// Thrown by readInput() when there is no more input, to end the game
+struct InputClosed{};
+
+
+// Writes prompt, then reads the next token of input
+static std::string readInput(GameIO& io, const std::string& prompt){
+    io.write(prompt);
+    std::string token;
+    if (!io.read(token)){
+        throw InputClosed();
+    }
+    return token;
+}
+
+
+// Tells the player their input was rejected. The turn's text then runs longer than usual, and may scroll a board drawn
+// in DIFF mode up the screen, so the next frame redraws it whole.
+static void rejectInput(GameIO& io, BoardRenderer& renderer, const std::string& message){
+    io.write(message);
+    renderer.invalidate();
+}
+
+
+// Reads square strings until a valid one is entered, and returns the corresponding square
+static Square readSquare(GameIO& io, BoardRenderer& renderer, const std::string& prompt){
+    std::string str = readInput(io, prompt);
+    while (!isValidSquareStr(str)){
+        rejectInput(io, renderer, "INVALID SQUARE. TRY AGAIN\n");
+        str = readInput(io, prompt);
+    }
+    return squareFromStr(str);
+}
+
+
+// Formats a time in milliseconds as minutes, seconds and tenths (e.g. "04:59.8")
+static std::string clockStr(int64_t ms){
+    ms = std::max<int64_t>(0, ms);
+    std::ostringstream out;
+    out << std::setfill('0') << std::setw(2) << ms / 60000 << ":" << std::setw(2) << (ms / 1000) % 60 << "." << (ms / 100) % 10;
+    return out.str();
+}
+
+
+// Everything the engine needs to play its moves: a searcher kept for the whole game, the time manager,
+// and the ponderer, which uses the searcher while the opposition is thinking.
+struct Engine{
+    Searcher searcher;
+    TimeManager timeManager;
+    Ponderer ponderer;
+
+    // Budget and result of the engine's last search
+    TimeManager::Budget budget;
+    SearchResult result;
+
+    Engine(const TimeControl& control) : timeManager(control), ponderer(searcher) {}
+};
+
+
+// Searches for the engine's move within its time budget (or to a fixed depth in an untimed game), and plays it
+static void playEngineMove(GameIO& io, Game& game, Engine& engine, ChessClock* clock, int moveNumber){
+    if (engine.ponderer.isPondering()){
+        engine.timeManager.recordPonder(engine.ponderer.stop(game));
+    }
+
+    SearchLimits limits;
+    if (clock != nullptr){
+        PieceColor color = game.getTurn()->getColor();
+        engine.budget = engine.timeManager.budget(clock->remainingMs(color), moveNumber);
+        limits.softTimeMs = engine.budget.softMs;
+        limits.timeMs = engine.budget.hardMs;
+    } else {
+        limits.depth = ENGINE_DEPTH;
+    }
+
+    engine.result = engine.searcher.search(game, limits);
+    const Move& m = engine.result.bestMove;
+    io.write("ENGINE PLAYS " + moveToStr(m) + "\n");
+    game.movePiece(m.start, m.dest, m.promotion);
+}
+
+
+// Runs the game loop until the game is over, drawing the board with renderer at the start of each turn.
+// Throws InputClosed if the input is closed before then.
+static void runGame(GameIO& io, BoardRenderer& renderer, Game& game, ChessClock* clock, Engine* engine, const CliOptions& options){
+    bool end = false;
+    int moveNumber = 1;
+
+    if (clock != nullptr){
+        clock->start(game.getTurn()->getColor());
+    }
+
+    // Game loop
+    while(!end){
+
+        GameState state = game.getGameState();
+
+        // If game is still to play for
+        if (state == GameState::CONTESTED){
+            std::string turnStr = SEPARATOR;
+            if (game.isCheck()){ turnStr += "CHECK\n"; } // Notify players if a check was given.
+            turnStr += "\n" + game.getTurn()->getColorStr() + "'S TURN\n";
+            if (clock != nullptr){
+                turnStr += "WHITE " + clockStr(clock->remainingMs(PieceColor::WHITE)) + "  BLACK " + clockStr(clock->remainingMs(PieceColor::BLACK)) + "\n";
+            }
+
+            // A DIFF frame leaves the cursor under the board, which stays at the top of the screen, so the turn's text follows it
+            if (options.diffBoard){
+                renderer.render(game, io);
+                io.write(turnStr + COMMANDS);
+            } else {
+                io.write(turnStr);
+                renderer.render(game, io);
+                io.write(COMMANDS);
+            }
+        }
+        // If the last turn has resulted in checkmate, stalemate or a draw
+        else {
+            if (state == GameState::CHECKMATE){ io.write("CHECKMATE - " + game.getTurn()->getOppColorStr() + " WINS\n"); }
+            else if (state == GameState::STALEMATE){ io.write("STALEMATE\n"); }
+            else if (state == GameState::INSUFFICIENT_MATERIAL){ io.write("DRAW BY INSUFFICIENT MATERIAL\n"); }
+            else if (state == GameState::THREEFOLD_REPETITION){ io.write("DRAW BY THREEFOLD REPETITION\n"); }
+            else if (state == GameState::FIFTY_MOVE_RULE){ io.write("DRAW BY FIFTY-MOVE RULE\n"); }
+            io.write(SEPARATOR);
+            end = true;
+            continue;
+        }
+
+        // The engine plays its move without any input
+        bool engineTurn = engine != nullptr && game.getTurn()->getColor() == options.engineColor;
+        if (engineTurn){
+            playEngineMove(io, game, *engine, clock, moveNumber);
+        }
+
+        // Tracks whether to switch turns from white to black or vice versa
+        // Will be initialized to false, set to true within the below loop at some stage, then be reset to false here when the next turn begins
+        bool turnChange = engineTurn;
+        while (!turnChange) {
+
+            std::string input = readInput(io, "> ");
+
+            // Resign
+            if (input == "r"){
+                io.write(game.getTurn()->getColorStr() + " RESIGNS - " + game.getTurn()->getOppColorStr() + " WINS\n" + SEPARATOR);
+                turnChange = true;
+                end = true;
+            }
+
+            // Offer draw
+            else if (input == "od"){
+
+                io.write(game.getTurn()->getColorStr() + " OFFERS A DRAW\n");
+                std::string resp;
+                do {
+                    resp = readInput(io, game.getTurn()->getOppColorStr() + ", TYPE (y) TO ACCEPT AND (n) TO DECLINE: ");
+                } while(resp != "y" && resp != "n");
+
+                if (resp == "y"){
+                    io.write("DRAW\n" + SEPARATOR);
+                    turnChange = true;
+                    end = true;
+                } else {
+                    rejectInput(io, renderer, "DRAW DECLINED, GAME CONTINUES.\n");
+                }
+            }
+
+            // Regular move
+            else if (input == "m"){
+
+                bool legal; // Will hold the bool returned by game.isValidMove() and thus will validate moves.
+                do {
+
+                    // Get starting square (square on which piece to move is located), and destination square.
+                    Square start = readSquare(io, renderer, "START SQUARE: ");
+                    Square dest = readSquare(io, renderer, "DESTINATION SQUARE: ");
+
+                    legal = game.isValidMove(start, dest);
+
+                    if (legal){
+
+                        // If a pawn is being promoted, ask which piece to promote to
+                        char promoteTo = '\0';
+                        if (game.isPromotion(start, dest)){
+                            std::string choice;
+                            do {
+                                choice = readInput(io, "PROMOTE TO: QUEEN (q)  ROOK (r)  BISHOP (b)  KNIGHT (n)\n> ");
+                                io.write("\n");
+                                if (choice != "q" && choice != "r" && choice != "b" && choice != "n"){
+                                    renderer.invalidate(); // As rejectInput(), for the prompt shown again
+                                }
+                            } while (choice != "q" && choice != "r" && choice != "b" && choice != "n");
+                            promoteTo = choice[0];
+                        }
+
+                        game.movePiece(start, dest, promoteTo);
+                        turnChange = true;
+                    } else {
+                        rejectInput(io, renderer, "ILLEGAL MOVE. TRY AGAIN\n");
+                    }
+
+                } while (!legal); // Repeat move process until user inputs a legal move
+            }
+
+            // Castling kingside/short
+            else if (input == "cs"){
+                if (game.shortCastleIsLegal()){
+                    game.shortCastle();
+                    turnChange = true;
+                }
+                else {
+                    rejectInput(io, renderer, "CAN'T CASTLE SHORT HERE\n");
+                }
+            }
+
+            // Castling queenside/long
+            else if (input == "cl"){
+                if (game.longCastleIsLegal()){
+                    game.longCastle();
+                    turnChange = true;
+                }
+                else {
+                    rejectInput(io, renderer, "CAN'T CASTLE LONG HERE\n");
+                }
+            }
+
+            // Unrecognized input
+            else {
+                rejectInput(io, renderer, "INVALID INPUT. TRY AGAIN\n");
+            }
+
+            io.write("\n");
+
+        }
+
+        if (end){
+            continue;
+        }
+
+        // Stop the mover's clock. They lose if their time ran out before they moved.
+        if (clock != nullptr){
+            int64_t micros = clock->press();
+            if (engineTurn){
+                engine->timeManager.recordMove(micros, engine->budget);
+            }
+            if (clock->flagFell(game.getTurn()->getColor())){
+                io.write(game.getTurn()->getColorStr() + " LOSES ON TIME - " + game.getTurn()->getOppColorStr() + " WINS\n" + SEPARATOR);
+                end = true;
+                continue;
+            }
+        }
+
+        if (game.getTurn()->getColor() == PieceColor::BLACK){
+            moveNumber++;
+        }
+        game.toggleTurn();
+
+        // Think on the opposition's time, about the reply the engine expects
+        if (engineTurn && options.ponder && engine->result.pv.size() >= 2){
+            engine->ponderer.start(game, engine->result.pv[1]);
+        }
+    }
+}
+
+
+// One renderer draws every frame of the game, so its buffer is only allocated once. In DIFF mode, the board is drawn
+// before the title, as its first frame clears the screen.
+void playCli(GameIO& io, const CliOptions& options){
+    Player white(PieceColor::WHITE);
+    Player black(PieceColor::BLACK);
+    std::unique_ptr<Game> gamePtr(options.chess960Position >= 0 ? new Game(&white, &black, options.chess960Position) : new Game(&white, &black));
+    Game& game = *gamePtr;
+
+    BoardRenderer renderer(options.diffBoard ? BoardRenderer::Mode::DIFF : BoardRenderer::Mode::FULL);
+    if (options.diffBoard){
+        renderer.render(game, io);
+    }
+    io.write(SEPARATOR + "CHESS\n" + SEPARATOR);
+    if (game.isChess960()){
+        io.write("CHESS960 POSITION " + std::to_string(options.chess960Position) + ". TO CASTLE WITH (m), MOVE THE KING ONTO THE ROOK\n");
+    }
+
+    std::unique_ptr<ChessClock> clock;
+    if (options.timed){
+        clock.reset(new ChessClock(options.timeControl));
+    }
+    std::unique_ptr<Engine> engine;
+    if (options.engine){
+        engine.reset(new Engine(options.timeControl));
+    }
+
+    try {
+        runGame(io, renderer, game, clock.get(), engine.get(), options);
+    } catch (const InputClosed&){
+        // Players have left - abandon the game
+    }
+
+    if (engine){
+        engine->ponderer.stop(game);
+        if (clock){
+            std::ostringstream report;
+            engine->timeManager.writeReport(report);
+            io.write(report.str());
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "io.hpp"
+#include "clock.hpp"
+#include "piece.hpp"
+
+#pragma once
+
+
+struct CliOptions{
+
+    // Play with clocks, under timeControl
+    bool timed = false;
+    TimeControl timeControl;
+
+    // One of the players is the engine, playing engineColor
+    bool engine = false;
+    PieceColor engineColor = PieceColor::BLACK;
+
+    // The engine thinks on its opponent's time
+    bool ponder = true;
+
+    // Chess960 starting position (see Game), or -1 for standard chess
+    int chess960Position = -1;
+
+    // Keep the board at the top of the screen and redraw only the squares that change (BoardRenderer's DIFF mode),
+    // e.g. for a spectator's terminal, rather than drawing the whole board each turn
+    bool diffBoard = false;
+};
+
+
+// Plays a 2-player game from the starting position (or a Chess960 one), taking the players' commands through io and
+// displaying the board and messages through it. Returns once the game is over, or the input has been closed.
+//
+// In a timed game, a player whose time has run out loses as soon as they make their move
+// (input is read without a timeout, so a player who never moves is never flagged).
+// When the engine plays, a report of its time-to-move latencies is written at the end of the game.
+void playCli(GameIO& io, const CliOptions& options = CliOptions());
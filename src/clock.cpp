@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+#include "clock.hpp"
+#include "piece.hpp"
+
+
+static int colorIndex(PieceColor color){
+    return (color == PieceColor::WHITE) ? 0 : 1;
+}
+
+
+ChessClock::ChessClock(const TimeControl& control) : control(control) {
+    remainingMicros[0] = control.baseMs * 1000;
+    remainingMicros[1] = control.baseMs * 1000;
+    running = false;
+    runningColor = PieceColor::WHITE;
+}
+
+
+void ChessClock::start(PieceColor toMove){
+    running = true;
+    runningColor = toMove;
+    moveStart = Clock::now();
+}
+
+
+int64_t ChessClock::charge(int64_t elapsedMicros){
+    return std::max<int64_t>(0, elapsedMicros - control.delayMs * 1000);
+}
+
+
+int64_t ChessClock::press(){
+    Clock::time_point now = Clock::now();
+    if (!running){
+        return 0;
+    }
+
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - moveStart).count();
+    int64_t& remaining = remainingMicros[colorIndex(runningColor)];
+    remaining -= charge(elapsed);
+    if (remaining > 0){
+        remaining += control.incrementMs * 1000;
+    }
+
+    runningColor = (runningColor == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+    moveStart = now;
+    return elapsed;
+}
+
+
+void ChessClock::stop(){
+    if (!running){
+        return;
+    }
+    remainingMicros[colorIndex(runningColor)] -= charge(moveElapsedMicros());
+    running = false;
+}
+
+
+int64_t ChessClock::remainingMs(PieceColor color){
+    int64_t remaining = remainingMicros[colorIndex(color)];
+    if (running && color == runningColor){
+        remaining -= charge(moveElapsedMicros());
+    }
+    return (remaining >= 0) ? remaining / 1000 : -((-remaining + 999) / 1000);
+}
+
+
+bool ChessClock::flagFell(PieceColor color){
+    int64_t remaining = remainingMicros[colorIndex(color)];
+    if (running && color == runningColor){
+        remaining -= charge(moveElapsedMicros());
+    }
+    return remaining <= 0;
+}
+
+
+int64_t ChessClock::moveElapsedMicros(){
+    if (!running){
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - moveStart).count();
+}
+
+
+PieceColor ChessClock::getRunning(){
+    return runningColor;
+}
+
+
+bool ChessClock::isRunning(){
+    return running;
+}
+
+
+const TimeControl& ChessClock::getTimeControl(){
+    return control;
+}
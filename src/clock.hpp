@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdint>
+
+#include "piece.hpp"
+
+#pragma once
+
+
+// Time control of a game. Times are in milliseconds.
+struct TimeControl{
+    int64_t baseMs = 0;      // Each player's time at the start of the game
+    int64_t incrementMs = 0; // Added to a player's time after each of their moves (Fischer increment)
+    int64_t delayMs = 0;     // A player's time only starts running this long into each of their moves (simple delay)
+};
+
+
+// A pair of game clocks. Only the clock of the player whose turn it is runs.
+// Time is measured with a monotonic clock to the microsecond, so it isn't affected by changes to the system time.
+class ChessClock{
+
+    public:
+
+        ChessClock(const TimeControl& control);
+
+        // Starts the clock of the player to move
+        void start(PieceColor toMove);
+
+        // Ends the move of the player whose clock is running: charges them for the time taken (less the delay),
+        // adds the increment if their time hasn't run out, and starts the opposition's clock.
+        // Returns the time taken for the move, in microseconds.
+        int64_t press();
+
+        // Stops both clocks, charging the player whose clock was running for their time so far
+        void stop();
+
+        // Time the player has left, in milliseconds, as of now. Negative once their time has run out.
+        int64_t remainingMs(PieceColor color);
+
+        // Determines if the player's time has run out
+        bool flagFell(PieceColor color);
+
+        // Time taken so far by the player whose clock is running on their current move, in microseconds (0 if neither is)
+        int64_t moveElapsedMicros();
+
+        // Returns the color of the player whose clock is running. Only meaningful if isRunning().
+        PieceColor getRunning();
+
+        bool isRunning();
+
+        const TimeControl& getTimeControl();
+
+    private:
+
+        typedef std::chrono::steady_clock Clock;
+
+        // Time charged for a move that has taken elapsedMicros so far
+        int64_t charge(int64_t elapsedMicros);
+
+        TimeControl control;
+
+        // Each player's time left (indexed by PieceColor) at the start of their current or next move, in microseconds
+        int64_t remainingMicros[2];
+
+        bool running;
+
+        PieceColor runningColor;
+
+        // When the running clock's current move started
+        Clock::time_point moveStart;
+};
@@ -0,0 +1,315 @@
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <istream>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "datagen.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+#include "movepick.hpp"
+#include "search.hpp"
+#include "packedgame.hpp"
+#include "pgn.hpp"
+
+
+static void storeLE(uint8_t* out, uint32_t value, int bytes){
+    for (int b = 0; b < bytes; b++){
+        out[b] = (value >> (8 * b)) & 0xFF;
+    }
+}
+
+
+static uint32_t loadLE(const uint8_t* in, int bytes){
+    uint32_t value = 0;
+    for (int b = 0; b < bytes; b++){
+        value |= (uint32_t)in[b] << (8 * b);
+    }
+    return value;
+}
+
+
+void encodeRecord(const TrainingRecord& record, uint8_t* out){
+    std::copy(record.squares.begin(), record.squares.end(), out);
+    out[32] = record.flags;
+    out[33] = (uint8_t)record.enPassantFile;
+    out[34] = record.halfmoveClock;
+    out[35] = (uint8_t)record.result;
+    storeLE(out + 36, (uint16_t)record.score, 2);
+    storeLE(out + 38, record.bestMove, 2);
+}
+
+
+TrainingRecord decodeRecord(const uint8_t* in){
+    TrainingRecord record;
+    std::copy(in, in + 32, record.squares.begin());
+    record.flags = in[32];
+    record.enPassantFile = (int8_t)in[33];
+    record.halfmoveClock = in[34];
+    record.result = (GameResult)in[35];
+    record.score = (int16_t)loadLE(in + 36, 2);
+    record.bestMove = loadLE(in + 38, 2);
+    return record;
+}
+
+
+bool readTrainingHeader(std::istream& in){
+    char magic[4];
+    return in.read(magic, 4) && std::string(magic, 4) == "CTD1";
+}
+
+
+bool readTrainingRecord(std::istream& in, TrainingRecord& record){
+    uint8_t bytes[TRAINING_RECORD_BYTES];
+    if (!in.read((char*)bytes, TRAINING_RECORD_BYTES)){
+        return false;
+    }
+    record = decodeRecord(bytes);
+    return true;
+}
+
+
+std::string recordToFen(const TrainingRecord& record){
+    PackedGame packed;
+    packed.squares = record.squares;
+    packed.flags = record.flags;
+    packed.enPassantFile = record.enPassantFile;
+    packed.halfmoveClock = record.halfmoveClock;
+    packed.fullmoveNumber = 1;
+    packed.state = GameState::CONTESTED;
+    return unpackToFen(packed);
+}
+
+
+DataGenerator::DataGenerator(const DataGenConfig& config) : config(config), seen((size_t)1 << config.dedupBits), failed(false), written(0) {
+    producersDone = false;
+}
+
+
+DataGenStats DataGenerator::getStats(){
+    return stats;
+}
+
+
+// Games are handed out to the workers one at a time through a shared counter, as in SelfPlayRunner.
+// Each worker keeps one buffer, which it hands to the writer whenever it fills up, and once more when it runs out of games.
+bool DataGenerator::run(){
+    std::ofstream out(config.outPath, std::ios::binary);
+    if (!out || !out.write("CTD1", 4)){
+        return false;
+    }
+    for (auto& slot: seen){
+        slot.store(0, std::memory_order_relaxed);
+    }
+    stats = DataGenStats();
+    producersDone = false;
+    failed = false;
+    written = 0;
+
+    std::atomic<int> nextGame(0);
+    std::mutex statsMutex;
+    auto worker = [&](){
+        Searcher searcher(config.searchOptions);
+        std::vector<uint8_t> buffer;
+        buffer.reserve(config.bufferRecords * TRAINING_RECORD_BYTES);
+        ThreadStats threadStats;
+        while (!failed){
+            int i = nextGame++;
+            if (i >= config.numGames){
+                break;
+            }
+            playGame(i, searcher, buffer, threadStats);
+        }
+        if (!buffer.empty()){
+            submit(buffer);
+        }
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.unfinishedGames += threadStats.unfinishedGames;
+        stats.positions += threadStats.positions;
+        stats.skippedInCheck += threadStats.skippedInCheck;
+        stats.skippedCaptures += threadStats.skippedCaptures;
+        stats.duplicates += threadStats.duplicates;
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::thread writer([&](){ writerLoop(out); });
+    int numThreads = std::max(1, config.numThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; t++){
+        workers.push_back(std::thread(worker));
+    }
+    for (auto& w: workers){
+        w.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        producersDone = true;
+    }
+    queueChanged.notify_all();
+    writer.join();
+    out.flush();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    stats.seconds = elapsed.count();
+    stats.games = std::min(nextGame.load(), config.numGames);
+    stats.records = written;
+    return !failed && (bool)out;
+}
+
+
+// The game is played to the end before its records are added to the buffer, as they all need its result,
+// and are checked for duplicates then.
+// The search's score is for the player to move, and is recorded as it is (capped, for forced mates).
+void DataGenerator::playGame(int gameIndex, Searcher& searcher, std::vector<uint8_t>& buffer, ThreadStats& threadStats){
+    Player white(PieceColor::WHITE);
+    Player black(PieceColor::BLACK);
+    Game game(&white, &black);
+    Position start = game.snapshot();
+    searcher.clear(); // So the game is the same whichever thread plays it, and whatever it played before
+
+    std::mt19937_64 rng(config.seed + gameIndex);
+    while (!playOpening(game, rng)){
+        game.restore(start);
+    }
+
+    std::vector<TrainingRecord> records;
+    std::vector<uint64_t> hashes; // Of the records' positions
+    GameResult result = GameResult::UNFINISHED;
+    for (int ply = config.randomPlies; ; ply++){
+        GameState state = game.getGameState();
+        if (state == GameState::CHECKMATE){
+            result = (game.getTurn() == &white) ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
+            break;
+        }
+        if (state != GameState::CONTESTED){
+            result = GameResult::DRAW;
+            break;
+        }
+        if (ply >= config.maxPlies){
+            break;
+        }
+
+        SearchResult searched = searcher.search(game, config.limits);
+        threadStats.positions++;
+
+        if (config.skipInCheck && game.isCheck()){
+            threadStats.skippedInCheck++;
+        } else if (config.skipCaptures && isCaptureOrPromotion(game, searched.bestMove)){
+            threadStats.skippedCaptures++;
+        } else {
+            PackedGame packed = packPosition(game.snapshot());
+            TrainingRecord record;
+            record.squares = packed.squares;
+            record.flags = packed.flags;
+            record.enPassantFile = packed.enPassantFile;
+            record.halfmoveClock = packed.halfmoveClock;
+            record.score = std::max(-MAX_RECORD_SCORE, std::min(MAX_RECORD_SCORE, searched.score));
+            record.bestMove = packMove(searched.bestMove);
+            records.push_back(record);
+            hashes.push_back(game.getHash());
+        }
+
+        game.makeMove(searched.bestMove);
+    }
+
+    if (result == GameResult::UNFINISHED){
+        threadStats.unfinishedGames++;
+        return;
+    }
+
+    // Positions are only marked as recorded once they are, so those of an unfinished game can still be recorded from another
+    for (size_t r = 0; r < records.size(); r++){
+        if (seenBefore(hashes[r])){
+            threadStats.duplicates++;
+            continue;
+        }
+        TrainingRecord& record = records[r];
+        record.result = result;
+        buffer.resize(buffer.size() + TRAINING_RECORD_BYTES);
+        encodeRecord(record, buffer.data() + buffer.size() - TRAINING_RECORD_BYTES);
+        if (buffer.size() >= config.bufferRecords * TRAINING_RECORD_BYTES){
+            submit(buffer);
+        }
+    }
+}
+
+
+bool DataGenerator::playOpening(Game& game, std::mt19937_64& rng){
+    for (int ply = 0; ply < config.randomPlies; ply++){
+        std::vector<Move> moves = game.legalMoves();
+        if (moves.empty()){
+            return false;
+        }
+        game.makeMove(moves[rng() % moves.size()]);
+    }
+    return game.getGameState() == GameState::CONTESTED;
+}
+
+
+// Slot chosen by the top bits of the hash. Two threads racing on the same new position may both record it, which is
+// no worse than the table forgetting it.
+bool DataGenerator::seenBefore(uint64_t hash){
+    std::atomic<uint64_t>& slot = seen[hash >> (64 - config.dedupBits)];
+    if (slot.load(std::memory_order_relaxed) == hash){
+        return true;
+    }
+    slot.store(hash, std::memory_order_relaxed);
+    return false;
+}
+
+
+void DataGenerator::submit(std::vector<uint8_t>& buffer){
+    std::vector<uint8_t> full;
+    full.reserve(config.bufferRecords * TRAINING_RECORD_BYTES);
+    full.swap(buffer);
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueChanged.wait(lock, [&](){ return queue.size() < std::max<size_t>(1, config.maxPendingBuffers) || failed; });
+        if (failed){
+            return; // Nothing more will be written
+        }
+        queue.push_back(std::move(full));
+    }
+    queueChanged.notify_all();
+}
+
+
+// Writes buffers in the order they were queued, one write (and flush) each, until every worker has finished and the queue is empty.
+// A failed write stops the run: workers waiting to queue a buffer are released, and start no new games.
+void DataGenerator::writerLoop(std::ostream& out){
+    while (true){
+        std::vector<uint8_t> buffer;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [&](){ return !queue.empty() || producersDone; });
+            if (queue.empty()){
+                return;
+            }
+            buffer = std::move(queue.front());
+            queue.pop_front();
+        }
+        queueChanged.notify_all();
+
+        if (!failed && !out.write((const char*)buffer.data(), buffer.size()).flush()){
+            std::lock_guard<std::mutex> lock(queueMutex);
+            failed = true;
+            queueChanged.notify_all();
+        }
+        if (!failed){
+            written += buffer.size() / TRAINING_RECORD_BYTES;
+        }
+    }
+}
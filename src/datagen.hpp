@@ -0,0 +1,157 @@
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <istream>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+
+#include "game.hpp"
+#include "move.hpp"
+#include "search.hpp"
+#include "pgn.hpp"
+
+#pragma once
+
+
+// A position from a self-play game, labelled with the search's score and move and with the game's result,
+// for training an evaluation.
+struct TrainingRecord{
+    std::array<uint8_t, 32> squares; // As PackedGame::squares: 4 bits per square
+    uint8_t flags;                   // As PackedGame::flags: bit 0 black to move, bits 1-4 castling rights K, Q, k, q
+    int8_t enPassantFile;            // -1 if there is none
+    uint8_t halfmoveClock;
+    GameResult result;               // WHITE_WINS, BLACK_WINS or DRAW
+    int16_t score;                   // In centipawns, for the player to move; forced mates are capped at +/- MAX_RECORD_SCORE
+    uint16_t bestMove;               // The search's move, packed by packMove()
+};
+
+
+// Binary format of a training data file (all integers little-endian): "CTD1" magic, then records of
+// TRAINING_RECORD_BYTES bytes each until the end of the file, laid out as:
+//   bytes 0-31 squares, 32 flags, 33 enPassantFile, 34 halfmoveClock, 35 result (as GameResult), 36-37 score, 38-39 bestMove
+// There is no record count, so the file can be written as the records come in, and a file cut short loses only its last record.
+const size_t TRAINING_RECORD_BYTES = 40;
+
+const int MAX_RECORD_SCORE = 32000;
+
+void encodeRecord(const TrainingRecord& record, uint8_t* out);
+TrainingRecord decodeRecord(const uint8_t* in);
+
+// Reads the magic at the start of a training data file. Returns false if it isn't one.
+bool readTrainingHeader(std::istream& in);
+
+// Reads the next record. Returns false at the end of the file.
+bool readTrainingRecord(std::istream& in, TrainingRecord& record);
+
+// The record's position as a FEN string (with fullmove number 1, as the record doesn't keep it)
+std::string recordToFen(const TrainingRecord& record);
+
+
+struct DataGenConfig{
+    int numGames = 1000;
+    int numThreads = 1;
+
+    // Game i starts with randomPlies moves picked uniformly at random by a generator seeded with seed + i,
+    // so that games differ; the positions during them aren't recorded
+    uint64_t seed = 1;
+    int randomPlies = 8;
+
+    // Games still going after this many plies are stopped, and their positions thrown away, as they have no result
+    int maxPlies = 400;
+
+    // Search picking each move (after the random ones), and scoring the position it is played in
+    SearchOptions searchOptions;
+    SearchLimits limits;
+
+    // Sampling filter: positions in which the player to move is in check, or in which the search's move is a capture
+    // or promotion, are not recorded, as their static score is a poor guide to what the search finds
+    bool skipInCheck = true;
+    bool skipCaptures = true;
+
+    // Positions already recorded are skipped, by their hash, looked up in a table of 2^dedupBits hashes shared by
+    // the threads. A slot holds the last hash to land in it, so the table forgets positions once it fills up.
+    int dedupBits = 22;
+
+    // Each thread hands its records to the writer in buffers of this many, and waits if maxPendingBuffers are already
+    // waiting to be written, so memory stays bounded however far the disk falls behind
+    size_t bufferRecords = 8192;
+    size_t maxPendingBuffers = 16;
+
+    std::string outPath;
+};
+
+
+struct DataGenStats{
+    uint64_t games = 0;
+    uint64_t unfinishedGames = 0; // Stopped at maxPlies
+    uint64_t positions = 0;       // Positions searched
+    uint64_t records = 0;         // Written
+    uint64_t skippedInCheck = 0;
+    uint64_t skippedCaptures = 0;
+    uint64_t duplicates = 0;
+    double seconds = 0;
+};
+
+
+// Plays self-play games on a pool of threads, one Searcher per thread, and streams the positions that pass the
+// sampling filter to a file as they are labelled. A game's records are only handed to the writer once it is over
+// (when its result is known); a single writer thread does all the writes.
+class DataGenerator{
+
+    public:
+
+        DataGenerator(const DataGenConfig& config);
+
+        // Plays all the games and writes the records. Returns false if the output file couldn't be written,
+        // in which case the run stops early.
+        bool run();
+
+        DataGenStats getStats();
+
+    private:
+
+        // Statistics kept by each thread and added up at the end
+        struct ThreadStats{
+            uint64_t unfinishedGames = 0;
+            uint64_t positions = 0;
+            uint64_t skippedInCheck = 0;
+            uint64_t skippedCaptures = 0;
+            uint64_t duplicates = 0;
+        };
+
+        // Plays the game with the given index, adding the records of its positions to buffer (which is handed to the
+        // writer whenever it fills up)
+        void playGame(int gameIndex, Searcher& searcher, std::vector<uint8_t>& buffer, ThreadStats& stats);
+
+        // Makes the random opening moves. Returns false if the game ended during them.
+        bool playOpening(Game& game, std::mt19937_64& rng);
+
+        // True if the position has been recorded before (as far as the table remembers), and marks it as recorded
+        bool seenBefore(uint64_t hash);
+
+        // Queues a full buffer for the writer, waiting while the queue is full, and leaves buffer empty
+        void submit(std::vector<uint8_t>& buffer);
+
+        void writerLoop(std::ostream& out);
+
+        DataGenConfig config;
+
+        DataGenStats stats;
+
+        std::vector<std::atomic<uint64_t>> seen;
+
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        std::deque<std::vector<uint8_t>> queue;
+        bool producersDone; // Set once every game is over, so the writer stops when the queue is empty
+
+        // Set if a write fails, after which no new games are started
+        std::atomic<bool> failed;
+
+        std::atomic<uint64_t> written;
+};
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+#include "datagen.hpp"
+#include "search.hpp"
+#include "move.hpp"
+#include "pgn.hpp"
+
+
+// Generates training data for the evaluation: plays self-play games from random openings, searching every position
+// after the opening, and streams the positions that pass the sampling filter to a binary file (see datagen.hpp),
+// labelled with the search's score and move and the game's result. Prints a summary when done.
+// With --dump, prints the records of an existing file as text instead, one per line: FEN, score, move and result.
+//
+// Usage: chess_datagen --out FILE [options]
+//   --games N             number of games to play (default 1000)
+//   --threads N           number of worker threads (default: number of hardware threads)
+//   --seed N              base seed for the random openings (default 1)
+//   --random-plies N      random moves at the start of each game (default 8)
+//   --max-plies N         stop games after N plies, throwing their positions away (default 400)
+//   --nodes N             node limit per position (default 5000, unless --time or --depth is given)
+//   --time MS             time limit per position, in milliseconds
+//   --depth N             depth limit per position
+//   --hash BITS           size of each thread's transposition table, as a power of 2 entries (default 16)
+//   --dedup BITS          size of the table of positions already recorded, as a power of 2 entries (default 22)
+//   --buffer N            records per buffer handed to the writer (default 8192)
+//   --skip-checks on|off  skip positions in which the player to move is in check (default on)
+//   --skip-captures on|off
+//                         skip positions in which the search's move is a capture or promotion (default on)
+//   --dump FILE           print the records in FILE as text
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_datagen --out FILE [--games N] [--threads N] [--seed N] [--random-plies N] [--max-plies N] "
+              << "[--nodes N] [--time MS] [--depth N] [--hash BITS] [--dedup BITS] [--buffer N] [--skip-checks on|off] "
+              << "[--skip-captures on|off]" << std::endl;
+    std::cerr << "       chess_datagen --dump FILE" << std::endl;
+}
+
+
+int dump(const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    if (!in || !readTrainingHeader(in)){
+        std::cerr << "ERROR: " << path << " IS NOT A TRAINING DATA FILE" << std::endl;
+        return 1;
+    }
+    TrainingRecord record;
+    while (readTrainingRecord(in, record)){
+        std::cout << recordToFen(record) << " | " << record.score << " | " << moveToStr(unpackMove(record.bestMove))
+                  << " | " << resultToStr(record.result) << std::endl;
+    }
+    return 0;
+}
+
+
+int main(int argc, char* argv[]){
+    DataGenConfig config;
+    config.numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::string dumpPath;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--out"){ config.outPath = value; }
+        else if (arg == "--games"){ config.numGames = std::max(0, atoi(value.c_str())); }
+        else if (arg == "--threads"){ config.numThreads = std::max(1, atoi(value.c_str())); }
+        else if (arg == "--seed"){ config.seed = strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--random-plies"){ config.randomPlies = std::max(0, atoi(value.c_str())); }
+        else if (arg == "--max-plies"){ config.maxPlies = std::max(1, atoi(value.c_str())); }
+        else if (arg == "--nodes"){ config.limits.nodes = strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--time"){ config.limits.timeMs = atoll(value.c_str()); }
+        else if (arg == "--depth"){ config.limits.depth = std::min(MAX_PLY - 1, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--hash"){ config.searchOptions.hashBits = std::min(30, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--dedup"){ config.dedupBits = std::min(32, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--buffer"){ config.bufferRecords = std::max<size_t>(1, strtoull(value.c_str(), nullptr, 10)); }
+        else if (arg == "--skip-checks" && (value == "on" || value == "off")){ config.skipInCheck = value == "on"; }
+        else if (arg == "--skip-captures" && (value == "on" || value == "off")){ config.skipCaptures = value == "on"; }
+        else if (arg == "--dump"){ dumpPath = value; }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (!dumpPath.empty()){
+        return dump(dumpPath);
+    }
+    if (config.outPath.empty()){
+        printUsage();
+        return 1;
+    }
+    if (config.limits.timeMs == 0 && config.limits.nodes == 0 && config.limits.depth == MAX_PLY - 1){
+        config.limits.nodes = 5000;
+    }
+
+    DataGenerator generator(config);
+    bool ok = generator.run();
+    DataGenStats stats = generator.getStats();
+
+    std::cout << "GAMES: " << stats.games << "  UNFINISHED: " << stats.unfinishedGames << " (THREADS: " << config.numThreads << ")" << std::endl;
+    std::cout << "POSITIONS SEARCHED: " << stats.positions << "  RECORDS: " << stats.records << "  SKIPPED IN CHECK: " << stats.skippedInCheck
+              << "  SKIPPED CAPTURES: " << stats.skippedCaptures << "  DUPLICATES: " << stats.duplicates << std::endl;
+    std::cout << "BYTES: " << 4 + stats.records * TRAINING_RECORD_BYTES << std::endl;
+    std::cout << "TIME: " << stats.seconds << " s" << std::endl;
+    std::cout << "RECORDS/S: " << (long)((stats.seconds > 0) ? stats.records / stats.seconds : 0) << std::endl;
+    if (!ok){
+        std::cerr << "ERROR: FAILED TO WRITE " << config.outPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <ostream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "epd.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+#include "search.hpp"
+#include "pgn.hpp"
+
+
+// Splits an operation into its opcode and operands. A quoted operand (e.g. an id) is kept whole, without the quotes.
+static std::vector<std::string> splitOperation(const std::string& operation){
+    std::vector<std::string> tokens;
+    std::string token;
+    bool quoted = false, inToken = false;
+    for (char c: operation){
+        if (c == '"'){
+            quoted = !quoted;
+            inToken = true;
+        } else if (isspace(c) && !quoted){
+            if (inToken){
+                tokens.push_back(token);
+            }
+            token.clear();
+            inToken = false;
+        } else {
+            token += c;
+            inToken = true;
+        }
+    }
+    if (inToken){
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+
+// The first 4 fields are the FEN's, and the rest of the line is operations, each ended by a semicolon (outside quotes)
+bool parseEpd(const std::string& line, EpdPosition& position){
+    std::istringstream stream(line);
+    std::string fields[4];
+    for (auto& field: fields){
+        if (!(stream >> field)){
+            return false;
+        }
+    }
+    std::string rest;
+    std::getline(stream, rest);
+
+    std::string halfmoveClock = "0", fullmoveNumber = "1";
+    position.id.clear();
+    position.bestMoves.clear();
+    position.avoidMoves.clear();
+
+    std::string operation;
+    bool quoted = false;
+    for (char c: rest + ";"){
+        if (c == '"'){
+            quoted = !quoted;
+        }
+        if (c != ';' || quoted){
+            operation += c;
+            continue;
+        }
+        std::vector<std::string> tokens = splitOperation(operation);
+        operation.clear();
+        if (tokens.empty()){
+            continue;
+        }
+        std::vector<std::string> operands(tokens.begin() + 1, tokens.end());
+        if (tokens[0] == "bm"){ position.bestMoves = operands; }
+        else if (tokens[0] == "am"){ position.avoidMoves = operands; }
+        else if (tokens[0] == "id" && !operands.empty()){ position.id = operands[0]; }
+        else if (tokens[0] == "hmvc" && !operands.empty()){ halfmoveClock = std::to_string(atoi(operands[0].c_str())); }
+        else if (tokens[0] == "fmvn" && !operands.empty()){ fullmoveNumber = std::to_string(std::max(1, atoi(operands[0].c_str()))); }
+    }
+
+    position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] + " " + halfmoveClock + " " + fullmoveNumber;
+    return Game::isValidFen(position.fen);
+}
+
+
+EpdRunner::EpdRunner(const EpdConfig& config) : config(config) {
+    elapsedSeconds = 0;
+}
+
+
+// Positions are handed out to the workers one at a time through a shared counter, as some take much longer than others
+std::vector<EpdResult> EpdRunner::run(const std::vector<EpdPosition>& positions){
+    std::vector<EpdResult> results(positions.size());
+    std::atomic<size_t> nextPosition(0);
+
+    auto worker = [&](){
+        Searcher searcher(config.searchOptions);
+        while (true){
+            size_t i = nextPosition++;
+            if (i >= positions.size()){
+                break;
+            }
+            results[i] = analyse(searcher, positions[i]);
+        }
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    int numThreads = std::max(1, config.numThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; t++){
+        workers.push_back(std::thread(worker));
+    }
+    for (auto& w: workers){
+        w.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    elapsedSeconds = elapsed.count();
+    return results;
+}
+
+
+double EpdRunner::getElapsedSeconds(){
+    return elapsedSeconds;
+}
+
+
+// Returns the moves in SAN, played from the game's current position. The game is left in the position it was in.
+static std::vector<std::string> toSan(Game& game, const std::vector<Move>& moves){
+    std::vector<std::string> san;
+    for (auto& m: moves){
+        san.push_back(moveToSan(game, m));
+        game.makeMove(m);
+    }
+    for (size_t i = 0; i < moves.size(); i++){
+        game.unmakeMove();
+    }
+    return san;
+}
+
+
+// The search for the first line reports each completed iteration, so the time to solve is when the best move last
+// changed to a solving move (the search may find the solution, then lose it, then find it again).
+// Each position starts with an empty transposition table, so its result doesn't depend on which positions the worker had before.
+EpdResult EpdRunner::analyse(Searcher& searcher, const EpdPosition& position){
+    EpdResult result;
+    Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+    Game game(&white, &black, position.fen);
+
+    std::vector<Move> bestMoves, avoidMoves;
+    Move m;
+    for (auto& san: position.bestMoves){
+        if (!moveFromSan(game, san, m)){ return result; }
+        bestMoves.push_back(m);
+    }
+    for (auto& san: position.avoidMoves){
+        if (!moveFromSan(game, san, m)){ return result; }
+        avoidMoves.push_back(m);
+    }
+    int numLegal = game.countLegalMoves();
+    if (numLegal == 0){
+        return result;
+    }
+    result.valid = true;
+
+    auto solves = [&](const Move& move){
+        if (!bestMoves.empty()){
+            return std::find(bestMoves.begin(), bestMoves.end(), move) != bestMoves.end();
+        }
+        return !avoidMoves.empty() && std::find(avoidMoves.begin(), avoidMoves.end(), move) == avoidMoves.end();
+    };
+
+    searcher.clear();
+    SearchLimits limits = config.limits;
+    auto startTime = std::chrono::steady_clock::now();
+    bool solving = false;
+    limits.onIteration = [&](const SearchResult& iteration){
+        bool solvesNow = solves(iteration.bestMove);
+        if (solvesNow && !solving){
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+            result.solveMs = elapsed.count();
+            result.solveNodes = iteration.nodes;
+        }
+        solving = solvesNow;
+    };
+
+    SearchResult first = searcher.search(game, limits);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    result.elapsedMs = elapsed.count();
+    result.nodes = first.nodes;
+    result.solved = solves(first.bestMove);
+    result.bestMove = moveToSan(game, first.bestMove);
+
+    limits.onIteration = nullptr;
+    SearchResult line = first;
+    for (int k = 0; k < config.multiPv && k < numLegal; k++){
+        if (k > 0){
+            limits.excludedMoves.push_back(line.bestMove);
+            line = searcher.search(game, limits);
+        }
+        result.lines.push_back({line.score, line.depth, toSan(game, line.pv)});
+    }
+    return result;
+}
+
+
+// Scores are written in pawns from the point of view of the player to move, or as #n for a mate in n moves (#-n for being mated)
+static std::string scoreToStr(int score){
+    std::ostringstream out;
+    if (std::abs(score) > MATE_SCORE - MAX_PLY){
+        int moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+        out << "#" << ((score < 0) ? "-" : "") << moves;
+    } else {
+        out << std::showpos << std::fixed << std::setprecision(2) << score / 100.0;
+    }
+    return out.str();
+}
+
+
+void writeEpdResult(std::ostream& out, const EpdPosition& position, const EpdResult& result){
+    out << (position.id.empty() ? position.fen : position.id) << " ";
+    if (!result.valid){
+        out << "INVALID" << std::endl;
+        return;
+    }
+
+    out << (result.solved ? "SOLVED " : "FAILED ") << result.bestMove << " (";
+    const std::vector<std::string>& expected = position.bestMoves.empty() ? position.avoidMoves : position.bestMoves;
+    out << (position.bestMoves.empty() ? "am" : "bm");
+    for (auto& san: expected){
+        out << " " << san;
+    }
+    std::streamsize precision = out.precision();
+    out << ") " << std::fixed << std::setprecision(1) << result.elapsedMs << "ms";
+    if (result.solved){
+        out << " solved " << result.solveMs << "ms";
+    }
+    out << std::defaultfloat << std::setprecision(precision);
+
+    for (size_t k = 0; k < result.lines.size(); k++){
+        const EpdLine& line = result.lines[k];
+        out << " | " << k + 1 << ". " << scoreToStr(line.score) << " d" << line.depth;
+        for (auto& san: line.pv){
+            out << " " << san;
+        }
+    }
+    out << std::endl;
+}
@@ -0,0 +1,92 @@
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+#include "game.hpp"
+#include "move.hpp"
+#include "search.hpp"
+
+#pragma once
+
+
+// A test position from an EPD (Extended Position Description) file: a FEN without the move counters,
+// followed by operations, e.g.
+//   r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - bm Qxf7#; id "scholar";
+struct EpdPosition{
+    std::string fen;                     // With the halfmove clock and fullmove number from the hmvc and fmvn operations, or 0 and 1
+    std::string id;                      // From the id operation, or empty
+    std::vector<std::string> bestMoves;  // bm: the position is solved by playing one of these (in SAN)
+    std::vector<std::string> avoidMoves; // am: the position is solved by playing none of these (in SAN)
+};
+
+
+// Parses an EPD line. Returns false if it doesn't start with 4 valid FEN fields. Unknown operations are ignored.
+bool parseEpd(const std::string& line, EpdPosition& position);
+
+
+// Settings for an EPD run
+struct EpdConfig{
+    SearchOptions searchOptions;
+
+    // Budget for analysing each position: a time limit (limits.timeMs), node limit (limits.nodes) or depth (limits.depth)
+    SearchLimits limits;
+
+    // Number of best lines to report for each position. Each line after the first is a search of its own,
+    // with the same budget, that leaves out the first moves of the lines before it.
+    int multiPv = 1;
+
+    int numThreads = 1;
+};
+
+
+// A line found by the search
+struct EpdLine{
+    int score; // In centipawns, from the point of view of the player to move
+    int depth;
+    std::vector<std::string> pv; // In SAN
+};
+
+
+// Result of analysing a position
+struct EpdResult{
+    bool valid = false; // False if the position or one of its bm/am moves couldn't be read, in which case it isn't analysed
+    bool solved = false;
+    std::string bestMove; // In SAN
+    std::vector<EpdLine> lines; // Best first, up to multiPv of them
+    uint64_t nodes = 0; // In the search for the first line
+    double elapsedMs = 0; // Of the search for the first line
+
+    // Time and nodes into the search for the first line at which it settled on a solving move for good, if solved
+    double solveMs = 0;
+    uint64_t solveNodes = 0;
+};
+
+
+// Analyses the positions of a test suite, spread over a pool of worker threads, each with its own searcher
+class EpdRunner{
+
+    public:
+
+        EpdRunner(const EpdConfig& config);
+
+        // Analyses every position. The results are in the same order as the positions.
+        std::vector<EpdResult> run(const std::vector<EpdPosition>& positions);
+
+        // Wall-clock duration of the last run, in seconds
+        double getElapsedSeconds();
+
+    private:
+
+        EpdResult analyse(Searcher& searcher, const EpdPosition& position);
+
+        EpdConfig config;
+
+        double elapsedSeconds;
+};
+
+
+// Writes a result as a line: the id (or FEN), SOLVED, FAILED or INVALID, the move played and the moves expected,
+// the search time and time to solve, then the lines found, e.g.
+//   scholar SOLVED Qxf7 (bm Qxf7#) 100.2ms solved 0.3ms | 1. #1 d9 Qxf7
+void writeEpdResult(std::ostream& out, const EpdPosition& position, const EpdResult& result);
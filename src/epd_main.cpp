@@ -0,0 +1,109 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+#include "epd.hpp"
+#include "search.hpp"
+#include "timeman.hpp"
+
+
+// Runs a test suite in EPD format: analyses each position with the built-in search, and checks its best move against
+// the position's bm (best move) or am (avoid move) operations. Writes a line per position, in the same order as the file,
+// then the number solved and a histogram of the times to solve.
+//
+// Usage: chess_epd [options]
+//   --input FILE     read positions from FILE (default: standard input)
+//   --time MS        time limit per position, in milliseconds (default 100, unless --nodes or --depth is given)
+//   --nodes N        node limit per position
+//   --depth N        depth limit per position
+//   --multipv N      report the N best lines (default 1). Each line after the first takes a search of its own.
+//   --hash BITS      size of each thread's transposition table, as a power of 2 entries (default 16)
+//   --threads N      number of worker threads (default: number of hardware threads)
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_epd [--input FILE] [--time MS] [--nodes N] [--depth N] [--multipv N] [--hash BITS] [--threads N]" << std::endl;
+}
+
+
+int main(int argc, char* argv[]){
+    EpdConfig config;
+    config.numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::string inputPath;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--input"){ inputPath = value; }
+        else if (arg == "--time"){ config.limits.timeMs = atoll(value.c_str()); }
+        else if (arg == "--nodes"){ config.limits.nodes = strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--depth"){ config.limits.depth = std::min(MAX_PLY - 1, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--multipv"){ config.multiPv = std::max(1, atoi(value.c_str())); }
+        else if (arg == "--hash"){ config.searchOptions.hashBits = std::min(30, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--threads"){ config.numThreads = std::max(1, atoi(value.c_str())); }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (config.limits.timeMs == 0 && config.limits.nodes == 0 && config.limits.depth == MAX_PLY - 1){
+        config.limits.timeMs = 100;
+    }
+
+    std::ifstream file;
+    if (!inputPath.empty()){
+        file.open(inputPath);
+        if (!file){
+            std::cerr << "ERROR: COULD NOT OPEN INPUT FILE " << inputPath << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = inputPath.empty() ? std::cin : file;
+
+    std::vector<EpdPosition> positions;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)){
+        lineNumber++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos){
+            continue;
+        }
+        EpdPosition position;
+        if (!parseEpd(line, position)){
+            std::cerr << "ERROR: INVALID EPD ON LINE " << lineNumber << std::endl;
+            continue;
+        }
+        positions.push_back(position);
+    }
+
+    EpdRunner runner(config);
+    std::vector<EpdResult> results = runner.run(positions);
+
+    int solved = 0, invalid = 0;
+    LatencyHistogram solveTimes;
+    for (size_t i = 0; i < positions.size(); i++){
+        writeEpdResult(std::cout, positions[i], results[i]);
+        if (!results[i].valid){
+            invalid++;
+        } else if (results[i].solved){
+            solved++;
+            solveTimes.record((int64_t)(results[i].solveMs * 1000));
+        }
+    }
+
+    std::cout << "SOLVED: " << solved << " OF " << positions.size() - invalid << "  INVALID: " << invalid
+              << " (THREADS: " << config.numThreads << ")" << std::endl;
+    std::cout << "TIME: " << runner.getElapsedSeconds() << " s" << std::endl;
+    solveTimes.write(std::cout, "TIME TO SOLVE");
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <array>
+
+#include "eval.hpp"
+#include "game.hpp"
+#include "piece.hpp"
+#include "player.hpp"
+#include "zobrist.hpp"
+#include "pawns.hpp"
+
+
+const std::array<int, 6> PIECE_VALUES = {100, 320, 330, 500, 900, 20000};
+
+
+// Bonuses for a piece being on each square, from white's point of view (indexed by row*8 + col, so rank 1 comes first).
+// For black pieces, the row is mirrored.
+static const int PAWN_SQUARES[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,   5,  10,  25,  25,  10,   5,   5,
+     10,  10,  20,  30,  30,  20,  10,  10,
+     50,  50,  50,  50,  50,  50,  50,  50,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+static const int KNIGHT_SQUARES[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+static const int BISHOP_SQUARES[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+static const int ROOK_SQUARES[64] = {
+      0,   0,   0,   5,   5,   0,   0,   0,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      5,  10,  10,  10,  10,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+static const int QUEEN_SQUARES[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+static const int KING_SQUARES[64] = {
+     20,  30,  10,   0,   0,  10,  30,  20,
+     20,  20,   0,   0,   0,   0,  20,  20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30
+};
+
+static const int* PIECE_SQUARES[6] = {PAWN_SQUARES, KNIGHT_SQUARES, BISHOP_SQUARES, ROOK_SQUARES, QUEEN_SQUARES, KING_SQUARES};
+
+
+int pieceType(Piece* piece){
+    return zobristPieceIndex(piece) % 6;
+}
+
+
+int pieceValue(Piece* piece){
+    return PIECE_VALUES[pieceType(piece)];
+}
+
+
+int evaluate(Game& game, PawnTable* pawnTable){
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    PieceColor us = game.getTurn()->getColor();
+
+    int score = 0;
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            Piece* piece = board[i][j];
+            if (piece == nullptr){
+                continue;
+            }
+            int type = pieceType(piece);
+            int row = (piece->getColor() == PieceColor::WHITE) ? i : 7 - i;
+            int value = PIECE_VALUES[type] + PIECE_SQUARES[type][row*8 + j];
+            score += (piece->getColor() == us) ? value : -value;
+        }
+    }
+    return score + evaluatePawns(game, pawnTable);
+}
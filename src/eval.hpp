@@ -0,0 +1,26 @@
+#include <array>
+
+#include "game.hpp"
+#include "piece.hpp"
+#include "pawns.hpp"
+
+#pragma once
+
+
+// Values of a pawn, knight, bishop, rook, queen and king, in centipawns (in the order of zobristPieceIndex()).
+// The king's value is only used to order captures, and to make sure it is never traded off in an exchange.
+extern const std::array<int, 6> PIECE_VALUES;
+
+
+// Type of a piece: 0-5 for a pawn, knight, bishop, rook, queen or king, regardless of color
+int pieceType(Piece* piece);
+
+
+// Value of a piece, from PIECE_VALUES
+int pieceValue(Piece* piece);
+
+
+// Static evaluation of the current position, in centipawns, from the point of view of the player whose turn it is
+// (positive if they are better off). Counts material, plus a bonus for each piece depending on the square it is on,
+// plus the pawn structure and king shields (see pawns.hpp), which are cached in pawnTable if one is given.
+int evaluate(Game& game, PawnTable* pawnTable = nullptr);
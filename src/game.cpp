@@ -4,6 +4,10 @@
 #include <array>
 #include <cmath>
 #include <stdlib.h>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 
 #include "game.hpp"
 #include "player.hpp"
@@ -14,127 +18,416 @@
 #include "bishop.hpp"
 #include "rook.hpp"
 #include "queen.hpp"
-#include "king.hpp"      
+#include "king.hpp"
+#include "piecepool.hpp"
+#include "zobrist.hpp"
+#include "instrument.hpp"
+#include "eval.hpp"
+#include "attacks.hpp"
 
 
 Game::Game(Player* white, Player* black) : white(white), black(black) {
 
-    // Populating board with pieces at starting positions
+    // Populating board with pieces at starting positions:
+    // white officers on row 0, white pawns on row 1, black pawns on row 6 and black officers on row 7
+    static const char OFFICERS[] = "RNBQKBNR";
     for (int i = 0; i < 8; i++){
         for (int j = 0; j < 8; j++){
-
             switch (i){
-                // White officers
-                case 0: 
-                    switch (j){
-                        case 0:
-                        case 7:
-                            board[i][j] = new Rook;
-                            break;
-                        case 1:
-                        case 6:
-                            board[i][j] = new Knight;
-                            break;               
-                        case 2:
-                        case 5:
-                            board[i][j] = new Bishop;
-                            break;
-                        case 3:
-                            board[i][j] = new Queen;
-                            break;
-                        case 4:
-                            board[i][j] = new King;
-                            break;
-                    }
-                    board[i][j]->setColor(PieceColor::WHITE);
-                    break;
-                // White pawns
-                case 1:
-                    board[i][j] = new Pawn;
-                    board[i][j]->setColor(PieceColor::WHITE);
-                    break;
-                // Black pawns
-                case 6:
-                    board[i][j] = new Pawn;
-                    board[i][j]->setColor(PieceColor::BLACK);
-                    break;
-                // Black officers
-                case 7:
-                    switch (j){
-                        case 0:
-                        case 7:
-                            board[i][j] = new Rook;
-                            break;
-                        case 1:
-                        case 6:
-                            board[i][j] = new Knight;
-                            break;               
-                        case 2:
-                        case 5:
-                            board[i][j] = new Bishop;
-                            break;
-                        case 3:
-                            board[i][j] = new Queen;
-                            break;
-                        case 4:
-                            board[i][j] = new King;
-                            break;
-                    }
-                    board[i][j]->setColor(PieceColor::BLACK);
-                    break;
-                // Empty squares
-                default:
-                    board[i][j] = nullptr;
-                    break;
+                case 0: board[i][j] = pieces.acquire(OFFICERS[j]); break;
+                case 1: board[i][j] = pieces.acquire('P'); break;
+                case 6: board[i][j] = pieces.acquire('p'); break;
+                case 7: board[i][j] = pieces.acquire(tolower(OFFICERS[j])); break;
+                default: board[i][j] = nullptr; break; // Empty squares
             }
         }
     }
 
     this->turn = white;
+    enPassantPawn = nullptr;
+    startPly = 0;
+    halfmoveClock = 0;
+    chess960 = false;
+    for (int c = 0; c < 2; c++){
+        castlingKingCol[c] = 4;
+        castlingRookCol[c][0] = 7;
+        castlingRookCol[c][1] = 0;
+    }
+    hash = computeHash();
+    pawnHash = computePawnHash();
+    legalSetValid = false;
 }
 
 
-std::array<std::array<Piece*, 8>, 8> Game::getBoard(){
-    return board;
+// Splits a string into its space-separated fields
+static std::vector<std::string> splitFields(const std::string& str){
+    std::vector<std::string> fields;
+    std::istringstream stream(str);
+    std::string field;
+    while (stream >> field){
+        fields.push_back(field);
+    }
+    return fields;
 }
 
 
-void Game::printBoard(){
-    std::cout << std::endl;
+// FEN fields are: piece placement (ranks 8 to 1, separated by '/'), turn, castling rights, en passant square,
+// halfmove clock and fullmove number. The last 2 are optional.
+//
+// Pieces are marked as having moved unless moving them is still relevant to the rules:
+// pawns on their starting rank (which can advance 2 squares), and kings and rooks which are still allowed to castle.
+Game::Game(Player* white, Player* black, const std::string& fen, bool chess960) : white(white), black(black), chess960(chess960) {
+    std::vector<std::string> fields = splitFields(fen);
+
+    // Piece placement
+    for (auto& row: board){
+        row.fill(nullptr);
+    }
+    int i = 7, j = 0;
+    for (char c: fields[0]){
+        if (c == '/'){
+            i--;
+            j = 0;
+        } else if (isdigit(c)){
+            j += c - '0';
+        } else {
+            Piece* piece = pieces.acquire(c);
+            piece->moved();
+            board[i][j] = piece;
+            if (c == 'K'){ white->setKingSq(i, j); }
+            if (c == 'k'){ black->setKingSq(i, j); }
+            j++;
+        }
+    }
 
-    // Print file letters above board 
-    std::cout << "\033[38;5;2m";  // Switch text color to green to print file letters
-    std::cout << "  a    b    c    d    e    f    g    h  " << std::endl;  // Print files
-    std::cout << "\033[0m"; // Revert to prior text coloring
+    // Pawns on their starting rank haven't moved
+    for (int col = 0; col < 8; col++){
+        if (board[1][col] != nullptr && board[1][col]->toChar() == 'P'){ board[1][col]->setHasMoved(false); }
+        if (board[6][col] != nullptr && board[6][col]->toChar() == 'p'){ board[6][col]->setHasMoved(false); }
+    }
 
+    // Castling rights. The king must be on its first row, and the rook on the side being castled towards on the same row.
+    // K and Q (X-FEN) mean the outermost rook on that side of the king; a file letter (Shredder-FEN) names the rook's column.
+    // Both are marked unmoved, and their columns kept, as in Chess960 they can start anywhere.
+    // Unless the game is known to be Chess960, a king on its standard square can only castle with a rook in the corner, as in standard FEN.
+    for (int c = 0; c < 2; c++){
+        castlingKingCol[c] = 4;
+        castlingRookCol[c][0] = 7;
+        castlingRookCol[c][1] = 0;
+    }
+    for (char c: fields[2]){
+        if (c == '-'){
+            break;
+        }
+        int color = isupper(c) ? 0 : 1;
+        int row = isupper(c) ? 0 : 7;
+        Square kingSq = isupper(c) ? white->getKingSq() : black->getKingSq();
+        char rookChar = isupper(c) ? 'R' : 'r';
+        if (kingSq.row != row){
+            continue;
+        }
+
+        int rookCol = -1;
+        char lower = tolower(c);
+        bool cornersOnly = !chess960 && kingSq.col == 4;
+        if (lower == 'k'){
+            for (int col = 7; col > (cornersOnly ? 6 : kingSq.col) && rookCol < 0; col--){
+                if (board[row][col] != nullptr && board[row][col]->toChar() == rookChar){ rookCol = col; }
+            }
+        } else if (lower == 'q'){
+            for (int col = 0; col < (cornersOnly ? 1 : kingSq.col) && rookCol < 0; col++){
+                if (board[row][col] != nullptr && board[row][col]->toChar() == rookChar){ rookCol = col; }
+            }
+        } else if (board[row][lower - 'a'] != nullptr && board[row][lower - 'a']->toChar() == rookChar && lower - 'a' != kingSq.col){
+            rookCol = lower - 'a';
+        }
+        if (rookCol < 0){
+            continue;
+        }
+
+        int side = (rookCol > kingSq.col) ? 0 : 1;
+        castlingKingCol[color] = kingSq.col;
+        castlingRookCol[color][side] = rookCol;
+        board[row][kingSq.col]->setHasMoved(false);
+        board[row][rookCol]->setHasMoved(false);
+        if (kingSq.col != 4 || rookCol != ((side == 0) ? 7 : 0)){
+            this->chess960 = true;
+        }
+    }
+
+    this->turn = (fields[1] == "w") ? white : black;
+
+    // The en passant square is the square the pawn that advanced 2 squares passed over. That pawn is 1 row further on.
+    enPassantPawn = nullptr;
+    if (fields[3] != "-"){
+        Square epSq = squareFromStr(fields[3]);
+        int pawnRow = (epSq.row == 2) ? 3 : 4;
+        CHESS_COUNT(DYNAMIC_CASTS);
+        enPassantPawn = dynamic_cast<Pawn*>(board[pawnRow][epSq.col]);
+        enPassantSq = squareIndex(pawnRow, epSq.col);
+        if (enPassantPawn != nullptr){
+            enPassantPawn->toggleEP();
+        }
+    }
+
+    halfmoveClock = (fields.size() >= 5) ? atoi(fields[4].c_str()) : 0;
+    int fullmoveNumber = (fields.size() >= 6) ? std::max(1, atoi(fields[5].c_str())) : 1;
+    startPly = 2*(fullmoveNumber - 1) + ((turn == black) ? 1 : 0);
+
+    hash = computeHash();
+    pawnHash = computePawnHash();
+    legalSetValid = false;
+}
+
+
+Game::Game(Player* white, Player* black, int chess960Position) : Game(white, black, chess960Fen(chess960Position), true) {}
+
+
+Game::Game(Player* white, Player* black, const Position& position) : white(white), black(black) {
+    for (auto& row: board){
+        row.fill(nullptr);
+    }
+    restore(position);
+}
+
+
+Position Game::snapshot(){
+    Position position;
+    position.unmoved = 0;
     for (int i = 0; i < 8; i++){
         for (int j = 0; j < 8; j++){
-            if (board[i][j] == nullptr){ // If square is empty
-                std::cout << "     ";
-            } else {
-                char pieceChar = board[i][j]->toChar();
-                std::cout << "  " << pieceChar << "  ";
+            Piece* piece = board[i][j];
+            position.pieces[i*8 + j] = (piece != nullptr) ? piece->toChar() : '\0';
+            if (piece != nullptr && !piece->getHasMoved()){
+                position.unmoved |= (uint64_t)1 << (i*8 + j);
+            }
+        }
+    }
+    position.turn = turn->getColor();
+    position.enPassantSq = (enPassantPawn != nullptr) ? enPassantSq : -1;
+    position.chess960 = chess960;
+    for (int c = 0; c < 2; c++){
+        position.castlingKingCol[c] = castlingKingCol[c];
+        position.castlingRookCol[c][0] = castlingRookCol[c][0];
+        position.castlingRookCol[c][1] = castlingRookCol[c][1];
+    }
+    position.halfmoveClock = halfmoveClock;
+    position.ply = startPly + history.size();
+    position.hash = hash;
+    position.pawnHash = pawnHash;
+    return position;
+}
+
+
+// Every piece goes back to the pool: those on the board, and those kept in the move records (captured pieces,
+// and pawns that were promoted). The position's pieces are then taken from the pool, so once the pool has enough
+// of each kind, restoring allocates nothing (the history keeps its capacity too).
+void Game::restore(const Position& position){
+    for (auto& row: board){
+        for (Piece*& piece: row){
+            if (piece != nullptr){
+                pieces.release(piece);
+                piece = nullptr;
             }
+        }
+    }
+    for (auto& record: history){
+        if (record.captured != nullptr){
+            pieces.release(record.captured);
+        }
+        if (record.promotedTo != nullptr){
+            pieces.release(record.moved);
+        }
+    }
+    history.clear();
 
-            toggleBackgroundColor();
+    for (int sq = 0; sq < 64; sq++){
+        char c = position.pieces[sq];
+        if (c == '\0'){
+            continue;
         }
+        Piece* piece = pieces.acquire(c);
+        piece->setHasMoved(((position.unmoved >> sq) & 1) == 0);
+        board[sq / 8][sq % 8] = piece;
+        if (c == 'K'){ white->setKingSq(sq / 8, sq % 8); }
+        if (c == 'k'){ black->setKingSq(sq / 8, sq % 8); }
+    }
+
+    turn = (position.turn == PieceColor::WHITE) ? white : black;
+    enPassantPawn = nullptr;
+    if (position.enPassantSq >= 0){
+        enPassantSq = position.enPassantSq;
+        enPassantPawn = static_cast<Pawn*>(board[rankOf(enPassantSq)][fileOf(enPassantSq)]);
+        enPassantPawn->toggleEP();
+    }
+    chess960 = position.chess960;
+    for (int c = 0; c < 2; c++){
+        castlingKingCol[c] = position.castlingKingCol[c];
+        castlingRookCol[c][0] = position.castlingRookCol[c][0];
+        castlingRookCol[c][1] = position.castlingRookCol[c][1];
+    }
+    halfmoveClock = position.halfmoveClock;
+    startPly = position.ply;
+    hash = position.hash;
+    pawnHash = position.pawnHash;
+    legalSetValid = false;
+}
 
-        // Print rank number after rank
-        std::cout << "\033[0m"; // Switch background back to black
-        std::cout << "\033[38;5;1m";  // Switch text color to red to print rank no.
-        std::cout << "  " << i+1; // Print rank
-        std::cout << "\033[0m"; // Revert to prior coloring
 
-        std::cout << std::endl;
-        toggleBackgroundColor();
-        
+// Scharnagl's numbering: dividing the position number by 4, then 4, then 6 gives, as remainders, the columns of the
+// light-squared bishop (b, d, f or h) and the dark-squared bishop (a, c, e or g), and which of the 6 empty columns the queen is on.
+// The quotient (0-9) is which pair of the 5 remaining empty columns the knights are on. The rooks and king fill the last 3, in that order.
+std::string Game::chess960Fen(int position){
+    static const int KNIGHTS[10][2] = { {0,1}, {0,2}, {0,3}, {0,4}, {1,2}, {1,3}, {1,4}, {2,3}, {2,4}, {3,4} };
+
+    std::string rank(8, ' ');
+    int n = position;
+    rank[2*(n % 4) + 1] = 'B';
+    n /= 4;
+    rank[2*(n % 4)] = 'B';
+    n /= 4;
+
+    // Places piece on the index-th empty column
+    auto placeOnEmpty = [&](int index, char piece){
+        for (int col = 0; col < 8; col++){
+            if (rank[col] == ' ' && index-- == 0){
+                rank[col] = piece;
+                return;
+            }
+        }
+    };
+    placeOnEmpty(n % 6, 'Q');
+    n /= 6;
+    placeOnEmpty(KNIGHTS[n][1], 'N'); // The later column first, so placing it doesn't shift the earlier one
+    placeOnEmpty(KNIGHTS[n][0], 'N');
+    placeOnEmpty(0, 'R');
+    placeOnEmpty(0, 'K');
+    placeOnEmpty(0, 'R');
+
+    std::string blackRank = rank;
+    for (auto& c: blackRank){
+        c = tolower(c);
     }
-    std::cout << "(m) move (cs) castle short (cl) castle long (r) resign (od) offer draw " << std::endl;  // List valid user inputs under board
+    return blackRank + "/pppppppp/8/8/8/8/PPPPPPPP/" + rank + " w KQkq - 0 1";
+}
+
+
+bool Game::isValidFen(const std::string& fen){
+    std::vector<std::string> fields = splitFields(fen);
+    if (fields.size() < 4 || fields.size() > 6){ return false; }
+
+    // Piece placement: 8 ranks, each with 8 squares
+    int ranks = 1, squares = 0, whiteKings = 0, blackKings = 0;
+    for (char c: fields[0]){
+        if (c == '/'){
+            if (squares != 8){ return false; }
+            ranks++;
+            squares = 0;
+        } else if (c >= '1' && c <= '8'){
+            squares += c - '0';
+        } else if (std::string("pnbrqkPNBRQK").find(c) != std::string::npos){
+            squares++;
+            if (c == 'K'){ whiteKings++; }
+            if (c == 'k'){ blackKings++; }
+        } else {
+            return false;
+        }
+        if (squares > 8){ return false; }
+    }
+    if (ranks != 8 || squares != 8 || whiteKings != 1 || blackKings != 1){ return false; }
+
+    if (fields[1] != "w" && fields[1] != "b"){ return false; }
+
+    if (fields[2] != "-"){
+        for (char c: fields[2]){
+            if (std::string("KQkqABCDEFGHabcdefgh").find(c) == std::string::npos){ return false; }
+        }
+    }
+
+    // En passant square must be on the 3rd rank (after a white pawn advanced) or the 6th (after a black pawn advanced)
+    if (fields[3] != "-"){
+        if (!isValidSquareStr(fields[3]) || (fields[3][1] != '3' && fields[3][1] != '6')){ return false; }
+    }
+
+    for (size_t k = 4; k < fields.size(); k++){
+        for (char c: fields[k]){
+            if (!isdigit(c)){ return false; }
+        }
+    }
+
+    return true;
+}
+
+
+std::string Game::toFen(bool shredder){
+    std::string fen;
+
+    // Piece placement
+    for (int i = 7; i >= 0; i--){
+        int empty = 0;
+        for (int j = 0; j < 8; j++){
+            if (board[i][j] == nullptr){
+                empty++;
+                continue;
+            }
+            if (empty > 0){
+                fen += (char)('0' + empty);
+                empty = 0;
+            }
+            fen += board[i][j]->toChar();
+        }
+        if (empty > 0){ fen += (char)('0' + empty); }
+        if (i > 0){ fen += '/'; }
+    }
+
+    fen += (turn == white) ? " w " : " b ";
+
+    // Castling rights, from the kings' and rooks' hasMoved flags.
+    // In X-FEN, a rook with another of its color further out on the same side is given by its file letter.
+    int rights = castlingRights();
+    std::string castling;
+    for (int c = 0; c < 2; c++){
+        int row = (c == 0) ? 0 : 7;
+        for (int side = 0; side < 2; side++){
+            if (!(rights & (1 << (2*c + side)))){
+                continue;
+            }
+            int rookCol = castlingRookCol[c][side];
+            bool outermost = true;
+            int step = (side == 0) ? 1 : -1;
+            for (int col = rookCol + step; col >= 0 && col < 8; col += step){
+                if (board[row][col] != nullptr && board[row][col]->toChar() == board[row][rookCol]->toChar()){ outermost = false; }
+            }
+            char letter = (side == 0) ? 'K' : 'Q';
+            if (shredder || !outermost){ letter = 'A' + rookCol; }
+            castling += (c == 0) ? letter : (char)tolower(letter);
+        }
+    }
+    fen += castling.empty() ? "-" : castling;
+
+    // En passant square - the square enPassantPawn passed over
+    std::string epStr = "-";
+    if (enPassantPawn != nullptr){
+        int epRow = (rankOf(enPassantSq) == 3) ? 2 : 5;
+        epStr = std::string(1, 'a' + fileOf(enPassantSq)) + std::string(1, '1' + epRow);
+    }
+    fen += " " + epStr;
+
+    int ply = startPly + history.size();
+    fen += " " + std::to_string(halfmoveClock) + " " + std::to_string(ply/2 + 1);
+    return fen;
+}
+
+
+std::array<std::array<Piece*, 8>, 8> Game::getBoard(){
+    return board;
 }
 
 
 void Game::toggleTurn(){
     turn = (turn == white) ? black : white;
+    hash ^= zobristKeys().blackToMove;
+    legalSetValid = false;
 }
 
 
@@ -143,86 +436,445 @@ Player* Game::getTurn(){
 }
 
 
-void Game::movePiece(const Square& start, const Square& dest){
-    Piece *pieceToMove = board[start.row][start.col];
-    Piece *pieceAtDest = board[dest.row][dest.col];
+Player* Game::getPlayer(PieceColor color){
+    return (color == PieceColor::WHITE) ? white : black;
+}
+
 
-    // If destination square not empty, free memory of piece at destination
-    if (pieceAtDest != nullptr){        
-        delete pieceAtDest;
+// The board is updated as follows:
+// - The piece at start is moved to dest, and any piece at dest is captured.
+// - For en passant, the captured pawn is the one beside the start square, on the dest square's column.
+// - For castling, the rook is moved to the square the king passed over. In Chess960, where castling is the king moving onto
+//   its own rook, the king and rook end up on the same squares as in standard castling.
+// - For a promotion, the pawn is replaced by the new piece.
+// Captured pieces, and pawns that have been promoted, are kept in the move's record rather than going back to the piece pool.
+//
+// The pawn that could be captured en passant before the move no longer can be, and if a pawn advances 2 squares, it now can be.
+//
+// The hash is updated by XORing out the keys for the castling rights and en passant file before the move,
+// and the moved, captured and castled pieces on their old squares, then XORing in the new keys.
+void Game::movePiece(SquareIndex start, SquareIndex dest, char promoteTo){
+    Piece *pieceToMove = board[rankOf(start)][fileOf(start)];
+    const ZobristKeys& keys = zobristKeys();
+
+    MoveRecord record;
+    record.move = move(start, dest, promoteTo);
+    record.moved = pieceToMove;
+    record.movedHadMoved = pieceToMove->getHasMoved();
+    record.captured = board[rankOf(dest)][fileOf(dest)];
+    record.capturedSq = dest;
+    record.promotedTo = nullptr;
+    record.castledRook = nullptr;
+    record.prevEnPassantPawn = enPassantPawn;
+    record.prevEnPassantSq = enPassantSq;
+    record.prevHash = hash;
+    record.prevPawnHash = pawnHash;
+    record.prevHalfmoveClock = halfmoveClock;
+
+    hash ^= castlingKey(castlingRights()) ^ enPassantKey();
+    hash ^= keys.pieces[zobristPieceIndex(pieceToMove)][start];
+
+    // Chess960 castling - the king moving onto its own rook. The rook is moved below, rather than captured.
+    if (chess960 && record.captured != nullptr && record.captured->getColor() == pieceToMove->getColor()){
+        record.castledRook = record.captured;
+        record.captured = nullptr;
     }
+    SquareIndex landing = dest; // Where the moved piece ends up
 
-    board[dest.row][dest.col] = pieceToMove;
-    board[start.row][start.col] = nullptr; // Vacate start square by setting it to nullptr
+    CHESS_COUNT(DYNAMIC_CASTS);
+    Pawn* pawn = dynamic_cast<Pawn*>(pieceToMove);
+
+    // En passant - a pawn moving diagonally onto an empty square
+    if (pawn && fileOf(start) != fileOf(dest) && record.captured == nullptr){
+        record.capturedSq = squareIndex(rankOf(start), fileOf(dest));
+        record.captured = board[rankOf(start)][fileOf(dest)];
+        board[rankOf(start)][fileOf(dest)] = nullptr;
+    }
+    if (record.captured != nullptr){
+        int capturedIndex = zobristPieceIndex(record.captured);
+        hash ^= keys.pieces[capturedIndex][record.capturedSq];
+        if (capturedIndex % 6 == 0){
+            pawnHash ^= keys.pieces[capturedIndex][record.capturedSq];
+        }
+    }
+
+    // Pawn moves and captures can't be undone, so reset the halfmove clock
+    halfmoveClock = (pawn || record.captured != nullptr) ? 0 : halfmoveClock + 1;
+
+    board[rankOf(dest)][fileOf(dest)] = pieceToMove;
+    board[rankOf(start)][fileOf(start)] = nullptr; // Vacate start square by setting it to nullptr
     pieceToMove->moved();
 
+    // Previous move's pawn can no longer be captured en passant
+    if (enPassantPawn != nullptr){
+        enPassantPawn->toggleEP();
+        enPassantPawn = nullptr;
+    }
+
     // Update player's kingSq if piece being moved is the king
+    CHESS_COUNT(DYNAMIC_CASTS);
     if ( dynamic_cast<King*>(pieceToMove)){ // dynamic_cast will returns a truthy value if pieceToMove is of the specified class
         turn->setKingSq(dest);
+
+        // Castling - the king moving 2 squares sideways, or in Chess960 onto its own rook. Whichever squares they started on,
+        // the king ends up on column 6 (short) or 2 (long), and the rook on the square beside it towards the centre (column 5 or 3).
+        int colDisp = fileOf(dest) - fileOf(start);
+        if (record.castledRook != nullptr || (!chess960 && (colDisp == 2 || colDisp == -2))){
+            bool shortSide = colDisp > 0;
+            int color = (turn->getColor() == PieceColor::WHITE) ? 0 : 1;
+            record.rookStart = squareIndex(rankOf(start), castlingRookCol[color][shortSide ? 0 : 1]);
+            record.rookDest = squareIndex(rankOf(start), shortSide ? 5 : 3);
+            record.kingDest = squareIndex(rankOf(start), shortSide ? 6 : 2);
+            if (record.castledRook == nullptr){
+                record.castledRook = board[rankOf(record.rookStart)][fileOf(record.rookStart)];
+            }
+
+            // Take the king and rook off the board, then put them on their castled squares
+            // (in Chess960 these can be the squares they started on, or each other's)
+            board[rankOf(dest)][fileOf(dest)] = nullptr;
+            board[rankOf(record.rookStart)][fileOf(record.rookStart)] = nullptr;
+            board[rankOf(record.kingDest)][fileOf(record.kingDest)] = pieceToMove;
+            board[rankOf(record.rookDest)][fileOf(record.rookDest)] = record.castledRook;
+            record.castledRook->moved();
+            int rookIndex = zobristPieceIndex(record.castledRook);
+            hash ^= keys.pieces[rookIndex][record.rookStart] ^ keys.pieces[rookIndex][record.rookDest];
+
+            turn->setKingSq(record.kingDest);
+            landing = record.kingDest;
+        }
     }
 
-    // Check for a pawn promotion
-    // Pawns can be promoted to a queen, rook, bishop or knight,
-    // Provided they have reached the end of the board
-    // i.e. for a white pawn, has reached row 7; for a black pawn, has reached row 0.
-    else if (dynamic_cast<Pawn*>(pieceToMove)){ 
+    else if (pawn){
+
+        // The pawn leaves its start square, and lands on dest unless it is promoted (checked below)
+        int pawnIndex = zobristPieceIndex(pawn);
+        pawnHash ^= keys.pieces[pawnIndex][start] ^ keys.pieces[pawnIndex][dest];
+
+        // A pawn advancing 2 squares can be captured en passant on the next move
+        if (rankOf(dest) - rankOf(start) == 2 || rankOf(dest) - rankOf(start) == -2){
+            pawn->toggleEP();
+            enPassantPawn = pawn;
+            enPassantSq = dest;
+        }
 
-        if ( (dest.row == 7 && turn->getColor() == PieceColor::WHITE) || (dest.row == 0 && turn->getColor() == PieceColor::BLACK) ) {
-            std::string choice;
-            do {
-                std::cout << "PROMOTE TO: QUEEN (q)  ROOK (r)  BISHOP (b)  KNIGHT (n)" << std::endl;
-                std::cout << "> ";
-                std::cin >> choice;
-                std::cout << std::endl;
-            } while (choice != "q" && choice != "r" && choice != "b" && choice != "n");
+        // Check for a pawn promotion
+        // Pawns can be promoted to a queen, rook, bishop or knight,
+        // Provided they have reached the end of the board
+        // i.e. for a white pawn, has reached row 7; for a black pawn, has reached row 0.
+        else if ( (rankOf(dest) == 7 && turn->getColor() == PieceColor::WHITE) || (rankOf(dest) == 0 && turn->getColor() == PieceColor::BLACK) ) {
 
             // Set move destination to selected piece
-            Piece* newPiece;
-            if (choice == "q"){ newPiece = new Queen; }
-            else if (choice == "r"){ newPiece = new Rook; }
-            else if (choice == "b"){ newPiece = new Bishop; }
-            else if (choice == "n"){ newPiece = new Knight; }
-            newPiece->setColor(turn->getColor());
+            char letter = (promoteTo == 'r' || promoteTo == 'b' || promoteTo == 'n') ? promoteTo : 'q'; // Queen if promoteTo is 'q' or not given
+            Piece* newPiece = pieces.acquire((turn->getColor() == PieceColor::WHITE) ? toupper(letter) : letter);
             newPiece->moved(); // hasMoved is false by default, so set it to true for the new piece.
-            delete pieceToMove; // Free memory of pawn that was moved before assigning new piece.
-            board[dest.row][dest.col] = newPiece;
+            board[rankOf(dest)][fileOf(dest)] = newPiece;
+            record.promotedTo = newPiece;
+            pawnHash ^= keys.pieces[pawnIndex][dest];
         }
     }
+
+    hash ^= keys.pieces[zobristPieceIndex(board[rankOf(landing)][fileOf(landing)])][landing];
+    hash ^= castlingKey(castlingRights()) ^ enPassantKey();
+
+    history.push_back(record);
+    legalSetValid = false;
 }
 
 
-// A player-inputted move is valid if:
-// - the start square contains one of the player's pieces
-// - The end square is either empty or occupied by an enemy piece
-// - The move does not result in check
-// - The piece is legally able to make the move (as per the rules of that piece's movement)
-bool Game::isValidMove(const Square& start, const Square& dest){
-    Piece *pieceToMove = board[start.row][start.col];
-    Piece *pieceAtDest = board[dest.row][dest.col];
+void Game::movePiece(const Square& start, const Square& dest, char promoteTo){
+    movePiece(squareIndex(start), squareIndex(dest), promoteTo);
+}
+
+
+bool Game::isPromotion(SquareIndex start, SquareIndex dest){
+    CHESS_COUNT(DYNAMIC_CASTS);
+    return dynamic_cast<Pawn*>(board[rankOf(start)][fileOf(start)]) && (rankOf(dest) == 7 || rankOf(dest) == 0);
+}
+
+
+bool Game::isPromotion(const Square& start, const Square& dest){
+    return isPromotion(squareIndex(start), squareIndex(dest));
+}
+
+
+// Legal moves are found by getting the legal destinations of each of the player's pieces,
+// and discarding those that would leave the player in check.
+// Castling is then added if the player is able to castle.
+std::vector<Move> Game::legalMoves(){
+    CHESS_TIME(LEGAL_MOVES);
+    CHESS_COUNT(VECTORS_ALLOCATED);
+    std::vector<Move> moves;
+
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
 
-    // Return false if user has selected an empty square or an opposition piece
-    if (pieceToMove == nullptr || pieceToMove->getColor() != turn->getColor()){ 
-        return false; 
+            if ( board[i][j] != nullptr && board[i][j]->getColor() == turn->getColor() ){ // If square contains player's piece
+
+                Piece* pieceToMove = board[i][j];
+                SquareIndex sqAtIJ = squareIndex(i,j);
+                CHESS_COUNT(DYNAMIC_CASTS);
+                bool isPawn = dynamic_cast<Pawn*>(pieceToMove) != nullptr;
+
+                for (SquareIndex dest: pieceToMove->legalDests(sqAtIJ, board)){
+                    if (moveResultsInCheck(sqAtIJ, dest)){
+                        continue;
+                    }
+
+                    // Pawns reaching the end of the board are promoted, to any of 4 pieces
+                    if (isPawn && (rankOf(dest) == 7 || rankOf(dest) == 0)){
+                        for (char promoteTo : {'q', 'r', 'b', 'n'}){
+                            moves.push_back( move(sqAtIJ, dest, promoteTo) );
+                        }
+                    } else {
+                        moves.push_back( move(sqAtIJ, dest) );
+                    }
+                }
+            }
+        }
+    }
+
+    // Castling is represented as the king moving 2 squares towards the rook, or in Chess960 onto the rook
+    if (shortCastleIsLegal()){
+        moves.push_back(castlingMove(true));
+    }
+    if (longCastleIsLegal()){
+        moves.push_back(castlingMove(false));
+    }
+
+    if (!legalSetValid){
+        setLegalSet(moves);
     }
+    return moves;
+}
+
 
-    // Return false if user is trying to move a piece to a square already occupied by a friendly piece
-    if (pieceAtDest != nullptr ){ 
-        if (pieceAtDest->getColor() == turn->getColor()){
-            return false; 
+// Directions as (row, col) steps: the first 4 straight (rook) and the last 4 diagonal (bishop)
+static const int DIRECTIONS[8][2] = { {1,0}, {-1,0}, {0,1}, {0,-1}, {1,1}, {1,-1}, {-1,1}, {-1,-1} };
+
+
+// Squares a slider on row, col attacks along directions first to last - 1 (see DIRECTIONS), up to and including the first occupied square
+static uint64_t slideMask(int row, int col, uint64_t occupied, int first, int last){
+    uint64_t mask = 0;
+    for (int d = first; d < last; d++){
+        for (int r = row + DIRECTIONS[d][0], c = col + DIRECTIONS[d][1]; r >= 0 && r < 8 && c >= 0 && c < 8; r += DIRECTIONS[d][0], c += DIRECTIONS[d][1]){
+            mask |= squareBit(r, c);
+            if (occupied & squareBit(r, c)){
+                break;
+            }
         }
     }
+    return mask;
+}
 
-    // Return false if move results in the player whose turn it is being in check
-    if (moveResultsInCheck(start, dest)){
-        return false;
+
+// Squares attacked by a piece (by lowercase letter) of the given color on row, col
+static uint64_t attackMask(char kind, PieceColor color, int row, int col, uint64_t occupied){
+    switch (kind){
+        case 'p': return pawnAttacksFrom(color, row*8 + col);
+        case 'n': return KNIGHT_ATTACKS[row*8 + col];
+        case 'b': return slideMask(row, col, occupied, 4, 8);
+        case 'r': return slideMask(row, col, occupied, 0, 4);
+        case 'q': return slideMask(row, col, occupied, 0, 8);
+        default: return KING_ATTACKS[row*8 + col];
+    }
+}
+
+
+// The legal moves are counted as the number of squares each piece can move to, as masks:
+// - The king can move to any square not holding a friendly piece or attacked by the opposition.
+//   Opposition attacks are worked out with the king off the board, so it can't step back along a slider's line.
+// - In double check, only the king can move. In single check, other pieces can only capture the checker or block its line.
+// - A pinned piece (the only piece between the king and an opposition slider) can only move along the pin's line.
+// Pawn moves onto the last row count 4 times (one for each promotion). En passant, which can uncover a check along the
+// row of both pawns, is checked by simulating it, and castling with the same checks as legalMoves().
+int Game::countLegalMoves(){
+    CHESS_TIME(COUNT_LEGAL_MOVES);
+    PieceColor us = turn->getColor();
+    PieceColor them = (us == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+
+    std::array<char, 64> kinds; // Lowercase letter of the piece on each square, or '\0'
+    uint64_t own = 0, opp = 0;
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            Piece* piece = board[i][j];
+            kinds[i*8 + j] = (piece != nullptr) ? tolower(piece->toChar()) : '\0';
+            if (piece != nullptr){
+                if (piece->getColor() == us){ own |= squareBit(i, j); }
+                else { opp |= squareBit(i, j); }
+            }
+        }
+    }
+    uint64_t occupied = own | opp;
+    SquareIndex kingSq = turn->getKingIndex();
+    uint64_t kingBit = squareBit(kingSq);
+
+    // Opposition attacks, with the king off the board, and the pieces giving check
+    uint64_t attacked = 0;
+    uint64_t checkers = 0;
+    for (int sq = 0; sq < 64; sq++){
+        if (opp & ((uint64_t)1 << sq)){
+            attacked |= attackMask(kinds[sq], them, sq / 8, sq % 8, occupied & ~kingBit);
+            if (attackMask(kinds[sq], them, sq / 8, sq % 8, occupied) & kingBit){
+                checkers |= (uint64_t)1 << sq;
+            }
+        }
+    }
+
+    int count = __builtin_popcountll(KING_ATTACKS[kingSq] & ~own & ~attacked);
+    if (__builtin_popcountll(checkers) >= 2){
+        return count;
     }
 
-    return pieceToMove->isLegalMove(start, dest, board);
+    // Squares other pieces can move to: any not holding a friendly piece, or in check, the checker and (for a slider) the squares between
+    // it and the king. Pin lines are found the same way, walking out from the king: a friendly piece followed by an opposition slider that moves along that line.
+    uint64_t targets = (checkers != 0) ? checkers : ~own;
+    std::array<uint64_t, 64> pinLine;
+    pinLine.fill(~(uint64_t)0);
+    for (int d = 0; d < 8; d++){
+        uint64_t line = 0;
+        int pinnedSq = -1;
+        for (int r = rankOf(kingSq) + DIRECTIONS[d][0], c = fileOf(kingSq) + DIRECTIONS[d][1]; r >= 0 && r < 8 && c >= 0 && c < 8; r += DIRECTIONS[d][0], c += DIRECTIONS[d][1]){
+            int sq = r*8 + c;
+            line |= squareBit(r, c);
+            if (checkers & squareBit(r, c)){
+                targets = line;
+                break;
+            }
+            if (own & squareBit(r, c)){
+                if (pinnedSq >= 0){
+                    break;
+                }
+                pinnedSq = sq;
+            } else if (opp & squareBit(r, c)){
+                bool slides = (kinds[sq] == 'q') || (kinds[sq] == ((d < 4) ? 'r' : 'b'));
+                if (pinnedSq >= 0 && slides){
+                    pinLine[pinnedSq] = line;
+                }
+                break;
+            }
+        }
+    }
+    int forward = (us == PieceColor::WHITE) ? 1 : -1;
+    int startRow = (us == PieceColor::WHITE) ? 1 : 6;
+    int lastRow = (us == PieceColor::WHITE) ? 7 : 0;
+    uint64_t lastRowMask = (uint64_t)0xFF << (lastRow*8);
+    for (int sq = 0; sq < 64; sq++){
+        if (!(own & ((uint64_t)1 << sq)) || kinds[sq] == 'k'){
+            continue;
+        }
+        int row = sq / 8, col = sq % 8;
+        uint64_t dests;
+        if (kinds[sq] == 'p'){
+            dests = pawnAttacksFrom(us, sq) & opp;
+            if (!(occupied & squareBit(row + forward, col))){
+                dests |= squareBit(row + forward, col);
+                if (row == startRow && !(occupied & squareBit(row + 2*forward, col))){
+                    dests |= squareBit(row + 2*forward, col);
+                }
+            }
+            dests &= targets & pinLine[sq];
+            count += __builtin_popcountll(dests & ~lastRowMask) + 4*__builtin_popcountll(dests & lastRowMask);
+        } else {
+            dests = attackMask(kinds[sq], us, row, col, occupied) & targets & pinLine[sq];
+            count += __builtin_popcountll(dests);
+        }
+    }
+
+    if (enPassantPawn != nullptr){
+        for (int col = fileOf(enPassantSq) - 1; col <= fileOf(enPassantSq) + 1; col += 2){
+            if (col >= 0 && col < 8 && (own & squareBit(rankOf(enPassantSq), col)) && kinds[rankOf(enPassantSq)*8 + col] == 'p'
+                && !moveResultsInCheck(squareIndex(rankOf(enPassantSq), col), squareIndex(rankOf(enPassantSq) + forward, fileOf(enPassantSq)))){
+                count++;
+            }
+        }
+    }
+
+    if (checkers == 0){
+        count += shortCastleIsLegal() + longCastleIsLegal();
+    }
+    return count;
+}
+
+
+void Game::makeMove(const Move& move){
+    movePiece(move.start, move.dest, move.promotion);
+    toggleTurn();
+}
+
+
+// Undoes each of the changes described above movePiece(), in reverse order.
+void Game::unmakeMove(){
+    toggleTurn();
+
+    MoveRecord record = history.back();
+    history.pop_back();
+    SquareIndex start = record.move.start;
+    SquareIndex dest = record.move.dest;
+
+    // Pawn that advanced 2 squares with this move can no longer be captured en passant,
+    // and the one that could be before this move can be again.
+    if (enPassantPawn != nullptr){
+        enPassantPawn->toggleEP();
+    }
+    enPassantPawn = record.prevEnPassantPawn;
+    enPassantSq = record.prevEnPassantSq;
+    if (enPassantPawn != nullptr){
+        enPassantPawn->toggleEP();
+    }
+    hash = record.prevHash;
+    pawnHash = record.prevPawnHash;
+    halfmoveClock = record.prevHalfmoveClock;
+    legalSetValid = false;
+
+    // Return the piece that a pawn was promoted to to the pool. The pawn is put back below.
+    if (record.promotedTo != nullptr){
+        pieces.release(record.promotedTo);
+    }
+
+    if (record.castledRook != nullptr){
+        // The king and rook are taken off their castled squares before either is put back, as in Chess960 the squares can overlap
+        board[rankOf(record.kingDest)][fileOf(record.kingDest)] = nullptr;
+        board[rankOf(record.rookDest)][fileOf(record.rookDest)] = nullptr;
+        board[rankOf(start)][fileOf(start)] = record.moved;
+        board[rankOf(record.rookStart)][fileOf(record.rookStart)] = record.castledRook;
+        record.castledRook->setHasMoved(false); // Rook can only castle if it hasn't moved
+    } else {
+        board[rankOf(start)][fileOf(start)] = record.moved;
+        board[rankOf(dest)][fileOf(dest)] = nullptr;
+        if (record.captured != nullptr){
+            board[rankOf(record.capturedSq)][fileOf(record.capturedSq)] = record.captured;
+        }
+    }
+    record.moved->setHasMoved(record.movedHadMoved);
+
+    CHESS_COUNT(DYNAMIC_CASTS);
+    if (dynamic_cast<King*>(record.moved)){
+        turn->setKingSq(start);
+    }
+}
+
+
+// A player-inputted move is valid if it is one of the moves returned by legalMoves(), i.e.:
+// - the start square contains one of the player's pieces
+// - The end square is either empty or occupied by an enemy piece
+// - The move does not result in check
+// - The piece is legally able to make the move (as per the rules of that piece's movement), or it is a legal castle
+// The legal moves are worked out once per position, so after the first call this is a single lookup.
+bool Game::isValidMove(SquareIndex start, SquareIndex dest){
+    CHESS_TIME(IS_VALID_MOVE);
+    updateLegalSet();
+    return legalSet[start*64 + dest];
+}
+
+
+bool Game::isValidMove(const Square& start, const Square& dest){
+    return isValidMove(squareIndex(start), squareIndex(dest));
 }
 
 
 bool Game::shortCastleIsLegal(){
-    Piece* kingPiece = board[turn->getKingSq().row][turn->getKingSq().col];
+    Piece* kingPiece = board[rankOf(turn->getKingIndex())][fileOf(turn->getKingIndex())];
+    CHESS_COUNT(DYNAMIC_CASTS);
     King* king = dynamic_cast<King*>(kingPiece);
     // If for whatever reason cast fails
     if (king == nullptr){
@@ -230,45 +882,21 @@ bool Game::shortCastleIsLegal(){
         exit(1);
     }
 
-    return king->canCastleShort(board);
+    int color = (turn->getColor() == PieceColor::WHITE) ? 0 : 1;
+    return king->canCastleShort(turn->getKingIndex(), castlingRookCol[color][0], board);
 }
 
 
+// Castling is carried out by movePiece(), as the king moving 2 squares towards the kingside rook (or onto it, in Chess960).
 void Game::shortCastle(){
-
-    // Get current and new (after castling) squares 
-    // on which the king & kingside rook are/will be located.
-    Square kingSquare, rookSquare, newKingSquare, newRookSquare;
-    if (turn->getColor() == PieceColor::WHITE){
-        kingSquare = square(0, 4);
-        rookSquare = square(0, 7);
-        newKingSquare = square(0, 6);
-        newRookSquare = square(0, 5);
-    }
-    else if(turn->getColor() == PieceColor::BLACK){
-        kingSquare = square(7, 4);
-        rookSquare = square(7, 7);
-        newKingSquare = square(7, 6);
-        newRookSquare = square(7, 5);   
-    }
-
-    // Move king
-    Piece* king = board[kingSquare.row][kingSquare.col];
-    board[newKingSquare.row][newKingSquare.col] = king;
-    turn->setKingSq(newKingSquare);
-    board[kingSquare.row][kingSquare.col] = nullptr;
-    king->moved();
-
-    // Move rook
-    Piece* rook = board[rookSquare.row][rookSquare.col];
-    board[newRookSquare.row][newRookSquare.col] = rook;
-    board[rookSquare.row][rookSquare.col] = nullptr;
-    rook->moved();
+    Move m = castlingMove(true);
+    movePiece(m.start, m.dest);
 }
 
 
 bool Game::longCastleIsLegal(){
-    Piece* kingPiece = board[turn->getKingSq().row][turn->getKingSq().col];
+    Piece* kingPiece = board[rankOf(turn->getKingIndex())][fileOf(turn->getKingIndex())];
+    CHESS_COUNT(DYNAMIC_CASTS);
     King* king = dynamic_cast<King*>(kingPiece);
     // If for whatever reason cast fails
     if (king == nullptr){
@@ -276,45 +904,145 @@ bool Game::longCastleIsLegal(){
         exit(1);
     }
 
-    return king->canCastleLong(board);
+    int color = (turn->getColor() == PieceColor::WHITE) ? 0 : 1;
+    return king->canCastleLong(turn->getKingIndex(), castlingRookCol[color][1], board);
 }
 
 
+// Castling is carried out by movePiece(), as the king moving 2 squares towards the queenside rook (or onto it, in Chess960).
 void Game::longCastle(){
+    Move m = castlingMove(false);
+    movePiece(m.start, m.dest);
+}
 
-    // Get current and new (after castling) squares 
-    // on which the king & kingside rook are/will be located.
-    Square kingSquare, rookSquare, newKingSquare, newRookSquare;
-    if (turn->getColor() == PieceColor::WHITE){
-        kingSquare = square(0, 4);
-        rookSquare = square(0, 0);
-        newKingSquare = square(0, 2);
-        newRookSquare = square(0, 3);      
-    } 
-    else if(turn->getColor() == PieceColor::BLACK){
-        kingSquare = square(7, 4);
-        rookSquare = square(7, 0);
-        newKingSquare = square(7, 2);
-        newRookSquare = square(7, 3);
-    }
-
-    // Move king
-    Piece* king = board[kingSquare.row][kingSquare.col];
-    board[newKingSquare.row][newKingSquare.col] = king;
-    turn->setKingSq(newKingSquare);
-    board[kingSquare.row][kingSquare.col] = nullptr;
-    king->moved();
-
-    // Move rook
-    Piece* rook = board[rookSquare.row][rookSquare.col];
-    board[newRookSquare.row][newRookSquare.col] = rook;
-    board[rookSquare.row][rookSquare.col] = nullptr;
-    rook->moved();
+
+Move Game::castlingMove(bool shortSide){
+    SquareIndex kingSq = turn->getKingIndex();
+    if (chess960){
+        int color = (turn->getColor() == PieceColor::WHITE) ? 0 : 1;
+        return move(kingSq, squareIndex(rankOf(kingSq), castlingRookCol[color][shortSide ? 0 : 1]));
+    }
+    return move(kingSq, squareIndex(rankOf(kingSq), fileOf(kingSq) + (shortSide ? 2 : -2)));
+}
+
+
+bool Game::isChess960(){
+    return chess960;
+}
+
+
+bool Game::isCastling(const Move& m){
+    Piece* piece = board[rankOf(m.start)][fileOf(m.start)];
+    if (piece == nullptr || tolower(piece->toChar()) != 'k'){
+        return false;
+    }
+    if (chess960){
+        Piece* target = board[rankOf(m.dest)][fileOf(m.dest)];
+        return target != nullptr && target->getColor() == piece->getColor();
+    }
+    return fileOf(m.dest) - fileOf(m.start) == 2 || fileOf(m.dest) - fileOf(m.start) == -2;
 }
 
 
 bool Game::isCheck(){
-    return isAttacked(turn->getKingSq(), board, turn->getColor());
+    return isAttacked(turn->getKingIndex(), board, turn->getColor());
+}
+
+
+std::vector<SquareIndex> Game::attackersOf(SquareIndex target){
+    std::vector<SquareIndex> attackers;
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            if (board[i][j] != nullptr && squareIndex(i, j) != target && board[i][j]->attacks(squareIndex(i, j), target, board)){
+                attackers.push_back(squareIndex(i, j));
+            }
+        }
+    }
+    return attackers;
+}
+
+
+// The attackers of the dest square are found once, by attackersOf(). The exchange is then played out on a copy of the board:
+// each time a piece captures, it leaves its square, and the line from the dest square through that square is followed
+// outwards to the next piece. If that piece is a queen, or a rook on a straight line or bishop on a diagonal, it is an x-ray
+// attacker and joins the exchange.
+//
+// gain[d] is the material won by the side making the d-th capture if the exchange stopped after it.
+// Working back from the last capture, each side only makes its capture if doing so is better than stopping.
+int Game::staticExchange(const Move& m){
+    std::array<std::array<Piece*, 8>, 8> b = board;
+    Piece* attacker = b[rankOf(m.start)][fileOf(m.start)];
+    Piece* victim = b[rankOf(m.dest)][fileOf(m.dest)];
+    std::vector<SquareIndex> attackers = attackersOf(m.dest);
+
+    int gain[64];
+    int d = 0;
+    gain[0] = (victim != nullptr) ? pieceValue(victim) : 0;
+    if (victim == nullptr && tolower(attacker->toChar()) == 'p' && fileOf(m.start) != fileOf(m.dest)){ // En passant
+        gain[0] = PIECE_VALUES[0];
+        b[rankOf(m.start)][fileOf(m.dest)] = nullptr;
+    }
+
+    int onSquare = pieceValue(attacker); // Value of the piece that will be captured next
+    if (m.promotion != '\0'){
+        int promotedValue = PIECE_VALUES[std::string("pnbrqk").find(m.promotion)];
+        gain[0] += promotedValue - PIECE_VALUES[0];
+        onSquare = promotedValue;
+    }
+
+    SquareIndex from = m.start;
+    PieceColor color = attacker->getColor();
+    while (true){
+
+        // The piece that has just captured leaves its square, which may uncover an x-ray attacker behind it
+        b[rankOf(from)][fileOf(from)] = nullptr;
+        attackers.erase(std::remove(attackers.begin(), attackers.end(), from), attackers.end());
+        int dr = (rankOf(from) > rankOf(m.dest)) - (rankOf(from) < rankOf(m.dest));
+        int dc = (fileOf(from) > fileOf(m.dest)) - (fileOf(from) < fileOf(m.dest));
+        bool aligned = rankOf(from) == rankOf(m.dest) || fileOf(from) == fileOf(m.dest) || abs(rankOf(from) - rankOf(m.dest)) == abs(fileOf(from) - fileOf(m.dest));
+        if (aligned){
+            int i = rankOf(from) + dr, j = fileOf(from) + dc;
+            while (i >= 0 && i < 8 && j >= 0 && j < 8 && b[i][j] == nullptr){
+                i += dr;
+                j += dc;
+            }
+            if (i >= 0 && i < 8 && j >= 0 && j < 8){
+                char type = tolower(b[i][j]->toChar());
+                bool straight = dr == 0 || dc == 0;
+                if (type == 'q' || (type == 'r' && straight) || (type == 'b' && !straight)){
+                    attackers.push_back(squareIndex(i, j));
+                }
+            }
+        }
+
+        // The other side recaptures with its least valuable attacker, if it has one
+        color = (color == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+        int next = -1;
+        for (size_t k = 0; k < attackers.size(); k++){
+            Piece* piece = b[rankOf(attackers[k])][fileOf(attackers[k])];
+            if (piece->getColor() == color && (next < 0 || pieceValue(piece) < pieceValue(b[rankOf(attackers[next])][fileOf(attackers[next])]))){
+                next = k;
+            }
+        }
+        if (next < 0 || d >= 63){
+            break;
+        }
+
+        d++;
+        gain[d] = onSquare - gain[d-1];
+        if (std::max(-gain[d-1], gain[d]) < 0){ // This capture can't change the outcome, whether or not it is made
+            d--;
+            break;
+        }
+        from = attackers[next];
+        onSquare = pieceValue(b[rankOf(from)][fileOf(from)]);
+    }
+
+    while (d > 0){
+        gain[d-1] = -std::max(-gain[d-1], gain[d]);
+        d--;
+    }
+    return gain[0];
 }
 
 
@@ -330,47 +1058,226 @@ bool Game::isCheck(){
 // So this algorithm involves scanning the entire board, checking if there is a legal move the player could make
 // that does not result in check. If not, whether it is checkmate or stalemate is determined by whether the player is in check currently.
 GameState Game::getGameState(){
+    CHESS_TIME(GET_GAME_STATE);
+
+    // If a legal move exists (i.e. one that does not result in, or perpetuate, a check), game is still contested, unless it is drawn.
+    // Only whether there is one matters, so count them rather than generating them, unless they have been already.
+    if (legalSetValid ? numLegalPairs > 0 : countLegalMoves() > 0){
+        return drawState();
+    }
+
+    // If no move was found that could break the check
+    // Checkmate if player is currently in check, otherwise stalemate
+    return (isCheck()) ? GameState::CHECKMATE : GameState::STALEMATE;
+}
+
+
+uint64_t Game::getHash(){
+    return hash;
+}
+
+
+uint64_t Game::getPawnHash(){
+    return pawnHash;
+}
+
+
+int Game::getHalfmoveClock(){
+    return halfmoveClock;
+}
+
+
+// Each move record holds the hash of the position before that move. Positions with the same player to move
+// are every 2nd record back from the last, and we only need to go back as far as the last pawn move or capture.
+int Game::repetitionCount(){
+    int count = 1;
+    int n = history.size();
+    for (int k = 2; k <= halfmoveClock && k <= n; k += 2){
+        if (history[n - k].prevHash == hash){
+            count++;
+        }
+    }
+    return count;
+}
+
+
+bool Game::isInsufficientMaterial(){
+    int minors = 0; // Knights and bishops
+    int knights = 0;
+    bool bishopOnLight = false, bishopOnDark = false;
 
-    // Scan entire board, checking, for each friendly piece, 
-    // if that piece has a legal move that does not result in, or perpetuate, a check 
     for (int i = 0; i < 8; i++){
         for (int j = 0; j < 8; j++){
-            
-            if ( board[i][j] != nullptr && board[i][j]->getColor() == turn->getColor() ){ // If square contains player's piece
-                
-                // Get all legal destinations for piece at board[i][j]
-                Piece* pieceToMove = board[i][j];
-                Square sqAtIJ = square(i,j); 
-                std::vector<Square> dests = pieceToMove->legalDests(sqAtIJ, board);
-
-                // Iterate through all legal dests for pieceToMove.
-                for (auto dest: dests){
-                    
-                    // If a legal smove is found that does not result in check, game is still contested
-                    if (!moveResultsInCheck(sqAtIJ, dest)){
-                        return GameState::CONTESTED;
-                    }
+            if (board[i][j] == nullptr){
+                continue;
+            }
+            switch (tolower(board[i][j]->toChar())){
+                case 'k':
+                    break;
+                case 'n':
+                    minors++;
+                    knights++;
+                    break;
+                case 'b':
+                    minors++;
+                    // a1 (row 0, col 0) is a dark square, so squares where row + col is even are dark
+                    if ((i + j) % 2 == 0){ bishopOnDark = true; } else { bishopOnLight = true; }
+                    break;
+                default: // Pawn, rook or queen - always enough to mate
+                    return false;
+            }
+        }
+    }
+
+    if (minors <= 1){
+        return true;
+    }
+    return knights == 0 && !(bishopOnLight && bishopOnDark);
+}
+
+
+GameState Game::drawState(){
+    if (isInsufficientMaterial()){
+        return GameState::INSUFFICIENT_MATERIAL;
+    }
+    if (repetitionCount() >= 3){
+        return GameState::THREEFOLD_REPETITION;
+    }
+    if (halfmoveClock >= 100){
+        return GameState::FIFTY_MOVE_RULE;
+    }
+    return GameState::CONTESTED;
+}
+
+
+int Game::castlingRights(){
+    int rights = 0;
+    for (int c = 0; c < 2; c++){
+        int row = (c == 0) ? 0 : 7;
+        Piece* king = board[row][castlingKingCol[c]];
+        char kingChar = (c == 0) ? 'K' : 'k';
+        char rookChar = (c == 0) ? 'R' : 'r';
+        if (king == nullptr || king->toChar() != kingChar || king->getHasMoved()){
+            continue;
+        }
+        for (int side = 0; side < 2; side++){
+            Piece* rook = board[row][castlingRookCol[c][side]];
+            if (rook != nullptr && rook->toChar() == rookChar && !rook->getHasMoved()){
+                rights |= 1 << (2*c + side);
+            }
+        }
+    }
+    return rights;
+}
+
+
+uint64_t Game::castlingKey(int rights){
+    uint64_t key = 0;
+    for (int i = 0; i < 4; i++){
+        if (rights & (1 << i)){
+            key ^= zobristKeys().castling[i];
+        }
+    }
+    return key;
+}
+
+
+uint64_t Game::enPassantKey(){
+    if (enPassantPawn == nullptr){
+        return 0;
+    }
+    for (int colDisp: {1, -1}){
+        int col = fileOf(enPassantSq) + colDisp;
+        if (col < 0 || col > 7){
+            continue;
+        }
+        Piece* beside = board[rankOf(enPassantSq)][col];
+        CHESS_COUNT(DYNAMIC_CASTS);
+        if (dynamic_cast<Pawn*>(beside) && beside->getColor() != enPassantPawn->getColor()){
+            return zobristKeys().enPassantFile[fileOf(enPassantSq)];
+        }
+    }
+    return 0;
+}
+
+
+void Game::setLegalSet(const std::vector<Move>& moves){
+    legalSet.reset();
+    for (auto& m: moves){
+        legalSet.set(m.start*64 + m.dest);
+    }
+    numLegalPairs = legalSet.count();
+    legalSetValid = true;
+}
+
+
+// legalMoves() sets the legal move set as it goes
+void Game::updateLegalSet(){
+    if (!legalSetValid){
+        legalMoves();
+    }
+}
+
+
+uint64_t Game::computeHash(){
+    const ZobristKeys& keys = zobristKeys();
+    uint64_t res = 0;
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            if (board[i][j] != nullptr){
+                res ^= keys.pieces[zobristPieceIndex(board[i][j])][i*8 + j];
+            }
+        }
+    }
+    if (turn == black){
+        res ^= keys.blackToMove;
+    }
+    return res ^ castlingKey(castlingRights()) ^ enPassantKey();
+}
+
+
+uint64_t Game::computePawnHash(){
+    const ZobristKeys& keys = zobristKeys();
+    uint64_t res = 0;
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            if (board[i][j] != nullptr){
+                int index = zobristPieceIndex(board[i][j]);
+                if (index % 6 == 0){
+                    res ^= keys.pieces[index][i*8 + j];
                 }
             }
         }
     }
-    // If no move was found that could break the check
-    // Checkmate if player is currently in check, otherwise stalemate
-    return (isCheck()) ? GameState::CHECKMATE : GameState::STALEMATE;
+    return res;
 }
 
 
 // To determine if a move results in a check for the player making the move,
 // we simulate the move taking place on the board, call isCheck(), 
 // then revert the board back to it's state prior to simulating the move.
-bool Game::moveResultsInCheck(const Square& start, const Square& dest){
-
-    Piece *pieceToMove = board[start.row][start.col];
-    Piece *pieceAtDest = board[dest.row][dest.col];
+bool Game::moveResultsInCheck(SquareIndex start, SquareIndex dest){
+    CHESS_TIME(MOVE_RESULTS_IN_CHECK);
+    CHESS_COUNT(MOVE_RESULTS_IN_CHECK);
+
+    Piece *pieceToMove = board[rankOf(start)][fileOf(start)];
+    Piece *pieceAtDest = board[rankOf(dest)][fileOf(dest)];
+
+    // En passant also removes the captured pawn from beside the start square
+    SquareIndex epSq = squareIndex(rankOf(start), fileOf(dest));
+    Piece *epCaptured = nullptr;
+    if (pieceAtDest == nullptr && fileOf(start) != fileOf(dest)){
+        CHESS_COUNT(DYNAMIC_CASTS);
+        if (dynamic_cast<Pawn*>(pieceToMove)){
+            epCaptured = board[rankOf(epSq)][fileOf(epSq)];
+            board[rankOf(epSq)][fileOf(epSq)] = nullptr;
+        }
+    }
 
     // Simulate move taking place
-    board[dest.row][dest.col] = pieceToMove;
-    board[start.row][start.col] = nullptr;
+    board[rankOf(dest)][fileOf(dest)] = pieceToMove;
+    board[rankOf(start)][fileOf(start)] = nullptr;
+    CHESS_COUNT(DYNAMIC_CASTS);
     if ( dynamic_cast<King*>(pieceToMove) ){  // If king is being moved, update player's kingSq attribute
         turn->setKingSq(dest);
     }
@@ -378,8 +1285,12 @@ bool Game::moveResultsInCheck(const Square& start, const Square& dest){
     bool check = isCheck();
 
     // Before returning, revert board & kingSq (if necessary) back to previous state that in was in before simulating the move
-    board[start.row][start.col] = pieceToMove;
-    board[dest.row][dest.col] = pieceAtDest;
+    board[rankOf(start)][fileOf(start)] = pieceToMove;
+    board[rankOf(dest)][fileOf(dest)] = pieceAtDest;
+    if (epCaptured != nullptr){
+        board[rankOf(epSq)][fileOf(epSq)] = epCaptured;
+    }
+    CHESS_COUNT(DYNAMIC_CASTS);
     if ( dynamic_cast<King*>(pieceToMove) ){
         turn->setKingSq(start);
     }
@@ -388,12 +1299,19 @@ bool Game::moveResultsInCheck(const Square& start, const Square& dest){
 }
 
 
-void Game::toggleBackgroundColor(){
-    static bool isBlack = true; // Tracks whether square background painter is currently black 
-    if (isBlack){
-        std::cout << "\033[48;5;231m"; // Turn painter white
-    } else { 
-        std::cout << "\033[0m"; // Turn painter back to black
+bool Game::moveResultsInCheck(const Square& start, const Square& dest){
+    return moveResultsInCheck(squareIndex(start), squareIndex(dest));
+}
+
+
+std::string gameStateToStr(GameState state){
+    switch (state){
+        case GameState::CONTESTED: return "CONTESTED";
+        case GameState::CHECKMATE: return "CHECKMATE";
+        case GameState::STALEMATE: return "STALEMATE";
+        case GameState::INSUFFICIENT_MATERIAL: return "INSUFFICIENT_MATERIAL";
+        case GameState::THREEFOLD_REPETITION: return "THREEFOLD_REPETITION";
+        case GameState::FIFTY_MOVE_RULE: return "FIFTY_MOVE_RULE";
     }
-    isBlack = !isBlack;
-}
\ No newline at end of file
+    return "";
+}
@@ -1,19 +1,53 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <bitset>
+#include <iostream>
+#include <cstdint>
 
 #include "piece.hpp"
 #include "square.hpp"
 #include "player.hpp"
+#include "move.hpp"
+#include "piecepool.hpp"
 
 #pragma once
 
 
+class Pawn;
+
+
 // Type returned by getGameState()
 enum class GameState{
     CONTESTED,
     CHECKMATE,
-    STALEMATE
+    STALEMATE,
+    INSUFFICIENT_MATERIAL, // Neither player has enough pieces left to give checkmate
+    THREEFOLD_REPETITION, // The same position has occurred 3 times
+    FIFTY_MOVE_RULE // 50 moves by each player without a pawn move or capture
+};
+
+
+// Returns the name of a game state, as written in the enum (e.g. "CHECKMATE")
+std::string gameStateToStr(GameState state);
+
+
+// Snapshot of a game's position, returned by Game::snapshot(): everything needed to set a game up in the position again.
+// It is a plain value of about 100 bytes, so it is cheap to copy, e.g. to give each search thread its own game,
+// or to set a game back to a node's position (with Game::restore()) rather than taking moves back.
+// The moves that led to the position aren't kept, so it doesn't know which positions would be repetitions.
+struct Position{
+    std::array<char, 64> pieces; // FEN letter of the piece on square row*8 + col, or '\0' if empty
+    uint64_t unmoved;            // Bit row*8 + col is set if the piece on that square hasn't moved
+    PieceColor turn;
+    int8_t enPassantSq;          // Square (row*8 + col) of the pawn that can be captured en passant, or -1
+    bool chess960;
+    int8_t castlingKingCol[2];   // As in Game, indexed by PieceColor
+    int8_t castlingRookCol[2][2];
+    int halfmoveClock;
+    int ply;                     // Plies played before the position, for the FEN fullmove number
+    uint64_t hash;
+    uint64_t pawnHash;
 };
 
 
@@ -26,12 +60,68 @@ class Game {
         Game(Player* white, Player* black);
 
 
-        // Returns the board
-        std::array<std::array<Piece*, 8>, 8> getBoard();
+        // Sets up the board in the position given by a FEN (Forsyth-Edwards Notation) string
+        // e.g. "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"
+        // Castling rights are set up through the kings' and rooks' hasMoved flags, and the en passant square
+        // through the flag of the pawn that has just advanced 2 squares.
+        //
+        // The castling field can use X-FEN (KQkq, with a file letter instead for a rook that isn't the outermost one on its side)
+        // or Shredder-FEN (the file letters of the castling rooks, e.g. "HAha"). Castling from anywhere other than the standard
+        // squares makes the game a Chess960 game, as does passing chess960 as true.
+        // THIS ASSUMES THAT THE FEN STRING IS VALID. USE ISVALIDFEN() TO CHECK FIRST.
+        Game(Player* white, Player* black, const std::string& fen, bool chess960 = false);
+
+
+        // Sets up the board in one of the 960 Chess960 (Fischer Random) starting positions, numbered 0-959 as per
+        // Scharnagl's numbering (position 518 is the standard starting position)
+        Game(Player* white, Player* black, int chess960Position);
+
+
+        // Sets up the board in a position taken with snapshot(), from this or any other game.
+        // The players' king squares are set from it, so give each copy of a game its own players.
+        Game(Player* white, Player* black, const Position& position);
+
+
+        // The game's pieces are owned by its piece pool, and freed with it.
+        // As the game also updates its players, it can't be copied; copy a snapshot() instead.
+        Game(const Game&) = delete;
+        Game& operator=(const Game&) = delete;
+
+
+        // Returns a snapshot of the current position
+        Position snapshot();
+
+
+        // Sets the game up in a position taken with snapshot(), as if it had been set up in it.
+        // The move history is cleared (so moves before it can't be taken back), and the pieces are reused rather than reallocated.
+        void restore(const Position& position);
+
+
+        // Check if a FEN string is valid: it must have 4 to 6 space-separated fields, describe all 8 ranks
+        // with 8 squares each, have exactly 1 king of each color, and have valid turn, castling and en passant fields.
+        static bool isValidFen(const std::string& fen);
 
 
-        // Prints the board
-        void printBoard();
+        // Returns the current position as a FEN string.
+        // In a Chess960 game the castling rights are in X-FEN, unless shredder is true, when they are in Shredder-FEN.
+        std::string toFen(bool shredder = false);
+
+
+        // Returns the FEN of one of the Chess960 starting positions (see above), with X-FEN castling rights
+        static std::string chess960Fen(int position);
+
+
+        // Determines if the game is a Chess960 game. In a Chess960 game, castling is a move of the king onto its own rook's square
+        // (which works wherever they started), rather than the king moving 2 squares.
+        bool isChess960();
+
+
+        // Determines if a legal move is castling
+        bool isCastling(const Move& m);
+
+
+        // Returns the board
+        std::array<std::array<Piece*, 8>, 8> getBoard();
 
 
         // If currently white's turn, sets turn to black, and vice versa.
@@ -42,14 +132,51 @@ class Game {
         Player* getTurn();
 
 
-        // Moves a piece from start square to dest (destination) square
+        // Returns the player with the given color
+        Player* getPlayer(PieceColor color);
+
+
+        // Moves a piece from start square to dest (destination) square, given as square indexes or Squares
         // If a piece is present at the dest square, that piece is removed #
         // and replaced with the piece being moved.
-        // THIS ASSUMES THAT THE MOVE IS LEGAL. USE ISLEGALMOVE() TO CHECK FIRST.
-        void movePiece(const Square& start, const Square& dest);
+        // A king moving 2 squares sideways (or in Chess960 onto its own rook) castles, and a pawn moving diagonally onto an empty square captures en passant.
+        // If the move is a pawn promotion, the pawn is promoted to promoteTo: 'q' (queen), 'r' (rook), 'b' (bishop) or 'n' (knight).
+        // promoteTo is ignored for all other moves.
+        // THIS ASSUMES THAT THE MOVE IS LEGAL. USE ISVALIDMOVE() TO CHECK FIRST.
+        void movePiece(SquareIndex start, SquareIndex dest, char promoteTo = '\0');
+        void movePiece(const Square& start, const Square& dest, char promoteTo = '\0');
+
+
+        // Returns true if moving the piece at the start square to the dest square (as square indexes or Squares) would be a pawn promotion
+        // i.e. the piece is a pawn and the dest square is on the last rank.
+        bool isPromotion(SquareIndex start, SquareIndex dest);
+        bool isPromotion(const Square& start, const Square& dest);
+
+
+        // Returns every legal move for the player whose turn it is, including castling.
+        // A pawn promotion is returned as 4 moves, one for each piece the pawn can be promoted to.
+        std::vector<Move> legalMoves();
+
+
+        // Returns the number of legal moves for the player whose turn it is, i.e. legalMoves().size(), without generating them.
+        // For counting nodes (e.g. the last ply of perft) and mobility, where only the number matters.
+        int countLegalMoves();
 
 
-        // Checks if a move, by the player whose turn it is, from start square to destination (dest) square is valid
+        // Makes a move (as returned by legalMoves()) for the player whose turn it is, with movePiece(), then toggles the turn.
+        // THIS ASSUMES THAT THE MOVE IS LEGAL.
+        void makeMove(const Move& move);
+
+
+        // Takes back the last move made with makeMove(), restoring the position exactly as it was before the move.
+        void unmakeMove();
+
+
+        // Checks if a move, by the player whose turn it is, from start square to destination (dest) square is valid.
+        // The squares can be given as square indexes or Squares.
+        // Castling, as the king moving 2 squares towards the rook (or onto it, in Chess960), is valid if the player can castle that way.
+        // Answered from the legal move set, which is worked out once per position.
+        bool isValidMove(SquareIndex start, SquareIndex dest);
         bool isValidMove(const Square& start, const Square& dest);
         
 
@@ -75,20 +202,110 @@ class Game {
         bool isCheck();
 
 
-        // Determines if the player whose turn it is in checkmate or stalemate,
-        // or if the game is still being played (contested) 
+        // Determine if the player whose turn it is making a move
+        // from start to dests results in them putting themselves in check. The squares can be given as square indexes or Squares.
+        bool moveResultsInCheck(SquareIndex start, SquareIndex dest);
+        bool moveResultsInCheck(const Square& start, const Square& dest);
+
+
+        // Returns the squares of all the pieces (of both colors) that attack the target square directly,
+        // i.e. not counting pieces lined up behind other attackers.
+        std::vector<SquareIndex> attackersOf(SquareIndex target);
+
+
+        // Static exchange evaluation (SEE) of a capture by the player whose turn it is: the material they gain, in centipawns
+        // (using the values in eval.hpp), if both players keep recapturing on the dest square with their least valuable attacker
+        // for as long as it pays. Attackers lined up behind others (x-rays, e.g. a queen behind a rook) join in as the pieces
+        // in front of them capture. Pins are not taken into account.
+        // A move onto an empty square (other than en passant) is evaluated as whether the piece would be lost there.
+        int staticExchange(const Move& m);
+
+
+        // Determines if the player whose turn it is in checkmate or stalemate, if the game is drawn by
+        // insufficient material, threefold repetition or the fifty-move rule, or if the game is still being played (contested).
+        // Checkmate and stalemate take precedence over the other draws.
         GameState getGameState();
 
 
-    private:
+        // Returns the Zobrist hash of the current position (see zobrist.hpp).
+        // Positions with the same pieces on the same squares, the same player to move, and the same
+        // castling and en passant possibilities have the same hash.
+        uint64_t getHash();
+
+
+        // Returns the Zobrist hash of the pawns alone (see zobrist.hpp), for caching pawn structure evaluation.
+        // Only changes when a pawn moves, is captured or is promoted.
+        uint64_t getPawnHash();
+
+
+        // Returns the number of plies (half-moves) since the last pawn move or capture
+        int getHalfmoveClock();
 
-        // Determine if the player whose turn it is making a move
-        // from start to dests results in them putting themselves in check.
-        bool moveResultsInCheck(const Square& start, const Square& dest);
 
-        // Used in printBoard() to paint white and black squares in terminal
-        // If square background color is white, switches it to black, and vice versa
-        void toggleBackgroundColor();
+        // Returns the number of times the current position has occurred in the game, including now.
+        // Only positions since the last pawn move or capture are compared, as no earlier position can occur again.
+        int repetitionCount();
+
+
+        // Determines if neither player has enough material left to give checkmate:
+        // king against king, king and a single bishop or knight against king,
+        // or kings and any number of bishops which are all on squares of the same color.
+        bool isInsufficientMaterial();
+
+
+    private:
+
+        // Everything needed to take back a move made by movePiece()
+        struct MoveRecord{
+            Move move;
+            Piece* moved; // The piece that was moved (for a promotion, the pawn)
+            bool movedHadMoved; // moved's hasMoved flag before the move
+            Piece* captured; // The captured piece, or nullptr if the move was not a capture
+            SquareIndex capturedSq; // Square captured piece was on (differs from move.dest for en passant)
+            Piece* promotedTo; // The piece the pawn was promoted to, or nullptr if the move was not a promotion
+            Piece* castledRook; // The rook that was moved if the move was castling, otherwise nullptr
+            SquareIndex rookStart;
+            SquareIndex rookDest;
+            SquareIndex kingDest; // The square the king ends up on when castling (differs from move.dest in Chess960)
+            Pawn* prevEnPassantPawn; // enPassantPawn before the move
+            SquareIndex prevEnPassantSq; // enPassantSq before the move
+            uint64_t prevHash; // Hash of the position before the move
+            uint64_t prevPawnHash; // Pawn hash of the position before the move
+            int prevHalfmoveClock; // halfmoveClock before the move
+        };
+
+        // Returns the move that castles short (kingside) or long (queenside) for the player whose turn it is
+        Move castlingMove(bool shortSide);
+
+        // Returns the castling rights that are still available (as per the kings' and rooks' hasMoved flags),
+        // as a bitmask: 1 white short, 2 white long, 4 black short, 8 black long
+        int castlingRights();
+
+        // Returns the XOR of the Zobrist keys for the given castling rights
+        uint64_t castlingKey(int rights);
+
+        // Returns the Zobrist key for the current en passant file. This is 0 if no pawn can be captured en passant,
+        // or if there is no opposition pawn beside it to capture it, as then the position is the same as if there were no en passant square.
+        uint64_t enPassantKey();
+
+        // Calculates the hash of the current position from scratch
+        uint64_t computeHash();
+
+        // Calculates the pawn hash of the current position from scratch
+        uint64_t computePawnHash();
+
+        // Returns the draw the game is in, given that the player whose turn it is has a legal move,
+        // or CONTESTED if not drawn
+        GameState drawState();
+
+        // Sets the legal move set from a list of the current position's legal moves
+        void setLegalSet(const std::vector<Move>& moves);
+
+        // Works out the legal move set, if it hasn't been since the position last changed
+        void updateLegalSet();
+
+        // Every piece the game has used, including captured and promoted pieces and spares
+        PiecePool pieces;
 
         // 2-dimensional 8x8 array representing the board
         // Each empty square on the board is occupied by a nullptr
@@ -102,4 +319,46 @@ class Game {
 
         // Points to player whose turn it is
         Player* turn;
+
+        // Pawn that can currently be captured en passant (i.e. that advanced 2 squares on the last move), or nullptr.
+        Pawn* enPassantPawn;
+
+        // Square that enPassantPawn is on
+        SquareIndex enPassantSq;
+
+        // Hash of the current position, updated by movePiece() and toggleTurn()
+        uint64_t hash;
+
+        // Hash of the pawns alone, updated by movePiece() only when a pawn moves or is captured
+        uint64_t pawnHash;
+
+        // Number of plies since the last pawn move or capture
+        int halfmoveClock;
+
+        // Whether castling is encoded as the king moving onto its own rook (see isChess960())
+        bool chess960;
+
+        // Columns the kings start on, and the columns of the rooks they can castle with, indexed by PieceColor
+        // then 0 for short and 1 for long. Standard chess has the kings on column 4 and the rooks on columns 7 and 0.
+        int castlingKingCol[2];
+        int castlingRookCol[2][2];
+
+        // Records of the moves made so far, most recent last.
+        // Captured pieces are kept here rather than being deleted, so that moves can be taken back.
+        std::vector<MoveRecord> history;
+
+        // Number of plies (half-moves) played before the position the game was set up in. Used for the FEN fullmove number.
+        int startPly;
+
+        // Legal move set of the current position: bit start*64 + dest is set if the player whose turn it is
+        // can move from start to dest (a promotion sets a single bit for all 4 pieces).
+        // Worked out when first needed after the position changes, or as a by-product of legalMoves().
+        std::bitset<64*64> legalSet;
+
+        // Number of bits set in legalSet
+        int numLegalPairs;
+
+        // False once the position has changed since legalSet was worked out.
+        // Cleared by movePiece(), unmakeMove() and toggleTurn().
+        bool legalSetValid;
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <iomanip>
+#include <chrono>
+
+#include "instrument.hpp"
+
+#if defined(CHESS_INSTRUMENT) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+
+static const char* COUNTER_NAMES[] = {
+    "isAttacked",
+    "moveResultsInCheck",
+    "legalDests (pawn)",
+    "legalDests (knight)",
+    "legalDests (bishop)",
+    "legalDests (rook)",
+    "legalDests (queen)",
+    "legalDests (king)",
+    "vectors allocated",
+    "dynamic_casts"
+};
+
+
+static const char* TIMER_NAMES[] = {
+    "isAttacked",
+    "moveResultsInCheck",
+    "legalDests",
+    "legalMoves",
+    "countLegalMoves",
+    "isValidMove",
+    "getGameState"
+};
+
+
+Profile::Profile(){
+    counts.fill(0);
+    calls.fill(0);
+    cycles.fill(0);
+}
+
+
+Profile& Profile::operator+=(const Profile& other){
+    for (size_t i = 0; i < counts.size(); i++){
+        counts[i] += other.counts[i];
+    }
+    for (size_t i = 0; i < calls.size(); i++){
+        calls[i] += other.calls[i];
+        cycles[i] += other.cycles[i];
+    }
+    return *this;
+}
+
+
+#ifdef CHESS_INSTRUMENT
+
+static thread_local Profile currentProfile;
+
+
+Profile& threadProfile(){
+    return currentProfile;
+}
+
+
+// Falls back to a nanosecond clock where there is no cycle counter to read
+uint64_t readCycles(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+bool instrumentationEnabled(){
+    return true;
+}
+
+
+Profile takeProfile(){
+    Profile profile = currentProfile;
+    currentProfile = Profile();
+    return profile;
+}
+
+#else
+
+bool instrumentationEnabled(){
+    return false;
+}
+
+
+Profile takeProfile(){
+    return Profile();
+}
+
+#endif
+
+
+void writeProfile(std::ostream& out, const Profile& profile, const std::string& title){
+    out << "PROFILE: " << title << std::endl;
+    if (!instrumentationEnabled()){
+        out << "  INSTRUMENTATION DISABLED (BUILD WITH -DCHESS_INSTRUMENT=ON)" << std::endl;
+        return;
+    }
+
+    out << "  COUNTERS" << std::endl;
+    for (size_t i = 0; i < profile.counts.size(); i++){
+        out << "    " << std::left << std::setw(24) << COUNTER_NAMES[i] << std::right << std::setw(16) << profile.counts[i] << std::endl;
+    }
+
+    out << "  TIMERS" << std::setw(36) << "CALLS" << std::setw(18) << "CYCLES" << std::setw(14) << "CYCLES/CALL" << std::endl;
+    for (size_t i = 0; i < profile.calls.size(); i++){
+        uint64_t perCall = (profile.calls[i] > 0) ? profile.cycles[i] / profile.calls[i] : 0;
+        out << "    " << std::left << std::setw(24) << TIMER_NAMES[i] << std::right << std::setw(16) << profile.calls[i]
+            << std::setw(18) << profile.cycles[i] << std::setw(14) << perCall << std::endl;
+    }
+}
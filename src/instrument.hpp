@@ -0,0 +1,110 @@
+#include <cstdint>
+#include <array>
+#include <string>
+#include <ostream>
+
+#pragma once
+
+
+// Compile-time-optional instrumentation of the rules engine's hot paths.
+//
+// When CHESS_INSTRUMENT is defined (cmake -DCHESS_INSTRUMENT=ON), the CHESS_COUNT... and CHESS_TIME macros
+// placed in those paths add to a profile kept for the calling thread.
+// Otherwise the macros expand to nothing, and the profile is always empty.
+//
+// A game is played on a single thread, so taking the thread's profile at the start and end of a game gives the game's profile.
+// Profiles of several games can be added together to give a profile for a whole batch.
+
+
+// Events that are counted
+enum class Counter{
+    IS_ATTACKED,            // isAttacked() calls
+    MOVE_RESULTS_IN_CHECK,  // Moves simulated by Game::moveResultsInCheck()
+    LEGAL_DESTS_PAWN,       // legalDests() calls, per piece type.
+    LEGAL_DESTS_KNIGHT,     // Note that Queen::legalDests() is implemented with Rook::legalDests() and Bishop::legalDests(),
+    LEGAL_DESTS_BISHOP,     // so each queen call also counts as a rook and a bishop call.
+    LEGAL_DESTS_ROOK,
+    LEGAL_DESTS_QUEEN,
+    LEGAL_DESTS_KING,
+    VECTORS_ALLOCATED,      // Vectors of squares or moves built by move generation
+    DYNAMIC_CASTS,          // dynamic_casts of pieces in Game and Pawn
+    NUM_COUNTERS
+};
+
+
+// Functions that are timed. Times are inclusive, e.g. the time of a getGameState() call includes the time of the
+// moveResultsInCheck() calls it makes, which include the time of the isAttacked() calls they make.
+enum class Timer{
+    IS_ATTACKED,
+    MOVE_RESULTS_IN_CHECK,
+    LEGAL_DESTS,
+    LEGAL_MOVES,
+    COUNT_LEGAL_MOVES,
+    IS_VALID_MOVE,
+    GET_GAME_STATE,
+    NUM_TIMERS
+};
+
+
+struct Profile{
+    std::array<uint64_t, (int)Counter::NUM_COUNTERS> counts;
+    std::array<uint64_t, (int)Timer::NUM_TIMERS> calls;  // Number of timed calls, per timer
+    std::array<uint64_t, (int)Timer::NUM_TIMERS> cycles; // Total CPU cycles spent in timed calls, per timer
+
+    Profile();
+
+    Profile& operator+=(const Profile& other);
+};
+
+
+// True if the instrumentation has been compiled in
+bool instrumentationEnabled();
+
+
+// Returns the calling thread's profile, and resets it
+Profile takeProfile();
+
+
+// Writes a human-readable report of profile to out, headed by title
+void writeProfile(std::ostream& out, const Profile& profile, const std::string& title);
+
+
+#ifdef CHESS_INSTRUMENT
+
+// Profile of the calling thread, which the macros add to
+Profile& threadProfile();
+
+// Current value of the CPU's cycle counter
+uint64_t readCycles();
+
+// Adds the cycles between its construction and destruction to a timer
+class ScopedTimer{
+
+    public:
+
+        ScopedTimer(Timer timer) : timer(timer), start(readCycles()) {}
+
+        ~ScopedTimer(){
+            Profile& profile = threadProfile();
+            profile.calls[(int)timer]++;
+            profile.cycles[(int)timer] += readCycles() - start;
+        }
+
+    private:
+
+        Timer timer;
+
+        uint64_t start;
+};
+
+#define CHESS_COUNT(counter) (threadProfile().counts[(int)Counter::counter]++)
+#define CHESS_COUNT_BY(counter, n) (threadProfile().counts[(int)Counter::counter] += (n))
+#define CHESS_TIME(timer) ScopedTimer chessScopedTimer(Timer::timer)
+
+#else
+
+#define CHESS_COUNT(counter) ((void)0)
+#define CHESS_COUNT_BY(counter, n) ((void)0)
+#define CHESS_TIME(timer) ((void)0)
+
+#endif
@@ -0,0 +1,19 @@
+#include <string>
+#include <istream>
+#include <ostream>
+
+#include "io.hpp"
+
+
+StreamIO::StreamIO(std::istream& in, std::ostream& out) : in(in), out(out) {}
+
+
+void StreamIO::write(const std::string& text){
+    out << text;
+    out.flush(); // Flush so that prompts are shown before waiting for input
+}
+
+
+bool StreamIO::read(std::string& token){
+    return (bool)(in >> token);
+}
\ No newline at end of file
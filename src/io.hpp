@@ -0,0 +1,42 @@
+#include <string>
+#include <istream>
+#include <ostream>
+
+#pragma once
+
+
+// Interface through which the interactive game talks to its players.
+// The command-line game uses StreamIO on the terminal; other front ends (e.g. a network session, or a scripted test)
+// can provide their own implementation.
+class GameIO{
+
+    public:
+
+        virtual ~GameIO(){}
+
+        // Displays text to the players. Text is shown exactly as given, so it should include any newlines.
+        virtual void write(const std::string& text) = 0;
+
+        // Reads the next whitespace-delimited token of input into token.
+        // Returns false if there is no more input (e.g. the player has disconnected).
+        virtual bool read(std::string& token) = 0;
+};
+
+
+// GameIO over a pair of streams, e.g. std::cin and std::cout.
+class StreamIO : public GameIO{
+
+    public:
+
+        StreamIO(std::istream& in, std::ostream& out);
+
+        void write(const std::string& text) override;
+
+        bool read(std::string& token) override;
+
+    private:
+
+        std::istream& in;
+
+        std::ostream& out;
+};
\ No newline at end of file
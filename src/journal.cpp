@@ -0,0 +1,432 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+
+#include "journal.hpp"
+#include "packedgame.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+
+
+static const char SNAPSHOT_MAGIC[] = "CSJ1";
+
+// Bytes in a record before its payload: checksum, type, game id and payload length
+static const size_t RECORD_HEADER = 11;
+
+
+static uint32_t fnv1a(const char* data, size_t length){
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++){
+        hash = (hash ^ (uint8_t)data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+
+static void putLE(std::string& out, uint64_t value, int numBytes){
+    for (int i = 0; i < numBytes; i++){
+        out += (char)((value >> (8*i)) & 0xFF);
+    }
+}
+
+
+static uint64_t getLE(const char* data, int numBytes){
+    uint64_t value = 0;
+    for (int i = 0; i < numBytes; i++){
+        value |= (uint64_t)(uint8_t)data[i] << (8*i);
+    }
+    return value;
+}
+
+
+// Writes all of data, carrying on after partial writes
+static bool writeAll(int fd, const std::string& data){
+    size_t done = 0;
+    while (done < data.size()){
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n <= 0){
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+
+// fdatasync() skips flushing metadata that isn't needed to read the data back (such as the modification time)
+static bool syncFile(int fd){
+#ifdef __linux__
+    return fdatasync(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+
+// A new file's directory entry is only durable once the directory itself has been synced
+static bool syncDir(const std::string& dir){
+    int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+
+static bool readFile(const std::string& path, std::string& contents){
+    std::ifstream in(path, std::ios::binary);
+    if (!in){
+        return false;
+    }
+    std::ostringstream stream;
+    stream << in.rdbuf();
+    contents = stream.str();
+    return true;
+}
+
+
+MoveJournal::MoveJournal(const std::string& dir, int shard, uint64_t snapshotRecords) : dir(dir), shard(shard), snapshotRecords(snapshotRecords) {
+    fd = -1;
+    generation = 0;
+    recordsSinceSnapshot = 0;
+    records = 0;
+    commits = 0;
+    bytesWritten = 0;
+}
+
+
+MoveJournal::~MoveJournal(){
+    if (fd >= 0){
+        commit();
+        close(fd);
+    }
+}
+
+
+std::string MoveJournal::snapshotPath(){
+    return dir + "/shard" + std::to_string(shard) + ".snap";
+}
+
+
+std::string MoveJournal::logPath(uint64_t gen){
+    return dir + "/shard" + std::to_string(shard) + "." + std::to_string(gen) + ".log";
+}
+
+
+std::vector<uint64_t> MoveJournal::logGenerations(){
+    std::vector<uint64_t> generations;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr){
+        return generations;
+    }
+    std::string prefix = "shard" + std::to_string(shard) + ".";
+    while (dirent* entry = readdir(d)){
+        std::string name = entry->d_name;
+        if (name.size() > prefix.size() + 4 && name.compare(0, prefix.size(), prefix) == 0 && name.compare(name.size() - 4, 4, ".log") == 0){
+            std::string number = name.substr(prefix.size(), name.size() - prefix.size() - 4);
+            if (number.find_first_not_of("0123456789") == std::string::npos){
+                generations.push_back(strtoull(number.c_str(), nullptr, 10));
+            }
+        }
+    }
+    closedir(d);
+    std::sort(generations.begin(), generations.end());
+    return generations;
+}
+
+
+int MoveJournal::countShards(const std::string& dir){
+    int numShards = 0;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr){
+        return 0;
+    }
+    while (dirent* entry = readdir(d)){
+        std::string name = entry->d_name;
+        if (name.compare(0, 5, "shard") == 0 && name.size() > 5 && isdigit(name[5])){
+            numShards = std::max(numShards, atoi(name.c_str() + 5) + 1);
+        }
+    }
+    closedir(d);
+    return numShards;
+}
+
+
+// A game being rebuilt from the journal. Kept in a Game between records, so each move is a single makeMove().
+struct ReplayedGame{
+    Player white{PieceColor::WHITE};
+    Player black{PieceColor::BLACK};
+    std::unique_ptr<Game> game;
+    std::vector<uint64_t> hashes; // Since the last pawn move or capture, as in PackedGame
+};
+
+
+// Puts a replayed game back into its packed form, as the server would have left it after its last move
+static PackedGame repack(ReplayedGame& replayed){
+    Game& game = *replayed.game;
+    PackedGame packed = packFen(game.toFen());
+    packed.hashes = replayed.hashes;
+    setLegalMoves(packed, game.legalMoves());
+    packed.state = game.getGameState();
+    if (packed.state == GameState::CONTESTED && repetitionCount(packed, game.getHash()) >= 3){
+        packed.state = GameState::THREEFOLD_REPETITION;
+    }
+    return packed;
+}
+
+
+// Snapshot format (integers little-endian):
+//   "CSJ1", uint64 generation of the journal that follows, uint32 game count, then for each game:
+//   uint32 game id, uint8 state (as GameState), uint16 FEN length, FEN, uint16 hash count, a uint64 per hash,
+// and finally a uint32 checksum (FNV-1a) of everything before it.
+//
+// Replaying a record for a game that doesn't exist, or a move that isn't legal, means the files don't belong together,
+// so recovery fails rather than guess.
+bool MoveJournal::open(std::unordered_map<uint32_t, PackedGame>& games, uint32_t& maxGameId){
+    std::unordered_map<uint32_t, PackedGame> recovered;
+    uint64_t firstGeneration = 0;
+
+    std::string contents;
+    if (readFile(snapshotPath(), contents)){
+        const char* data = contents.data();
+        size_t size = contents.size();
+        if (size < 20 || contents.compare(0, 4, SNAPSHOT_MAGIC) != 0 || getLE(data + size - 4, 4) != fnv1a(data, size - 4)){
+            return false;
+        }
+        firstGeneration = getLE(data + 4, 8);
+        uint32_t count = getLE(data + 12, 4);
+        size_t pos = 16;
+        for (uint32_t i = 0; i < count; i++){
+            if (pos + 7 > size - 4){ return false; }
+            uint32_t gameId = getLE(data + pos, 4);
+            GameState state = (GameState)data[pos + 4];
+            size_t fenLength = getLE(data + pos + 5, 2);
+            pos += 7;
+            if (pos + fenLength + 2 > size - 4){ return false; }
+            std::string fen = contents.substr(pos, fenLength);
+            size_t numHashes = getLE(data + pos + fenLength, 2);
+            pos += fenLength + 2;
+            if (pos + 8 * numHashes > size - 4 || !Game::isValidFen(fen)){ return false; }
+
+            Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+            Game game(&white, &black, fen);
+            PackedGame packed = packFen(fen);
+            for (size_t h = 0; h < numHashes; h++){
+                packed.hashes.push_back(getLE(data + pos + 8*h, 8));
+            }
+            pos += 8 * numHashes;
+            setLegalMoves(packed, game.legalMoves());
+            packed.state = state;
+            recovered[gameId] = packed;
+        }
+    }
+
+    // Games with records in the journal are replayed in a Game, starting from their snapshot position if they have one
+    std::unordered_map<uint32_t, std::unique_ptr<ReplayedGame>> replayed;
+    auto replay = [&](uint32_t gameId) -> ReplayedGame* {
+        auto it = replayed.find(gameId);
+        if (it != replayed.end()){
+            return it->second.get();
+        }
+        auto packed = recovered.find(gameId);
+        if (packed == recovered.end()){
+            return nullptr;
+        }
+        ReplayedGame* r = new ReplayedGame();
+        r->game.reset(new Game(&r->white, &r->black, unpackToFen(packed->second)));
+        r->hashes = packed->second.hashes;
+        replayed[gameId].reset(r);
+        recovered.erase(packed);
+        return r;
+    };
+
+    std::vector<uint64_t> generations = logGenerations();
+    for (uint64_t gen: generations){
+        if (gen < firstGeneration || !readFile(logPath(gen), contents)){
+            continue;
+        }
+        const char* data = contents.data();
+        size_t pos = 0;
+        while (pos + RECORD_HEADER <= contents.size()){
+            size_t length = getLE(data + pos + 9, 2);
+            if (pos + RECORD_HEADER + length > contents.size() || getLE(data + pos, 4) != fnv1a(data + pos + 4, RECORD_HEADER - 4 + length)){
+                break; // Cut short by a crash
+            }
+            RecordType type = (RecordType)data[pos + 4];
+            uint32_t gameId = getLE(data + pos + 5, 4);
+            std::string payload = contents.substr(pos + RECORD_HEADER, length);
+            pos += RECORD_HEADER + length;
+            maxGameId = std::max(maxGameId, gameId);
+
+            if (type == NEW){
+                if (!Game::isValidFen(payload)){ return false; }
+                recovered.erase(gameId);
+                ReplayedGame* r = new ReplayedGame();
+                r->game.reset(new Game(&r->white, &r->black, payload));
+                r->hashes.push_back(r->game->getHash());
+                replayed[gameId].reset(r);
+            } else if (type == MOVE){
+                ReplayedGame* r = replay(gameId);
+                Move m = unpackMove(getLE(payload.data(), 2));
+                if (r == nullptr || payload.size() != 2 || !r->game->isValidMove(m.start, m.dest)){ return false; }
+                r->game->makeMove(m);
+                if (r->game->getHalfmoveClock() == 0){
+                    r->hashes.clear();
+                }
+                r->hashes.push_back(r->game->getHash());
+            } else if (type == END){
+                replayed.erase(gameId);
+                recovered.erase(gameId);
+            } else {
+                return false;
+            }
+        }
+        generation = gen;
+    }
+
+    for (auto& r: replayed){
+        recovered[r.first] = repack(*r.second);
+    }
+    for (auto& g: recovered){
+        maxGameId = std::max(maxGameId, g.first);
+        games[g.first] = g.second;
+    }
+    generation = std::max(generation, firstGeneration);
+    return snapshot(games);
+}
+
+
+void MoveJournal::logRecord(RecordType type, uint32_t gameId, const std::string& payload){
+    std::string record;
+    putLE(record, type, 1);
+    putLE(record, gameId, 4);
+    putLE(record, payload.size(), 2);
+    record += payload;
+    putLE(buffer, fnv1a(record.data(), record.size()), 4);
+    buffer += record;
+    records++;
+    recordsSinceSnapshot++;
+}
+
+
+void MoveJournal::logNew(uint32_t gameId, const std::string& fen){
+    logRecord(NEW, gameId, fen);
+}
+
+
+void MoveJournal::logMove(uint32_t gameId, const Move& move){
+    std::string payload;
+    putLE(payload, packMove(move), 2);
+    logRecord(MOVE, gameId, payload);
+}
+
+
+void MoveJournal::logEnd(uint32_t gameId){
+    logRecord(END, gameId, "");
+}
+
+
+bool MoveJournal::commit(){
+    if (buffer.empty()){
+        return true;
+    }
+    if (fd < 0 || !writeAll(fd, buffer) || !syncFile(fd)){
+        return false;
+    }
+    bytesWritten += buffer.size();
+    buffer.clear();
+    commits++;
+    return true;
+}
+
+
+bool MoveJournal::snapshotDue(){
+    return recordsSinceSnapshot >= snapshotRecords;
+}
+
+
+// The new journal generation is created before the snapshot that points to it, and the snapshot is written to
+// a temporary file and renamed into place, so a crash at any point leaves either the old snapshot with all the journal
+// after it, or the new snapshot with the (empty) new journal.
+bool MoveJournal::snapshot(const std::unordered_map<uint32_t, PackedGame>& games){
+    if (fd >= 0 && !commit()){
+        return false;
+    }
+
+    uint64_t newGeneration = generation + 1;
+    int newFd = ::open(logPath(newGeneration).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (newFd < 0){
+        return false;
+    }
+
+    std::string data = SNAPSHOT_MAGIC;
+    putLE(data, newGeneration, 8);
+    putLE(data, games.size(), 4);
+    for (auto& g: games){
+        const PackedGame& packed = g.second;
+        std::string fen = unpackToFen(packed);
+        putLE(data, g.first, 4);
+        putLE(data, (uint8_t)packed.state, 1);
+        putLE(data, fen.size(), 2);
+        data += fen;
+        putLE(data, packed.hashes.size(), 2);
+        for (uint64_t hash: packed.hashes){
+            putLE(data, hash, 8);
+        }
+    }
+    putLE(data, fnv1a(data.data(), data.size()), 4);
+
+    std::string tmpPath = snapshotPath() + ".tmp";
+    int snapFd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = snapFd >= 0 && writeAll(snapFd, data) && fsync(snapFd) == 0;
+    if (snapFd >= 0){
+        close(snapFd);
+    }
+    if (!ok || rename(tmpPath.c_str(), snapshotPath().c_str()) != 0 || !syncDir(dir)){
+        close(newFd);
+        return false;
+    }
+
+    if (fd >= 0){
+        close(fd);
+    }
+    fd = newFd;
+    generation = newGeneration;
+    recordsSinceSnapshot = 0;
+    for (uint64_t gen: logGenerations()){
+        if (gen < generation){
+            unlink(logPath(gen).c_str());
+        }
+    }
+    bytesWritten += data.size();
+    return true;
+}
+
+
+uint64_t MoveJournal::getRecords(){
+    return records;
+}
+
+
+uint64_t MoveJournal::getCommits(){
+    return commits;
+}
+
+
+uint64_t MoveJournal::getBytesWritten(){
+    return bytesWritten;
+}
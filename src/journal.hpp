@@ -0,0 +1,103 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "packedgame.hpp"
+#include "move.hpp"
+
+#pragma once
+
+
+// Write-ahead log of the games in one shard of the server (the games of one worker), so they survive a restart.
+//
+// Each new game, move and end of a game is appended to the journal as a small binary record. Records are only buffered
+// until commit(), which writes them all with a single write() and waits for them to reach the disk with a single
+// fdatasync(): the server commits once per batch of requests, before answering them (group commit), so the cost of
+// the sync is shared by every move in the batch rather than paid by each one.
+//
+// Every so often the shard's games are written out in a compact snapshot (each game's position and the hashes needed
+// to detect repetitions), which replaces the journal up to that point, so recovery doesn't have to replay every
+// move ever made. Recovery loads the snapshot, then replays the journal after it, rebuilding each game in a Game.
+//
+// Files, in the journal's directory, for shard k:
+//   shard<k>.snap        the last snapshot, with the generation of the journal that follows it
+//   shard<k>.<gen>.log   journal generation gen; a new generation is started by each snapshot
+//
+// Record format (integers little-endian):
+//   uint32 checksum (FNV-1a of the rest of the record), uint8 type, uint32 game id, uint16 payload length, payload
+// where the payload is the FEN for a new game, the move packed by packMove() for a move, and empty for the end of a game.
+// A record cut short or garbled by a crash fails its checksum, and the journal is read up to it.
+class MoveJournal{
+
+    public:
+
+        // Records logged between snapshots
+        static const uint64_t DEFAULT_SNAPSHOT_RECORDS = 1 << 20;
+
+        MoveJournal(const std::string& dir, int shard, uint64_t snapshotRecords = DEFAULT_SNAPSHOT_RECORDS);
+
+        ~MoveJournal();
+
+        MoveJournal(const MoveJournal&) = delete;
+        MoveJournal& operator=(const MoveJournal&) = delete;
+
+        // Recovers the shard's games (adding them to games, by id) from the files left by an earlier run, if any,
+        // then writes a snapshot of them to start a fresh journal. maxGameId is raised to the highest game id seen.
+        // Returns false if the files couldn't be read or written.
+        bool open(std::unordered_map<uint32_t, PackedGame>& games, uint32_t& maxGameId);
+
+        void logNew(uint32_t gameId, const std::string& fen);
+
+        void logMove(uint32_t gameId, const Move& move);
+
+        void logEnd(uint32_t gameId);
+
+        // Writes the records logged since the last commit, and waits until they are on disk. Returns false on a write error.
+        bool commit();
+
+        // Whether enough records have been logged since the last snapshot for another to be written
+        bool snapshotDue();
+
+        // Commits, then writes a snapshot of the shard's games (which must be up to date with every record logged)
+        // and starts a new journal generation, deleting the files it replaces. Returns false on a write error.
+        bool snapshot(const std::unordered_map<uint32_t, PackedGame>& games);
+
+        // Totals since the journal was opened
+        uint64_t getRecords();
+        uint64_t getCommits();
+        uint64_t getBytesWritten();
+
+        // Number of shards with files in a journal directory (1 + the highest shard number), or 0 if there are none
+        static int countShards(const std::string& dir);
+
+    private:
+
+        enum RecordType : uint8_t{ NEW = 1, MOVE = 2, END = 3 };
+
+        void logRecord(RecordType type, uint32_t gameId, const std::string& payload);
+
+        std::string snapshotPath();
+        std::string logPath(uint64_t generation);
+
+        // Generations of this shard's journal files in the directory, in increasing order
+        std::vector<uint64_t> logGenerations();
+
+        std::string dir;
+
+        int shard;
+
+        uint64_t snapshotRecords;
+
+        int fd; // Current journal generation, or -1 if not open
+
+        uint64_t generation;
+
+        std::string buffer; // Records logged but not yet committed
+
+        uint64_t recordsSinceSnapshot;
+
+        uint64_t records;
+        uint64_t commits;
+        uint64_t bytesWritten;
+};
@@ -1,10 +1,12 @@
 #include <array>
 #include <vector>
-#include <cmath>
+#include <algorithm>
 
 #include "piece.hpp"
 #include "square.hpp"
 #include "king.hpp"
+#include "instrument.hpp"
+#include "attacks.hpp"
 
 
 King::King(PieceColor color) : Piece(color){}
@@ -16,116 +18,94 @@ King::King() : Piece(){}
 char King::toChar(){ return (color==PieceColor::WHITE) ? 'K' : 'k'; }
 
 
-bool King::isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
+bool King::isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& /*board*/){
     // KING MOVE CONDITIONS:
     // - Can move by 1 row (horizontally 1 space) in any direction
     // - Can move by 1 column (vertically 1 space) in any direction
     // - Can move by 1 row and 1 column (diagonally 1 space) in any direction.
     // - Can castle if neither king nor rook has moved, and if no pieces are between the rook and king
-    std::array<int, 2> disp = displacement(start, dest);
-    return ( (abs(disp[0]) == 1 && disp[1] == 0) || (disp[0] == 0 && abs(disp[1]) == 1) || (abs(disp[0]) == 1 && abs(disp[1]) == 1) );
+    return KING_ATTACKS[start] & squareBit(dest);
 }
 
 
-std::vector<Square> King::legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board){
-    std::vector<Square> dests;
+// The dest squares on the board are looked up in KING_ATTACKS, then each is taken unless it holds a friendly piece
+std::vector<SquareIndex> King::legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board){
+    CHESS_TIME(LEGAL_DESTS);
+    CHESS_COUNT(LEGAL_DESTS_KING);
+    CHESS_COUNT(VECTORS_ALLOCATED);
+    std::vector<SquareIndex> dests;
+    dests.reserve(8);
 
-    // Array of valid displacements (differences between start and dest squares in form {row, col}) for a king move
-    // These will each in turn be added to the starting square to get potential destination squares
-    std::array<std::array<int, 2>, 8> displacements = { { {1,1}, {1,0}, {1,-1}, {0,1}, {0,-1}, {-1,1}, {-1,0}, {-1,-1} } };
+    for (uint64_t mask = KING_ATTACKS[start]; mask != 0; mask &= mask - 1){
+        int sq = __builtin_ctzll(mask);
+        Piece *pieceAtDest = board[sq / 8][sq % 8];
 
-    for (int i = 0; i < 8; i++){
-
-        int destRow = start.row+displacements[i][0];
-        int destCol = start.col+displacements[i][1];
-
-        // If calculated new row & column lie within the dimensions of the board
-        if ( (destRow >= 0 && destRow < 8) && (destCol >= 0 && destCol < 8) ){
-
-            Piece *pieceAtDest = board[destRow][destCol];
-            
-            // If destination square is either empty or has opposition piece
-            if (pieceAtDest == nullptr || pieceAtDest->getColor() != color){ 
-                dests.push_back( square(destRow, destCol) ); 
-            }
+        // If destination square is either empty or has opposition piece
+        if (pieceAtDest == nullptr || pieceAtDest->getColor() != color){
+            dests.push_back( sq );
         }
     }
     return dests;
 }
 
 
-bool King::canCastleShort(const std::array<std::array<Piece*, 8>, 8>& board){
-
-    if (hasMoved){ return false; } // Can't castle if king has moved
-
-    Square s1, s2; // These 2 squares are the squares that the king will move through when castling. 
-    Square rookSq; // Starting square of kingside rook
-    if (color == PieceColor::WHITE){
-        s1 = square(0, 5);
-        s2 = square(0, 6);
-        rookSq = square(0, 7);  
-    } 
-    else if(color == PieceColor::BLACK){
-        s1 = square(7, 5);
-        s2 = square(7, 6);
-        rookSq = square(7, 7);   
-    }
-
-    // If kingside rook is not at starting square i.e. 
-    // the piece at that square has moved (meaning that piece is not the rook that was originally there)
-    // or that square is empty, then can't castle
-    if (board[rookSq.row][rookSq.col] == nullptr || board[rookSq.row][rookSq.col]->getHasMoved()){
-        return false;
-    }
-
-    // Can't castle if there's a piece on either of the squares that the king passes over
-    if (board[s1.row][s1.col] != nullptr || board[s2.row][s2.col] != nullptr){
-        return false;
-    }
+bool King::canCastleShort(SquareIndex kingSq, int rookCol, const std::array<std::array<Piece*, 8>, 8>& board){
+    return canCastle(kingSq, rookCol, 6, 5, board);
+}
 
-    // Can't castle if king would be passing through an attacked square
-    if (isAttacked(s1, board, color) || isAttacked(s2, board, color)){
-        return false;
-    }
 
-    return true;
+bool King::canCastleLong(SquareIndex kingSq, int rookCol, const std::array<std::array<Piece*, 8>, 8>& board){
+    return canCastle(kingSq, rookCol, 2, 3, board);
 }
 
 
-bool King::canCastleLong(const std::array<std::array<Piece*, 8>, 8>& board){
+// Castling conditions:
+// - Neither the king nor the rook has moved
+// - Every square between the king's and rook's start and end squares is empty, other than those holding the king and rook themselves
+// - The king isn't in check, and doesn't pass through or land on an attacked square
+//
+// In Chess960 the castling rook may stand on a square the king passes through, or shield one of those squares from an attack
+// along the row, so the attacks are worked out with the king and rook taken off the board.
+// In standard chess neither can happen, so the board is used as it is.
+bool King::canCastle(SquareIndex kingSq, int rookCol, int kingDestCol, int rookDestCol, const std::array<std::array<Piece*, 8>, 8>& board){
 
     if (hasMoved){ return false; } // Can't castle if king has moved
 
-    Square s1, s2, s3; // These 3 squares are the squares that the king will move through when castling. 
-    Square rookSq; // Starting square of queenside rook
-    if (color == PieceColor::WHITE){
-        s1 = square(0, 1);
-        s2 = square(0, 2);
-        s3 = square(0, 3);
-        rookSq = square(0, 0);          
-    } 
-    else if(color == PieceColor::BLACK){
-        s1 = square(7, 1);
-        s2 = square(7, 2);
-        s3 = square(7, 3);
-        rookSq = square(7, 0);
-    }
-
-    // If queenside rook is not at starting square i.e. that square is empty or
+    // If the rook is not at its starting square i.e. that square is empty or
     // the piece at that square has moved (meaning that piece is not the rook that was originally there),
     // then can't castle
-    if (board[rookSq.row][rookSq.col] == nullptr || board[rookSq.row][rookSq.col]->getHasMoved()){
+    int row = rankOf(kingSq);
+    Piece* rook = board[row][rookCol];
+    if (rook == nullptr || rook->getHasMoved() || rook->getColor() != color){
         return false;
     }
 
-    // Can't castle if there's a piece on a square that the king passes over
-    if (board[s1.row][s1.col] != nullptr || board[s2.row][s2.col] != nullptr|| board[s3.row][s3.col] != nullptr){
-        return false;
+    // Can't castle if there's a piece in the way of the king or rook
+    int left = std::min(std::min(fileOf(kingSq), rookCol), std::min(kingDestCol, rookDestCol));
+    int right = std::max(std::max(fileOf(kingSq), rookCol), std::max(kingDestCol, rookDestCol));
+    for (int col = left; col <= right; col++){
+        if (board[row][col] != nullptr && col != fileOf(kingSq) && col != rookCol){
+            return false;
+        }
     }
 
-    // Can't castle if king would be passing through an attacked square
-    if (isAttacked(s1, board, color) || isAttacked(s2, board, color) || isAttacked(s3, board, color)){
-        return false;
+    // Can't castle out of check, or if king would be passing through or landing on an attacked square
+    bool standard = fileOf(kingSq) == 4 && (rookCol == 0 || rookCol == 7);
+    std::array<std::array<Piece*, 8>, 8> cleared;
+    if (!standard){
+        cleared = board;
+        cleared[row][fileOf(kingSq)] = nullptr;
+        cleared[row][rookCol] = nullptr;
+    }
+    const std::array<std::array<Piece*, 8>, 8>& attackBoard = standard ? board : cleared;
+    int step = (kingDestCol >= fileOf(kingSq)) ? 1 : -1;
+    for (int col = fileOf(kingSq); ; col += step){
+        if (isAttacked(squareIndex(row, col), attackBoard, color)){
+            return false;
+        }
+        if (col == kingDestCol){
+            break;
+        }
     }
 
     return true;
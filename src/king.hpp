@@ -18,15 +18,21 @@ class King : public Piece {
 
         char toChar() override;
 
-        bool isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        bool isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
 
-        std::vector<Square> legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        std::vector<SquareIndex> legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board) override;
 
-        // Determines if the king is able to castle short (kingside) 
-        // (the game board is passed as a param)
-        bool canCastleShort(const std::array<std::array<Piece*, 8>, 8>& board);
+        // Determines if the king, on kingSq, is able to castle short (kingside) with the rook on rookCol of the same row
+        // (the game board is passed as a param). In standard chess the king starts on column 4 and the rook on column 7;
+        // in Chess960 they can start anywhere, with the king between the rooks.
+        bool canCastleShort(SquareIndex kingSq, int rookCol, const std::array<std::array<Piece*, 8>, 8>& board);
 
-        // Determines if the king is able to castle long (queenside) 
-        // (the game board is passed as a param)
-        bool canCastleLong(const std::array<std::array<Piece*, 8>, 8>& board);
+        // Determines if the king, on kingSq, is able to castle long (queenside) with the rook on rookCol of the same row
+        // (the game board is passed as a param). In standard chess the rook starts on column 0.
+        bool canCastleLong(SquareIndex kingSq, int rookCol, const std::array<std::array<Piece*, 8>, 8>& board);
+
+    private:
+
+        // Castling ends with the king on kingDestCol and the rook on rookDestCol, whatever columns they started on
+        bool canCastle(SquareIndex kingSq, int rookCol, int kingDestCol, int rookDestCol, const std::array<std::array<Piece*, 8>, 8>& board);
 };
@@ -1,9 +1,10 @@
 #include <array>
 #include <vector>
-#include <cmath>
 
 #include "piece.hpp"
 #include "knight.hpp"
+#include "instrument.hpp"
+#include "attacks.hpp"
 
 
 Knight::Knight(PieceColor color) : Piece(color){}
@@ -15,35 +16,28 @@ Knight::Knight() : Piece(){}
 char Knight::toChar(){ return (color==PieceColor::WHITE) ? 'N' : 'n'; }
 
 
-bool Knight::isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
+bool Knight::isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& /*board*/){
     // KNIGHT MOVE CONDITIONS: Can move either 2 rows and 1 column, or by 1 row and 2 columns, in any direction
     // Unlike other pieces, the knight can do this even if another piece is in it's path (jumping).
-    std::array<int, 2> disp = displacement(start, dest);
-    return ( (abs(disp[0]) == 1 && abs(disp[1]) == 2) || (abs(disp[0]) == 2 && abs(disp[1])  == 1) );
+    return KNIGHT_ATTACKS[start] & squareBit(dest);
 }
 
 
-std::vector<Square> Knight::legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board){
-    std::vector<Square> dests;
+// The dest squares on the board are looked up in KNIGHT_ATTACKS, then each is taken unless it holds a friendly piece
+std::vector<SquareIndex> Knight::legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board){
+    CHESS_TIME(LEGAL_DESTS);
+    CHESS_COUNT(LEGAL_DESTS_KNIGHT);
+    CHESS_COUNT(VECTORS_ALLOCATED);
+    std::vector<SquareIndex> dests;
+    dests.reserve(8);
 
-    // Array of valid displacements (differences between start and dest squares in form {row, col}) for a knight move
-    // These will each in turn be added to the starting square to get potential destination squares
-    std::array<std::array<int, 2>, 8> displacements = { { {2,1}, {2,-1}, {1,2}, {1, -2}, {-1,2}, {-1,-2}, {-2,1}, {-2,-1} } };
+    for (uint64_t mask = KNIGHT_ATTACKS[start]; mask != 0; mask &= mask - 1){
+        int sq = __builtin_ctzll(mask);
+        Piece *pieceAtDest = board[sq / 8][sq % 8];
 
-    for (int i = 0; i < 8; i++){
-
-        int destRow = start.row+displacements[i][0];
-        int destCol = start.col+displacements[i][1];
-
-        // If calculated new row & column lie within the dimensions of the board
-        if ( (destRow >= 0 && destRow < 8) && (destCol >= 0 && destCol < 8) ){
-
-            Piece *pieceAtDest = board[destRow][destCol];
-            
-            // If destination square is either empty or has opposition piece
-            if (pieceAtDest == nullptr || pieceAtDest->getColor() != color){ 
-                dests.push_back( square(destRow, destCol) ); 
-            }
+        // If destination square is either empty or has opposition piece
+        if (pieceAtDest == nullptr || pieceAtDest->getColor() != color){
+            dests.push_back( sq );
         }
     }
     return dests;
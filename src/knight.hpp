@@ -17,8 +17,8 @@ class Knight : public Piece {
 
         char toChar() override;
 
-        bool isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        bool isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
 
-        std::vector<Square> legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        std::vector<SquareIndex> legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board) override;
 
 };
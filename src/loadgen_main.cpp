@@ -0,0 +1,265 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+
+
+// Load generator for chess_server. Each connection (on its own thread) keeps a set of games going at once:
+// every round, it sends a random legal move in each of its games in one batch, then reads all the responses,
+// checking each against the result of the same move on its own copy of the game.
+// Games that end are replaced by new ones. Reports throughput and response latency.
+//
+// Usage: chess_loadgen [options]
+//   --socket PATH       server socket (default /tmp/chess.sock)
+//   --connections N     number of connections (default 4)
+//   --games N           games in play at once per connection (default 250)
+//   --moves N           total number of moves to send (default 100000)
+//   --seed N            base seed for choosing moves (default 1)
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_loadgen [--socket PATH] [--connections N] [--games N] [--moves N] [--seed N]" << std::endl;
+}
+
+
+// A game being played against the server, and the client's own copy of it
+struct ClientGame{
+    Player white;
+    Player black;
+    Game game;
+    std::string id;
+
+    ClientGame(const std::string& id) : white(PieceColor::WHITE), black(PieceColor::BLACK), game(&white, &black), id(id) {}
+};
+
+
+// Blocking line-based connection to the server
+class ServerConnection{
+
+    public:
+
+        ServerConnection(const std::string& socketPath){
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+            if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0){
+                close(fd);
+                fd = -1;
+            }
+        }
+
+        ~ServerConnection(){
+            if (fd >= 0){ close(fd); }
+        }
+
+        bool isOpen(){
+            return fd >= 0;
+        }
+
+        bool send(const std::string& data){
+            size_t sent = 0;
+            while (sent < data.size()){
+                ssize_t n = write(fd, data.data() + sent, data.size() - sent);
+                if (n <= 0){
+                    return false;
+                }
+                sent += n;
+            }
+            return true;
+        }
+
+        bool readLine(std::string& line){
+            size_t newline;
+            while ((newline = buffer.find('\n')) == std::string::npos){
+                char buf[4096];
+                ssize_t n = read(fd, buf, sizeof(buf));
+                if (n <= 0){
+                    return false;
+                }
+                buffer.append(buf, n);
+            }
+            line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            return true;
+        }
+
+    private:
+
+        int fd;
+
+        std::string buffer;
+};
+
+
+// Totals over all connections
+struct LoadStats{
+    std::atomic<long> moves{0};
+    std::atomic<long> gamesFinished{0};
+    std::atomic<long> mismatches{0};
+    std::atomic<bool> failed{false};
+    std::mutex latencyMutex;
+    std::vector<double> latencies; // Per move, in microseconds
+};
+
+
+// Starts a game on the server, and the client's copy of it. Returns false if the server did not respond as expected.
+static bool newGame(ServerConnection& conn, std::unique_ptr<ClientGame>& cg){
+    std::string response;
+    if (!conn.send("NEW\n") || !conn.readLine(response) || response.compare(0, 3, "OK ") != 0){
+        return false;
+    }
+    cg.reset(new ClientGame(response.substr(3)));
+    return true;
+}
+
+
+static void runConnection(const std::string& socketPath, int numGames, long moveBudget, uint64_t seed, LoadStats& stats){
+    ServerConnection conn(socketPath);
+    if (!conn.isOpen()){
+        std::cerr << "ERROR: COULD NOT CONNECT TO " << socketPath << std::endl;
+        stats.failed = true;
+        return;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<std::unique_ptr<ClientGame>> games(numGames);
+    for (auto& cg: games){
+        if (!newGame(conn, cg)){
+            stats.failed = true;
+            return;
+        }
+    }
+
+    std::vector<double> latencies;
+    long sent = 0;
+    while (sent < moveBudget && !stats.failed){
+
+        // Send a move in each game
+        std::vector<Move> moves;
+        std::string batch;
+        for (auto& cg: games){
+            std::vector<Move> legal = cg->game.legalMoves();
+            Move m = legal[std::uniform_int_distribution<size_t>(0, legal.size() - 1)(rng)];
+            moves.push_back(m);
+            batch += "MOVE " + cg->id + " " + moveToStr(m) + "\n";
+        }
+        auto sendTime = std::chrono::steady_clock::now();
+        if (!conn.send(batch)){
+            stats.failed = true;
+            break;
+        }
+        sent += games.size();
+
+        // Read the responses in order, and check them against the client's copies of the games
+        std::vector<size_t> finished;
+        for (size_t i = 0; i < games.size() && !stats.failed; i++){
+            std::string response;
+            if (!conn.readLine(response)){
+                stats.failed = true;
+                break;
+            }
+            std::chrono::duration<double, std::micro> latency = std::chrono::steady_clock::now() - sendTime;
+            latencies.push_back(latency.count());
+
+            ClientGame& cg = *games[i];
+            cg.game.makeMove(moves[i]);
+            GameState state = cg.game.getGameState();
+            if (response != "OK " + gameStateToStr(state)){
+                stats.mismatches++;
+            }
+
+            // Replace the game once it is over, by the client's or the server's reckoning
+            if (state != GameState::CONTESTED || response != "OK " + gameStateToStr(GameState::CONTESTED)){
+                finished.push_back(i);
+            }
+        }
+
+        // Once all the moves' responses are in, the games that are over can be replaced
+        for (size_t i: finished){
+            std::string endResponse;
+            if (!conn.send("END " + games[i]->id + "\n") || !conn.readLine(endResponse) || !newGame(conn, games[i])){
+                stats.failed = true;
+                break;
+            }
+            stats.gamesFinished++;
+        }
+    }
+
+    stats.moves += sent;
+    std::lock_guard<std::mutex> lock(stats.latencyMutex);
+    stats.latencies.insert(stats.latencies.end(), latencies.begin(), latencies.end());
+}
+
+
+int main(int argc, char* argv[]){
+    std::string socketPath = "/tmp/chess.sock";
+    int numConnections = 4;
+    int numGames = 250;
+    long numMoves = 100000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--socket"){ socketPath = value; }
+        else if (arg == "--connections"){ numConnections = std::max(1, atoi(value.c_str())); }
+        else if (arg == "--games"){ numGames = std::max(1, atoi(value.c_str())); }
+        else if (arg == "--moves"){ numMoves = atol(value.c_str()); }
+        else if (arg == "--seed"){ seed = strtoull(value.c_str(), nullptr, 10); }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    LoadStats stats;
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < numConnections; c++){
+        threads.push_back(std::thread(runConnection, socketPath, numGames, numMoves / numConnections, seed + c, std::ref(stats)));
+    }
+    for (auto& t: threads){
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    if (stats.failed){
+        std::cerr << "ERROR: LOST CONNECTION TO SERVER" << std::endl;
+        return 1;
+    }
+
+    std::vector<double>& lat = stats.latencies;
+    std::sort(lat.begin(), lat.end());
+    auto percentile = [&](double p){ return lat.empty() ? 0.0 : lat[std::min(lat.size() - 1, (size_t)(p * lat.size()))]; };
+
+    std::cout << "CONNECTIONS: " << numConnections << "  GAMES IN PLAY: " << numConnections * numGames << std::endl;
+    std::cout << "MOVES: " << stats.moves << "  GAMES FINISHED: " << stats.gamesFinished << "  MISMATCHES: " << stats.mismatches << std::endl;
+    std::cout << "TIME: " << elapsed.count() << " s" << std::endl;
+    std::cout << "MOVES/SEC: " << (long)(stats.moves / elapsed.count()) << std::endl;
+    std::cout << "LATENCY (us): P50 " << percentile(0.5) << "  P99 " << percentile(0.99) << "  MAX " << (lat.empty() ? 0.0 : lat.back()) << std::endl;
+    return stats.mismatches == 0 ? 0 : 1;
+}
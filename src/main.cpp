@@ -1,155 +1,69 @@
 #include <iostream>
 #include <string>
-#include <vector>
+#include <cstdlib>
+#include <random>
 
-#include "game.hpp"
-#include "square.hpp"
+#include "cli.hpp"
+#include "io.hpp"
+#include "clock.hpp"
 #include "piece.hpp"
 
 
-int main(){
-    std::cout << "-------------------------------------------------------------------------------------------------" << std::endl;
-    std::cout << "CHESS" << std::endl;
-    std::cout << "-------------------------------------------------------------------------------------------------" << std::endl;
+// Usage: chess [options]
+//   --time MINUTES     play with clocks, giving each player MINUTES (may be fractional)
+//   --increment SECS   add SECS to a player's clock after each of their moves (default 0)
+//   --delay SECS       start a player's clock SECS into each of their moves (default 0)
+//   --engine COLOR     play against the engine, which plays COLOR (white or black)
+//   --ponder on|off    let the engine think on its opponent's time (default on)
+//   --chess960 N       play Chess960 from starting position N (0-959), or from a random one if N is "random"
+//   --board full|diff  draw the whole board each turn, or keep it at the top of the screen and redraw only the squares
+//                      that change (default full)
 
-    Player white(PieceColor::WHITE);
-    Player black(PieceColor::BLACK);
-    Game game(&white, &black);
 
-    bool end = false;
+void printUsage(){
+    std::cerr << "USAGE: chess [--time MINUTES] [--increment SECS] [--delay SECS] [--engine white|black] [--ponder on|off] [--chess960 N|random] [--board full|diff]" << std::endl;
+}
 
-    // Game loop
-    while(!end){
 
-        GameState state = game.getGameState();
+int main(int argc, char* argv[]){
+    CliOptions options;
 
-        // If game is still to play for
-        if (state == GameState::CONTESTED){
-            std::cout << "-------------------------------------------------------------------------------------------------" << std::endl;
-            if (game.isCheck()){std::cout << "CHECK" << std::endl;} // Notify players if a check was given.
-            std::cout << std::endl;
-            std::cout << game.getTurn()->getColorStr() << "'S TURN" << std::endl;
-            game.printBoard();
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
         }
-        // If the last turn has resulted in either checkmate or stalemate
-        else {
-            if (state == GameState::CHECKMATE){ std::cout << "CHECKMATE - " << game.getTurn()->getOppColorStr() << " WINS" << std::endl; }
-            else if (state == GameState::STALEMATE){ std::cout << "STALEMATE" << std::endl; }
-            std::cout << "-------------------------------------------------------------------------------------------------" << std::endl;
-            end = true;
-            continue;
+        std::string value = argv[++i];
+
+        if (arg == "--time"){ options.timed = true; options.timeControl.baseMs = (int64_t)(atof(value.c_str()) * 60000); }
+        else if (arg == "--increment"){ options.timeControl.incrementMs = (int64_t)(atof(value.c_str()) * 1000); }
+        else if (arg == "--delay"){ options.timeControl.delayMs = (int64_t)(atof(value.c_str()) * 1000); }
+        else if (arg == "--engine" && (value == "white" || value == "black")){
+            options.engine = true;
+            options.engineColor = (value == "white") ? PieceColor::WHITE : PieceColor::BLACK;
         }
-
-        std::string input;
-
-        // Tracks whether to switch turns from white to black or vice versa
-        // Will be initialized to false, set to true within the below loop at some stage, then be reset to false here when the next turn begins
-        bool turnChange = false; 
-        do {
-        
-            std::cout << "> ";
-            std::cin >> input;
-
-            // Resign
-            if (input == "r"){
-                std::cout << game.getTurn()->getColorStr() << " RESIGNS - " << game.getTurn()->getOppColorStr() << " WINS" << std::endl;
-                std::cout << "-------------------------------------------------------------------------------------------------" << std::endl;
-                turnChange = true;
-                end = true;
-            } 
-    
-            // Offer draw
-            else if (input == "od"){ 
-                
-                std::cout << game.getTurn()->getColorStr() << " OFFERS A DRAW" << std::endl;
-                std::string resp;
-                do {
-                    std::cout << game.getTurn()->getOppColorStr() << ", TYPE (y) TO ACCEPT AND (n) TO DECLINE: "; 
-                    std::cin >> resp;
-                } while(resp != "y" && resp != "n");
-
-                if (resp == "y"){
-                    std::cout << "DRAW" << std::endl;
-                    std::cout << "-------------------------------------------------------------------------------------------------" << std::endl;
-                    turnChange = true;
-                    end = true; 
-                } else {
-                    std::cout << "DRAW DECLINED, GAME CONTINUES." << std::endl;
-                }
-            } 
-
-            // Regular move
-            else if (input == "m"){
-                
-                bool legal; // Will hold the bool returned by game.movePiece() and thus will validate moves.
-                do {
-
-                    // Get & validate starting square string (square on which piece to move is located).
-                    std::string startStr;
-                    do {
-                        std::cout << "START SQUARE: ";
-                        std::cin >> startStr;
-                        if (!isValidSquareStr(startStr)){
-                            std::cout << "INVALID SQUARE. TRY AGAIN" << std::endl;
-                        }
-                    } while (!isValidSquareStr(startStr));
-                    Square start = squareFromStr(startStr);
-
-                    // Get & validate destination square string.
-                    std::string destStr;
-                    do {
-                        std::cout << "DESTINATION SQUARE: ";
-                        std::cin >> destStr;
-                        if (!isValidSquareStr(destStr)){
-                            std::cout << "INVALID SQUARE. TRY AGAIN" << std::endl;
-                        }
-                    } while (!isValidSquareStr(destStr));
-                    Square dest = squareFromStr(destStr);
-                    
-                    legal = game.isLegalMove(start, dest); 
-
-                    if (legal){
-                        game.movePiece(start, dest);
-                        turnChange = true;
-                    } else {
-                        std::cout << "ILLEGAL MOVE. TRY AGAIN" << std::endl;
-                    }
-
-                } while (!legal); // Repeat move process until user inputs a legal move
-            }
-
-            // Castling kingside/short
-            else if (input == "cs"){
-                if (game.shortCastleIsLegal()){
-                    game.shortCastle();
-                    turnChange = true;
-                }
-                else {
-                    std::cout << "CAN'T CASTLE SHORT HERE" << std::endl;
-                }
-            }
-
-            // Castling queenside/long
-            else if (input == "cl"){
-                if (game.longCastleIsLegal()){
-                    game.longCastle();
-                    turnChange = true;
-                }
-                else {
-                    std::cout << "CAN'T CASTLE LONG HERE" << std::endl;
-                }
+        else if (arg == "--ponder" && (value == "on" || value == "off")){ options.ponder = (value == "on"); }
+        else if (arg == "--board" && (value == "full" || value == "diff")){ options.diffBoard = (value == "diff"); }
+        else if (arg == "--chess960"){
+            options.chess960Position = (value == "random") ? std::random_device()() % 960 : atoi(value.c_str());
+            if (options.chess960Position < 0 || options.chess960Position >= 960){
+                std::cerr << "ERROR: CHESS960 POSITION MUST BE 0-959" << std::endl;
+                return 1;
             }
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
 
-            // Unrecognized input
-            else { 
-                std::cout << "INVALID INPUT. TRY AGAIN" << std::endl;
-            }
-
-            std::cout << std::endl;
-
-        } while (!turnChange);
-
-        game.toggleTurn();
+    if (options.timed && options.timeControl.baseMs <= 0){
+        std::cerr << "ERROR: TIME MUST BE POSITIVE" << std::endl;
+        return 1;
     }
+
+    StreamIO io(std::cin, std::cout);
+    playCli(io, options);
     return 0;
 }
@@ -0,0 +1,271 @@
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "mate.hpp"
+#include "game.hpp"
+#include "move.hpp"
+#include "movepick.hpp"
+
+
+// Proof or disproof number of a position that is proven or disproven. Sums of numbers stop just short of it,
+// so only a child that is itself infinite makes its parent's sum infinite.
+static const uint32_t INFINITE_NUMBER = 1u << 30;
+
+
+// A child is searched until its number is a little more than the second best child's (by 1/EPSILON_DIVISOR),
+// rather than just more, so the search doesn't keep switching between 2 children with similar numbers (Pawlewicz's 1 + epsilon trick)
+static const uint32_t EPSILON_DIVISOR = 4;
+
+
+static uint32_t addNumbers(uint32_t a, uint32_t b){
+    if (a >= INFINITE_NUMBER || b >= INFINITE_NUMBER){
+        return INFINITE_NUMBER;
+    }
+    return std::min(a + b, INFINITE_NUMBER - 1);
+}
+
+
+MateSolver::MateSolver(const MateOptions& options) : options(options) {
+    table.resize((size_t)1 << std::max(1, options.hashBits));
+    clear();
+    nodes = 0;
+    budget = 0;
+    aborted = false;
+}
+
+
+void MateSolver::clear(){
+    Entry empty;
+    empty.key = 0;
+    empty.pn = 1;
+    empty.dn = 1;
+    empty.work = 0;
+    std::fill(table.begin(), table.end(), empty);
+}
+
+
+uint64_t MateSolver::tableKey(Game& game, int plies){
+    return game.getHash() ^ ((uint64_t)(plies + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+
+MateSolver::Entry* MateSolver::probe(uint64_t key){
+    size_t index = key & (table.size() - 2);
+    for (size_t i = index; i < index + 2; i++){
+        if (table[i].key == key){
+            return &table[i];
+        }
+    }
+    return nullptr;
+}
+
+
+// The entry for the key is updated if it is in the bucket; otherwise the entry that took less work is replaced
+void MateSolver::store(uint64_t key, uint32_t pn, uint32_t dn, uint64_t work){
+    size_t index = key & (table.size() - 2);
+    Entry* entry = &table[index];
+    if (table[index + 1].key == key || (table[index].key != key && table[index + 1].work < table[index].work)){
+        entry = &table[index + 1];
+    }
+    entry->key = key;
+    entry->pn = pn;
+    entry->dn = dn;
+    entry->work = work;
+}
+
+
+std::vector<Move> MateSolver::candidateMoves(Game& game, bool attacker){
+    std::vector<Move> moves = game.legalMoves();
+    if (attacker && options.checksOnly){
+        std::vector<Move> checks;
+        for (auto& m: moves){
+            game.makeMove(m);
+            if (game.isCheck()){
+                checks.push_back(m);
+            }
+            game.unmakeMove();
+        }
+        return checks;
+    }
+    return moves;
+}
+
+
+// The attacker's positions are OR nodes: proving any one child proves them, so their proof number is the least of
+// their children's, and their disproof number the sum. The defender's positions are AND nodes, the other way round.
+//
+// Each child starts out with numbers from a quick look at it (without expanding it): checkmate and stalemate are settled,
+// a position with no plies left that isn't mate is disproven, and a defender position's proof number is its number of
+// legal moves, as each one would have to be refuted. Numbers in the table, from searching the child, take precedence.
+//
+// The child with the least proof number (for the attacker) or disproof number (for the defender) is searched until
+// it is no longer the best, or the position's own numbers reach the limits: its limits are set so that it returns once
+// the second best child would be clearly better, or the position's numbers would reach the position's limits.
+void MateSolver::mid(Game& game, int plies, bool attacker, uint32_t pnLimit, uint32_t dnLimit, uint64_t key){
+    uint64_t startNodes = nodes;
+    nodes++;
+    if (budget != 0 && nodes > budget){
+        aborted = true;
+    }
+
+    struct Child{
+        Move move;
+        uint64_t key;
+        uint32_t pn;
+        uint32_t dn;
+    };
+    std::vector<Child> children;
+    for (auto& m: candidateMoves(game, attacker)){
+        game.makeMove(m);
+        Child child;
+        child.move = m;
+        child.key = tableKey(game, plies - 1);
+        int replies = game.countLegalMoves();
+        if (replies == 0){
+            bool mate = attacker && game.isCheck(); // Otherwise stalemate, or the attacker mated
+            child.pn = mate ? 0 : INFINITE_NUMBER;
+            child.dn = mate ? INFINITE_NUMBER : 0;
+        } else if (plies - 1 == 0){
+            child.pn = INFINITE_NUMBER;
+            child.dn = 0;
+        } else {
+            child.pn = attacker ? replies : 1;
+            child.dn = 1;
+        }
+        game.unmakeMove();
+        children.push_back(child);
+    }
+
+    while (true){
+        uint32_t best = INFINITE_NUMBER, secondBest = INFINITE_NUMBER, sum = 0;
+        size_t bestIndex = 0;
+        for (size_t i = 0; i < children.size(); i++){
+            Entry* entry = probe(children[i].key);
+            if (entry != nullptr){
+                children[i].pn = entry->pn;
+                children[i].dn = entry->dn;
+            }
+            uint32_t selecting = attacker ? children[i].pn : children[i].dn;
+            sum = addNumbers(sum, attacker ? children[i].dn : children[i].pn);
+            if (selecting < best){
+                secondBest = best;
+                best = selecting;
+                bestIndex = i;
+            } else if (selecting < secondBest){
+                secondBest = selecting;
+            }
+        }
+        uint32_t pn = attacker ? best : sum;
+        uint32_t dn = attacker ? sum : best;
+
+        if (pn >= pnLimit || dn >= dnLimit || aborted){
+            store(key, pn, dn, nodes - startNodes);
+            return;
+        }
+
+        Child& child = children[bestIndex];
+        uint32_t childPnLimit, childDnLimit;
+        uint32_t switchLimit = addNumbers(secondBest, secondBest / EPSILON_DIVISOR + 1);
+        if (attacker){
+            childPnLimit = std::min(pnLimit, switchLimit);
+            childDnLimit = dnLimit - dn + child.dn;
+        } else {
+            childPnLimit = pnLimit - pn + child.pn;
+            childDnLimit = std::min(dnLimit, switchLimit);
+        }
+        game.makeMove(child.move);
+        mid(game, plies - 1, !attacker, childPnLimit, childDnLimit, child.key);
+        game.unmakeMove();
+    }
+}
+
+
+bool MateSolver::proven(Game& game, int plies, bool attacker){
+    if (game.countLegalMoves() == 0){
+        return !attacker && game.isCheck();
+    }
+    if (plies == 0){
+        return false;
+    }
+
+    // A proof number of 0 is only ever stored for a proven position, even by a search cut off by the budget
+    uint64_t key = tableKey(game, plies);
+    Entry* entry = probe(key);
+    if (!aborted && (entry == nullptr || (entry->pn != 0 && entry->dn != 0))){
+        mid(game, plies, attacker, INFINITE_NUMBER, INFINITE_NUMBER, key);
+        entry = probe(key);
+    }
+    return entry != nullptr && entry->pn == 0;
+}
+
+
+int MateSolver::mateDistance(Game& game, int maxPlies, bool attacker){
+    for (int plies = attacker ? 1 : 0; plies <= maxPlies; plies += 2){
+        if (proven(game, plies, attacker)){
+            return plies;
+        }
+    }
+    return -1;
+}
+
+
+// The attacker plays the move that mates soonest, and the defender the move that puts it off longest.
+// Finding how soon a move mates can mean searching it at fewer plies than it was proven in. Once the budget has run out,
+// only positions already proven in the table are followed, so the line is still a forced mate, but may not be the longest
+// resistance, and is cut short if the table has lost the proof of the next move.
+void MateSolver::buildLine(Game& game, int plies, bool attacker, std::vector<Move>& line){
+    if (plies == 0){
+        return;
+    }
+
+    Move bestMove = noMove();
+    int bestDistance = -1;
+    for (auto& m: candidateMoves(game, attacker)){
+        game.makeMove(m);
+        int distance = mateDistance(game, plies - 1, !attacker);
+        game.unmakeMove();
+        if (distance >= 0 && (bestDistance < 0 || (attacker ? distance < bestDistance : distance > bestDistance))){
+            bestMove = m;
+            bestDistance = distance;
+        }
+    }
+    if (bestDistance < 0){
+        return;
+    }
+
+    line.push_back(bestMove);
+    game.makeMove(bestMove);
+    buildLine(game, bestDistance, !attacker, line);
+    game.unmakeMove();
+}
+
+
+// Mates in 1, 2, ... moves are looked for in turn, so the first one found is the shortest
+MateResult MateSolver::solve(Game& game, int maxMoves){
+    MateResult result;
+    result.status = MateStatus::NO_MATE;
+    result.moves = 0;
+    nodes = 0;
+    budget = options.nodes;
+    aborted = false;
+
+    for (int moves = 1; moves <= maxMoves; moves++){
+        if (proven(game, 2*moves - 1, true)){
+            result.status = MateStatus::FOUND;
+            result.moves = moves;
+            break;
+        }
+        if (aborted){
+            result.status = MateStatus::UNKNOWN;
+            break;
+        }
+    }
+
+    // The line is built with whatever is left of the budget, then from the table
+    if (result.status == MateStatus::FOUND){
+        buildLine(game, 2*result.moves - 1, true, result.line);
+    }
+    result.nodes = nodes;
+    return result;
+}
@@ -0,0 +1,110 @@
+#include <vector>
+#include <cstdint>
+
+#include "game.hpp"
+#include "move.hpp"
+
+#pragma once
+
+
+struct MateOptions{
+    // Size of the proof and disproof number table, as a power of 2 entries. Its memory is fixed (24 bytes per entry);
+    // when it is full, the entries that took the least work to find are replaced.
+    int hashBits = 18;
+
+    // Only search checking moves for the player giving mate, as puzzle solvers often do. Much faster,
+    // but misses mates that start with a quiet move.
+    bool checksOnly = false;
+
+    // Node budget for a solve() call (positions expanded), or 0 for none
+    uint64_t nodes = 1000000;
+};
+
+
+enum class MateStatus{
+    FOUND,
+    NO_MATE, // There is no mate in the number of moves given (with checksOnly, none made up of checks)
+    UNKNOWN  // The node budget ran out first
+};
+
+
+struct MateResult{
+    MateStatus status;
+    int moves;              // Number of moves by the player giving mate, if found (1 for mate in 1)
+    std::vector<Move> line; // Moves from the position to checkmate, with the defender's longest resistance, if found.
+                            // If the node budget ran out while working it out, it is made up from positions the search
+                            // had already proven, so may not be the longest resistance, and may be cut short (fewer than 2*moves - 1).
+    uint64_t nodes;         // Positions expanded
+};
+
+
+// Finds forced checkmates with depth-first proof-number search (df-pn).
+//
+// Proof-number search only asks whether the player to move can force mate, not how good each move is:
+// a position's proof number is the least number of leaf positions that would have to turn out to be mate
+// to prove it, and its disproof number the least that would have to turn out not to be to disprove it.
+// The search always expands the most proving position, so it goes straight down forcing lines and needs no evaluation.
+// The depth-first variant keeps only the current line in memory, with the numbers of other positions in a fixed-size table.
+//
+// Positions are keyed by the number of plies left as well as their hash, so each (position, plies) pair is searched
+// once, and transpositions can't form cycles.
+class MateSolver{
+
+    public:
+
+        MateSolver(const MateOptions& options = MateOptions());
+
+        // Looks for a checkmate by the player whose turn it is within maxMoves of their moves, and returns the shortest.
+        // The game is left in the position it was in.
+        MateResult solve(Game& game, int maxMoves);
+
+        // Forgets all previous searches
+        void clear();
+
+    private:
+
+        struct Entry{
+            uint64_t key;
+            uint32_t pn; // Proof number
+            uint32_t dn; // Disproof number
+            uint64_t work; // Positions expanded to find these numbers, for choosing what to replace
+        };
+
+        // Searches the current position until its proof number reaches pnLimit or its disproof number reaches dnLimit.
+        // attacker is true if the player to move is the one giving mate. key is the position's table key.
+        void mid(Game& game, int plies, bool attacker, uint32_t pnLimit, uint32_t dnLimit, uint64_t key);
+
+        // Returns true if the current position is proven to be mate within the given plies, searching it if it isn't known
+        // (unless the budget has run out)
+        bool proven(Game& game, int plies, bool attacker);
+
+        // Returns the fewest plies (up to maxPlies) the current position is proven mate in, or -1 if none
+        int mateDistance(Game& game, int maxPlies, bool attacker);
+
+        // Appends the mating line from the current position, proven mate in plies, to line
+        void buildLine(Game& game, int plies, bool attacker, std::vector<Move>& line);
+
+        // The moves to search from the current position: all legal moves, or for the attacker with checksOnly, the checks
+        std::vector<Move> candidateMoves(Game& game, bool attacker);
+
+        // Table key of the current position with the given plies left
+        uint64_t tableKey(Game& game, int plies);
+
+        // The entry for key, or nullptr if it isn't in the table
+        Entry* probe(uint64_t key);
+
+        void store(uint64_t key, uint32_t pn, uint32_t dn, uint64_t work);
+
+        MateOptions options;
+
+        // Buckets of 2 entries
+        std::vector<Entry> table;
+
+        uint64_t nodes;
+
+        // Node budget of the current search, 0 for none
+        uint64_t budget;
+
+        // Set once the budget has run out, after which every position returns straight away
+        bool aborted;
+};
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "mate.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "pgn.hpp"
+
+
+// Checks puzzle positions for forced mates: reads one FEN per line, and writes for each (in the same order)
+// the FEN, then "MATE IN n" with the mating line in SAN (ending in "..." if the budget ran out before it was complete),
+// "NO MATE", "UNKNOWN" if the node budget ran out, or "INVALID FEN".
+// Positions are shared out between threads, each with its own solver.
+//
+// Usage: chess_mate [options]
+//   --input FILE        read positions from FILE (default: standard input)
+//   --moves N           look for mates in up to N moves (default 3)
+//   --nodes N           node budget per position, 0 for none (default 1000000)
+//   --hash BITS         size of each thread's proof number table, as a power of 2 entries (default 18)
+//   --checks-only on    only consider checking moves for the player giving mate
+//   --threads N         number of worker threads (default: number of hardware threads)
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_mate [--input FILE] [--moves N] [--nodes N] [--hash BITS] [--checks-only on|off] [--threads N]" << std::endl;
+}
+
+
+// Result line for a position
+std::string solvePosition(MateSolver& solver, const std::string& fen, int maxMoves, MateResult& result){
+    if (!Game::isValidFen(fen)){
+        result.status = MateStatus::UNKNOWN;
+        result.nodes = 0;
+        return fen + " | INVALID FEN";
+    }
+    Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+    Game game(&white, &black, fen);
+    result = solver.solve(game, maxMoves);
+
+    if (result.status == MateStatus::NO_MATE){
+        return fen + " | NO MATE";
+    }
+    if (result.status == MateStatus::UNKNOWN){
+        return fen + " | UNKNOWN";
+    }
+    std::string line = fen + " | MATE IN " + std::to_string(result.moves) + " |";
+    for (auto& m: result.line){
+        line += " " + moveToSan(game, m);
+        game.makeMove(m);
+    }
+    return line + (((int)result.line.size() == 2*result.moves - 1) ? "#" : " ..."); // The line is cut short if the budget ran out
+}
+
+
+int main(int argc, char* argv[]){
+    MateOptions options;
+    std::string inputPath;
+    int maxMoves = 3;
+    int numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--input"){ inputPath = value; }
+        else if (arg == "--moves"){ maxMoves = std::max(1, atoi(value.c_str())); }
+        else if (arg == "--nodes"){ options.nodes = strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--hash"){ options.hashBits = std::min(30, std::max(1, atoi(value.c_str()))); }
+        else if (arg == "--checks-only" && (value == "on" || value == "off")){ options.checksOnly = (value == "on"); }
+        else if (arg == "--threads"){ numThreads = std::max(1, atoi(value.c_str())); }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::ifstream file;
+    if (!inputPath.empty()){
+        file.open(inputPath);
+        if (!file){
+            std::cerr << "ERROR: COULD NOT OPEN INPUT FILE " << inputPath << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = inputPath.empty() ? std::cin : file;
+    std::vector<std::string> fens;
+    std::string line;
+    while (std::getline(in, line)){
+        if (!line.empty()){
+            fens.push_back(line);
+        }
+    }
+
+    std::vector<std::string> output(fens.size());
+    std::vector<MateResult> results(fens.size());
+    std::atomic<size_t> next(0);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++){
+        threads.emplace_back([&](){
+            MateSolver solver(options);
+            for (size_t i = next++; i < fens.size(); i = next++){
+                output[i] = solvePosition(solver, fens[i], maxMoves, results[i]);
+            }
+        });
+    }
+    for (auto& thread: threads){
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int found = 0, noMate = 0, unknown = 0;
+    uint64_t nodes = 0;
+    for (size_t i = 0; i < fens.size(); i++){
+        std::cout << output[i] << std::endl;
+        switch (results[i].status){
+            case MateStatus::FOUND: found++; break;
+            case MateStatus::NO_MATE: noMate++; break;
+            case MateStatus::UNKNOWN: unknown++; break;
+        }
+        nodes += results[i].nodes;
+    }
+
+    std::cerr << "POSITIONS: " << fens.size() << " (THREADS: " << numThreads << ")" << std::endl;
+    std::cerr << "MATES: " << found << "  NO MATE: " << noMate << "  UNKNOWN: " << unknown << std::endl;
+    std::cerr << "TIME: " << seconds << " s  NODES/S: " << (long)(nodes / std::max(seconds, 1e-9)) << std::endl;
+    return 0;
+}
@@ -0,0 +1,328 @@
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "mcts.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+#include "eval.hpp"
+
+
+// Stages of a node. A node is expanded by the thread that moves it from UNEXPANDED to EXPANDING, which then writes the
+// children and sets it to EXPANDED; threads only descend into a node's children once they see EXPANDED.
+enum NodeState : uint8_t{
+    UNEXPANDED,
+    EXPANDING,
+    EXPANDED,
+    TERMINAL // Checkmate or a draw, so there is nothing to expand
+};
+
+
+// Results, in thousandths of a point
+static const uint32_t WIN = 1000;
+static const uint32_t DRAW = 500;
+
+// Average result assumed for a child that hasn't been visited, in PUCT selection
+static const double FIRST_PLAY_VALUE = 0.5;
+
+// Static evaluation (in centipawns) at the end of a playout that would be worth about 3/4 of a point
+static const double EVAL_SCALE = 400;
+
+
+// xorshift64*: fast, and plenty random enough for picking moves
+static uint64_t nextRandom(uint64_t& state){
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+
+// Weight of a move in the light policy: captures by the value of the piece captured, and promotions to a queen, are favoured
+static double policyWeight(const std::array<std::array<Piece*, 8>, 8>& board, const Move& m){
+    double weight = 1;
+    Piece* victim = board[rankOf(m.dest)][fileOf(m.dest)];
+    if (victim != nullptr && victim->getColor() != board[rankOf(m.start)][fileOf(m.start)]->getColor()){
+        weight += pieceValue(victim) / 100.0;
+    }
+    if (m.promotion == 'q'){
+        weight += PIECE_VALUES[4] / 100.0;
+    }
+    return weight;
+}
+
+
+MctsSearcher::MctsSearcher(const MctsOptions& options) : options(options), pool(new Node[std::max<size_t>(1, options.poolSize)]) {
+    this->options.poolSize = std::max<size_t>(1, options.poolSize);
+    this->options.numThreads = std::max(1, options.numThreads);
+    nextFree = 0;
+    totalPlayouts = 0;
+    stopping = false;
+}
+
+
+// Clears a node for reuse. A template as Node is private to MctsSearcher.
+template<typename Node>
+static void resetNode(Node& node, uint16_t move, float prior){
+    node.visits.store(0, std::memory_order_relaxed);
+    node.virtualLosses.store(0, std::memory_order_relaxed);
+    node.value.store(0, std::memory_order_relaxed);
+    node.firstChild.store(0, std::memory_order_relaxed);
+    node.numChildren.store(0, std::memory_order_relaxed);
+    node.state.store(UNEXPANDED, std::memory_order_relaxed);
+    node.move = move;
+    node.prior = prior;
+}
+
+
+// Every thread searches until one of them sees a limit reached. The root's children are then ranked by visits,
+// as the most visited move is the one the search trusts most (a move with a high average may have few playouts).
+MctsResult MctsSearcher::search(Game& game, const MctsLimits& searchLimits){
+    limits = searchLimits;
+    startTime = std::chrono::steady_clock::now();
+    stopping = false;
+    totalPlayouts = 0;
+    threadPlayouts.assign(options.numThreads, 0);
+
+    Node& root = pool[0];
+    resetNode(root, 0, 1);
+    nextFree = 1;
+
+    Position rootPosition = game.snapshot();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.numThreads; t++){
+        workers.push_back(std::thread(&MctsSearcher::worker, this, std::cref(rootPosition), t));
+    }
+    for (auto& w: workers){
+        w.join();
+    }
+
+    MctsResult result;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    result.seconds = elapsed.count();
+    result.playouts = totalPlayouts;
+    result.threadPlayouts = threadPlayouts;
+    result.nodesUsed = std::min(nextFree.load(), options.poolSize);
+
+    uint32_t first = root.firstChild, bestChild = first;
+    for (uint32_t c = first; c < first + root.numChildren; c++){
+        result.rootVisits.push_back(std::make_pair(unpackMove(pool[c].move), pool[c].visits.load()));
+        if (pool[c].visits > pool[bestChild].visits){
+            bestChild = c;
+        }
+    }
+    std::stable_sort(result.rootVisits.begin(), result.rootVisits.end(), [](const std::pair<Move, uint32_t>& a, const std::pair<Move, uint32_t>& b){
+        return a.second > b.second;
+    });
+
+    if (root.numChildren > 0){
+        result.bestMove = unpackMove(pool[bestChild].move);
+        uint32_t visits = pool[bestChild].visits;
+        result.score = (visits > 0) ? pool[bestChild].value / (double)WIN / visits : FIRST_PLAY_VALUE;
+    } else { // The pool is too small to hold the root's children
+        result.bestMove = game.legalMoves()[0];
+        result.score = FIRST_PLAY_VALUE;
+    }
+    return result;
+}
+
+
+bool MctsSearcher::limitReached(){
+    if (limits.stop != nullptr && limits.stop->load(std::memory_order_relaxed)){
+        return true;
+    }
+    if (limits.playouts > 0 && totalPlayouts.load(std::memory_order_relaxed) >= limits.playouts){
+        return true;
+    }
+    if (limits.timeMs > 0){
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+        if (elapsed.count() >= limits.timeMs){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void MctsSearcher::worker(const Position& root, int threadIndex){
+    Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+    Game game(&white, &black, root);
+    uint64_t rng = (options.seed + threadIndex + 1) * 0x9E3779B97F4A7C15ULL;
+    std::vector<uint32_t> path;
+
+    uint64_t playouts = 0;
+    do {
+        iterate(game, path, rng);
+        playouts++;
+        totalPlayouts.fetch_add(1, std::memory_order_relaxed);
+        if (limitReached()){
+            stopping.store(true, std::memory_order_relaxed);
+        }
+    } while (!stopping.load(std::memory_order_relaxed));
+    threadPlayouts[threadIndex] = playouts;
+}
+
+
+// Virtual losses are added to each node on the way down, and taken off again on the way back up.
+// They count as visits with a result of 0, which makes the path look worse to the other threads until the result is in.
+void MctsSearcher::iterate(Game& game, std::vector<uint32_t>& path, uint64_t& rng){
+    path.clear();
+    path.push_back(0);
+    uint32_t node = 0;
+    while (pool[node].state.load(std::memory_order_acquire) == EXPANDED){
+        node = select(node);
+        pool[node].virtualLosses.fetch_add(options.virtualLoss, std::memory_order_relaxed);
+        game.makeMove(unpackMove(pool[node].move));
+        path.push_back(node);
+    }
+
+    uint32_t result; // For the player to move at the leaf
+    std::vector<Move> moves = game.legalMoves();
+    GameState state = moves.empty() ? (game.isCheck() ? GameState::CHECKMATE : GameState::STALEMATE) : game.getGameState();
+    if (state != GameState::CONTESTED){
+        result = (state == GameState::CHECKMATE) ? 0 : DRAW;
+        pool[node].state.store(TERMINAL, std::memory_order_relaxed);
+    } else {
+        uint8_t unexpanded = UNEXPANDED;
+        if (pool[node].state.compare_exchange_strong(unexpanded, EXPANDING, std::memory_order_relaxed)){
+            bool expanded = expand(node, game, moves);
+            pool[node].state.store(expanded ? EXPANDED : UNEXPANDED, std::memory_order_release);
+        }
+        result = playout(game, rng);
+    }
+
+    // Each node's value is for the player who made the move into it, which alternates going up the path
+    uint32_t value = WIN - result;
+    for (size_t k = path.size(); k-- > 0; ){
+        Node& n = pool[path[k]];
+        n.visits.fetch_add(1, std::memory_order_relaxed);
+        n.value.fetch_add(value, std::memory_order_relaxed);
+        if (k > 0){
+            n.virtualLosses.fetch_sub(options.virtualLoss, std::memory_order_relaxed);
+            game.unmakeMove();
+        }
+        value = WIN - value;
+    }
+}
+
+
+uint32_t MctsSearcher::select(uint32_t node){
+    Node& parent = pool[node];
+    uint32_t first = parent.firstChild.load(std::memory_order_relaxed);
+    uint32_t numChildren = parent.numChildren.load(std::memory_order_relaxed);
+    double parentVisits = std::max<double>(1, parent.visits.load(std::memory_order_relaxed) + parent.virtualLosses.load(std::memory_order_relaxed));
+    double logParent = std::log(parentVisits);
+    double sqrtParent = std::sqrt(parentVisits);
+
+    uint32_t best = first;
+    double bestScore = -1;
+    for (uint32_t c = first; c < first + numChildren; c++){
+        Node& child = pool[c];
+        uint32_t visits = child.visits.load(std::memory_order_relaxed) + child.virtualLosses.load(std::memory_order_relaxed);
+        double score;
+        if (options.selection == MctsSelection::UCT){
+            if (visits == 0){
+                return c; // Every move is tried once before any is tried twice
+            }
+            score = child.value.load(std::memory_order_relaxed) / (double)WIN / visits + options.exploration * std::sqrt(logParent / visits);
+        } else {
+            double average = (visits == 0) ? FIRST_PLAY_VALUE : child.value.load(std::memory_order_relaxed) / (double)WIN / visits;
+            score = average + options.exploration * child.prior * sqrtParent / (1 + visits);
+        }
+        if (score > bestScore){
+            bestScore = score;
+            best = c;
+        }
+    }
+    return best;
+}
+
+
+// The children take a block of the pool, claimed with a single atomic add. If the block would run past the end of the pool,
+// it is abandoned, which leaves the pool full for every later expansion too.
+bool MctsSearcher::expand(uint32_t node, Game& game, const std::vector<Move>& moves){
+    size_t first = nextFree.fetch_add(moves.size(), std::memory_order_relaxed);
+    if (first + moves.size() > options.poolSize){
+        return false;
+    }
+
+    std::vector<double> weights(moves.size(), 1);
+    double totalWeight = moves.size();
+    if (options.selection == MctsSelection::PUCT){
+        std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+        totalWeight = 0;
+        for (size_t i = 0; i < moves.size(); i++){
+            weights[i] = policyWeight(board, moves[i]);
+            totalWeight += weights[i];
+        }
+    }
+
+    for (size_t i = 0; i < moves.size(); i++){
+        resetNode(pool[first + i], packMove(moves[i]), weights[i] / totalWeight);
+    }
+    pool[node].firstChild.store(first, std::memory_order_relaxed);
+    pool[node].numChildren.store(moves.size(), std::memory_order_relaxed);
+    return true;
+}
+
+
+const Move& MctsSearcher::pickMove(Game& game, const std::vector<Move>& moves, uint64_t& rng){
+    if (options.playout == MctsPlayout::RANDOM){
+        return moves[nextRandom(rng) % moves.size()];
+    }
+
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    std::vector<double> weights(moves.size());
+    double totalWeight = 0;
+    for (size_t i = 0; i < moves.size(); i++){
+        weights[i] = policyWeight(board, moves[i]);
+        totalWeight += weights[i];
+    }
+    double pick = (nextRandom(rng) >> 11) * (1.0 / 9007199254740992.0) * totalWeight;
+    for (size_t i = 0; i < moves.size(); i++){
+        pick -= weights[i];
+        if (pick < 0){
+            return moves[i];
+        }
+    }
+    return moves.back();
+}
+
+
+// A playout that doesn't finish within the ply limit is scored by the static evaluation, through a logistic curve
+uint32_t MctsSearcher::playout(Game& game, uint64_t& rng){
+    PieceColor leafColor = game.getTurn()->getColor();
+    int plies = 0;
+    uint32_t result; // For the player to move at the end of the playout
+    while (true){
+        std::vector<Move> moves = game.legalMoves();
+        if (moves.empty()){
+            result = game.isCheck() ? 0 : DRAW;
+            break;
+        }
+        if (game.getGameState() != GameState::CONTESTED){
+            result = DRAW;
+            break;
+        }
+        if (plies >= options.playoutPlies){
+            result = (uint32_t)std::lround(WIN / (1 + std::exp(-evaluate(game) / EVAL_SCALE)));
+            break;
+        }
+        game.makeMove(pickMove(game, moves, rng));
+        plies++;
+    }
+
+    if (game.getTurn()->getColor() != leafColor){
+        result = WIN - result;
+    }
+    for (int i = 0; i < plies; i++){
+        game.unmakeMove();
+    }
+    return result;
+}
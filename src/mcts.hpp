@@ -0,0 +1,145 @@
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+#include "game.hpp"
+#include "move.hpp"
+
+#pragma once
+
+
+// How a child is picked while descending the tree
+enum class MctsSelection{
+    UCT,  // Upper confidence bound: average result plus exploration * sqrt(ln(parent visits) / child visits)
+    PUCT  // Average result plus exploration * prior * sqrt(parent visits) / (1 + child visits), with priors from the light policy
+};
+
+
+// How moves are picked in a playout
+enum class MctsPlayout{
+    RANDOM, // Uniformly at random
+    LIGHT   // At random, weighted towards captures of valuable pieces and promotions
+};
+
+
+struct MctsOptions{
+    MctsSelection selection = MctsSelection::UCT;
+    MctsPlayout playout = MctsPlayout::RANDOM;
+
+    // Exploration constant (c in the formulas above)
+    double exploration = 1.4;
+
+    // Number of losses a thread adds to each node on its path while its playout is under way, so that other threads
+    // are steered to other parts of the tree
+    uint32_t virtualLoss = 3;
+
+    // A playout still going after this many plies is scored from the static evaluation
+    int playoutPlies = 40;
+
+    // Number of nodes in the pool, allocated once. Once they are all in use, leaves are no longer expanded,
+    // but playouts carry on from them.
+    size_t poolSize = 1 << 20;
+
+    int numThreads = 1;
+
+    // Thread i's random number generator is seeded with seed + i
+    uint64_t seed = 1;
+};
+
+
+// When to stop searching. At least one limit must be set.
+struct MctsLimits{
+    // Wall-clock time limit in milliseconds, or 0 for none
+    int64_t timeMs = 0;
+
+    // Total playouts, or 0 for no limit
+    uint64_t playouts = 0;
+
+    // Set to true (e.g. by another thread) to stop the search
+    const std::atomic<bool>* stop = nullptr;
+};
+
+
+struct MctsResult{
+    Move bestMove; // The most visited move at the root
+    double score;  // Average result of bestMove for the player to move: 1 win, 0.5 draw, 0 loss
+    uint64_t playouts;
+    std::vector<uint64_t> threadPlayouts; // Playouts by each thread
+    double seconds;
+    size_t nodesUsed;
+    std::vector<std::pair<Move, uint32_t>> rootVisits; // Visits of each root move, most visited first
+};
+
+
+// Monte Carlo tree search, tree-parallel: all threads share one tree, descending it from the root to a leaf by the
+// selection rule, expanding the leaf, playing a game out from it and adding the result to every node on the path.
+//
+// Node statistics are atomics updated without locks. A leaf is expanded by whichever thread claims it first; other threads
+// reaching it meanwhile play out from it without waiting. Each thread plays on its own copy of the root position.
+class MctsSearcher{
+
+    public:
+
+        MctsSearcher(const MctsOptions& options = MctsOptions());
+
+        // Searches the current position until a limit is reached, and returns the best move for the player whose turn it is.
+        // The game is left unchanged. There must be at least one legal move.
+        // The node pool is reused by every search, so nothing is allocated after the first one.
+        MctsResult search(Game& game, const MctsLimits& limits);
+
+    private:
+
+        // Results are in thousandths of a point (win 1000, draw 500, loss 0). A node's value is the total of the results
+        // of its playouts for the player who made the move into it.
+        struct Node{
+            std::atomic<uint32_t> visits;
+            std::atomic<uint32_t> virtualLosses;
+            std::atomic<uint64_t> value;
+            std::atomic<uint32_t> firstChild; // Index in the pool
+            std::atomic<uint16_t> numChildren;
+            std::atomic<uint8_t> state;       // See NodeState in mcts.cpp
+            uint16_t move;                    // Move into the node, packed by packMove()
+            float prior;                      // For PUCT, the probability the light policy gives the move
+        };
+
+        // Runs playouts on a copy of the root position until the search is stopped
+        void worker(const Position& root, int threadIndex);
+
+        // One descent, expansion, playout and backup. path is scratch space for the nodes descended through.
+        void iterate(Game& game, std::vector<uint32_t>& path, uint64_t& rng);
+
+        // Index of the child of node to descend to
+        uint32_t select(uint32_t node);
+
+        // Creates the children of node, for the legal moves of the game's current position. Returns false if the pool is full.
+        bool expand(uint32_t node, Game& game, const std::vector<Move>& moves);
+
+        // Plays the game out from the current position, and returns the result for the player to move.
+        // The moves are taken back before returning.
+        uint32_t playout(Game& game, uint64_t& rng);
+
+        // Picks one of moves with the playout policy
+        const Move& pickMove(Game& game, const std::vector<Move>& moves, uint64_t& rng);
+
+        bool limitReached();
+
+        MctsOptions options;
+
+        std::unique_ptr<Node[]> pool;
+
+        // Index of the next free node in the pool
+        std::atomic<size_t> nextFree;
+
+        // Limits of the current search, and the time it started
+        MctsLimits limits;
+        std::chrono::steady_clock::time_point startTime;
+
+        std::atomic<uint64_t> totalPlayouts;
+        std::vector<uint64_t> threadPlayouts;
+
+        std::atomic<bool> stopping;
+};
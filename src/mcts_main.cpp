@@ -0,0 +1,123 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+#include "mcts.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "pgn.hpp"
+
+
+// Searches a position with Monte Carlo tree search, once for each thread count given, and reports the move chosen
+// with the playouts per second in total and per thread, to show how the search scales with threads.
+//
+// Usage: chess_mcts [options]
+//   --fen FEN             position to search (default: the starting position)
+//   --time MS             time limit per search, in milliseconds (default 1000, unless --playouts is given)
+//   --playouts N          playout limit per search
+//   --threads N[,N...]    thread counts to search with (default 1)
+//   --selection uct|puct  child selection rule (default uct)
+//   --policy random|light playout move policy (default random)
+//   --playout-plies N     plies before a playout is scored by the static evaluation (default 40)
+//   --pool N              nodes in the tree's pool (default 1048576)
+//   --top N               root moves to list, most visited first (default 5)
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_mcts [--fen FEN] [--time MS] [--playouts N] [--threads N[,N...]] [--selection uct|puct] "
+              << "[--policy random|light] [--playout-plies N] [--pool N] [--top N]" << std::endl;
+}
+
+
+int main(int argc, char* argv[]){
+    MctsOptions options;
+    MctsLimits limits;
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    std::vector<int> threadCounts;
+    int top = 5;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--fen"){ fen = value; }
+        else if (arg == "--time"){ limits.timeMs = atoll(value.c_str()); }
+        else if (arg == "--playouts"){ limits.playouts = strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--threads"){
+            std::stringstream counts(value);
+            std::string count;
+            while (std::getline(counts, count, ',')){
+                threadCounts.push_back(std::max(1, atoi(count.c_str())));
+            }
+        }
+        else if (arg == "--selection" && (value == "uct" || value == "puct")){
+            options.selection = (value == "uct") ? MctsSelection::UCT : MctsSelection::PUCT;
+        }
+        else if (arg == "--policy" && (value == "random" || value == "light")){
+            options.playout = (value == "random") ? MctsPlayout::RANDOM : MctsPlayout::LIGHT;
+        }
+        else if (arg == "--playout-plies"){ options.playoutPlies = std::max(0, atoi(value.c_str())); }
+        else if (arg == "--pool"){ options.poolSize = std::max<size_t>(1, strtoull(value.c_str(), nullptr, 10)); }
+        else if (arg == "--top"){ top = std::max(0, atoi(value.c_str())); }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (limits.timeMs == 0 && limits.playouts == 0){
+        limits.timeMs = 1000;
+    }
+    if (threadCounts.empty()){
+        threadCounts.push_back(1);
+    }
+
+    if (!Game::isValidFen(fen)){
+        std::cerr << "ERROR: INVALID FEN" << std::endl;
+        return 1;
+    }
+    Player white(PieceColor::WHITE), black(PieceColor::BLACK);
+    Game game(&white, &black, fen);
+    if (game.legalMoves().empty()){
+        std::cerr << "ERROR: NO LEGAL MOVES" << std::endl;
+        return 1;
+    }
+
+    double baseRate = 0;
+    for (int threads: threadCounts){
+        options.numThreads = threads;
+        MctsSearcher searcher(options);
+        MctsResult result = searcher.search(game, limits);
+
+        double rate = result.playouts / std::max(result.seconds, 1e-9);
+        if (baseRate == 0){
+            baseRate = rate / threads;
+        }
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "THREADS " << threads << "  BEST " << moveToSan(game, result.bestMove)
+                  << std::setprecision(3) << "  SCORE " << result.score
+                  << "  PLAYOUTS " << result.playouts << std::setprecision(0) << "  PLAYOUTS/S " << rate
+                  << "  PER THREAD " << rate / threads << std::setprecision(2) << "  SPEEDUP " << rate / baseRate
+                  << "  NODES " << result.nodesUsed << std::endl;
+
+        std::cout << "  PLAYOUTS BY THREAD";
+        for (uint64_t playouts: result.threadPlayouts){
+            std::cout << " " << playouts;
+        }
+        std::cout << std::endl;
+        for (int i = 0; i < top && i < (int)result.rootVisits.size(); i++){
+            std::cout << "  " << std::setw(8) << std::left << moveToSan(game, result.rootVisits[i].first) << std::right
+                      << std::setw(10) << result.rootVisits[i].second << std::endl;
+        }
+        std::cout << std::defaultfloat;
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "move.hpp"
+#include "square.hpp"
+
+
+Move move(SquareIndex start, SquareIndex dest, char promotion){
+    Move res;
+    res.start = start;
+    res.dest = dest;
+    res.promotion = promotion;
+    return res;
+}
+
+
+Move move(const Square& start, const Square& dest, char promotion){
+    return move(squareIndex(start), squareIndex(dest), promotion);
+}
+
+
+bool operator==(const Move& a, const Move& b){
+    return a.start == b.start && a.dest == b.dest && a.promotion == b.promotion;
+}
+
+
+bool operator!=(const Move& a, const Move& b){
+    return !(a == b);
+}
+
+
+std::string moveToStr(const Move& m){
+    std::string res = squareToStr(m.start) + squareToStr(m.dest);
+    if (m.promotion != '\0'){
+        res += m.promotion;
+    }
+    return res;
+}
+
+
+bool isValidMoveStr(const std::string& str){
+    if (str.length() != 4 && str.length() != 5){ return false; }
+
+    if (!isValidSquareStr(str.substr(0, 2)) || !isValidSquareStr(str.substr(2, 2))){ return false; }
+
+    // Check promotion letter, if present
+    if (str.length() == 5){
+        char p = str[4];
+        if (p != 'q' && p != 'r' && p != 'b' && p != 'n'){ return false; }
+    }
+
+    return true;
+}
+
+
+Move moveFromStr(const std::string& str){
+    char promotion = (str.length() == 5) ? str[4] : '\0';
+    return move(squareIndexFromStr(std::string_view(str).substr(0, 2)), squareIndexFromStr(std::string_view(str).substr(2, 2)), promotion);
+}
+
+
+uint16_t packMove(const Move& move){
+    uint16_t promotion = 0;
+    switch (move.promotion){
+        case 'n': promotion = 1; break;
+        case 'b': promotion = 2; break;
+        case 'r': promotion = 3; break;
+        case 'q': promotion = 4; break;
+    }
+    return move.start | (move.dest << 6) | (promotion << 12);
+}
+
+
+Move unpackMove(uint16_t packed){
+    const char promotions[] = {'\0', 'n', 'b', 'r', 'q'};
+    int start = packed & 63;
+    int dest = (packed >> 6) & 63;
+    int promotion = (packed >> 12) & 7;
+    return move((SquareIndex)start, (SquareIndex)dest, (promotion <= 4) ? promotions[promotion] : '\0');
+}
\ No newline at end of file
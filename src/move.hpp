@@ -0,0 +1,55 @@
+#include <string>
+#include <cstdint>
+
+#include "square.hpp"
+
+#pragma once
+
+
+// A type that represents a single move, from start square to dest (destination) square.
+// Castling is represented as the king moving 2 squares towards the rook, e.g. "e1g1" for white castling short.
+//
+// promotion holds the piece a pawn reaching the last rank is promoted to,
+// using the same letters as the promotion prompt: 'q' (queen), 'r' (rook), 'b' (bishop) or 'n' (knight).
+// For all other moves it is '\0'.
+//
+// The squares are SquareIndexes, so a move is 3 bytes.
+struct Move{
+    SquareIndex start;
+    SquareIndex dest;
+    char promotion;
+};
+
+static_assert(sizeof(Move) == 3, "a move is 2 square indexes and a promotion letter");
+
+
+// Creates an instance of move struct, from square indexes or from Squares.
+Move move(SquareIndex start, SquareIndex dest, char promotion = '\0');
+Move move(const Square& start, const Square& dest, char promotion = '\0');
+
+
+// Returns true if both moves have the same start square, dest square and promotion piece.
+bool operator==(const Move& a, const Move& b);
+bool operator!=(const Move& a, const Move& b);
+
+
+// Returns a move in coordinate notation, i.e. start square string followed by dest square string,
+// followed by the promotion letter if the move is a promotion (e.g. "e2e4", "e7e8q").
+std::string moveToStr(const Move& m);
+
+
+// Check if a move string (e.g. "e2e4", "a7a8n") is valid. Valid move strings consist of 2 valid square strings,
+// optionally followed by one of the promotion letters 'q', 'r', 'b' or 'n'.
+bool isValidMoveStr(const std::string& str);
+
+
+// Takes a move string in coordinate notation, and returns a corresponding instance of the move struct.
+// THIS ASSUMES THAT THE STRING IS VALID. USE ISVALIDMOVESTR() TO CHECK FIRST.
+Move moveFromStr(const std::string& str);
+
+
+// Packs a move into 16 bits, the format used wherever moves are stored in bulk (self-play output, the server's journal,
+// training data, search trees): bits 0-5 start square (row*8 + col), bits 6-11 dest square,
+// bits 12-14 promotion (0 none, 1 knight, 2 bishop, 3 rook, 4 queen).
+uint16_t packMove(const Move& move);
+Move unpackMove(uint16_t packed);
\ No newline at end of file
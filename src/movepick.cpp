@@ -0,0 +1,235 @@
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstring>
+
+#include "movepick.hpp"
+#include "game.hpp"
+#include "move.hpp"
+#include "eval.hpp"
+#include "piece.hpp"
+#include "player.hpp"
+
+
+Move noMove(){
+    return move(squareIndex(0, 0), squareIndex(0, 0));
+}
+
+
+bool isNoMove(const Move& m){
+    return m.start == m.dest;
+}
+
+
+OrderingTables::OrderingTables(){
+    clear();
+}
+
+
+void OrderingTables::clear(){
+    for (int ply = 0; ply < MAX_PLY; ply++){
+        killers[ply][0] = killers[ply][1] = noMove();
+    }
+    memset(history, 0, sizeof(history));
+    for (int i = 0; i < 64; i++){
+        for (int j = 0; j < 64; j++){
+            counterMoves[i][j] = noMove();
+        }
+    }
+}
+
+
+// History scores are halved once one gets large, so that recent cutoffs count for more than old ones
+void OrderingTables::update(const Move& m, PieceColor color, int depth, int ply, const Move& prevMove){
+    if (ply < MAX_PLY && m != killers[ply][0]){
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = m;
+    }
+
+    int c = (color == PieceColor::WHITE) ? 0 : 1;
+    int& score = history[c][m.start][m.dest];
+    score += depth*depth;
+    if (score > (1 << 20)){
+        for (auto& byStart: history[c]){
+            for (auto& s: byStart){
+                s /= 2;
+            }
+        }
+    }
+
+    if (!isNoMove(prevMove)){
+        counterMoves[prevMove.start][prevMove.dest] = m;
+    }
+}
+
+
+bool isCaptureOrPromotion(Game& game, const Move& m){
+    if (m.promotion != '\0'){
+        return true;
+    }
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    Piece* target = board[rankOf(m.dest)][fileOf(m.dest)];
+    if (target != nullptr){
+        return target->getColor() != board[rankOf(m.start)][fileOf(m.start)]->getColor(); // Not Chess960 castling
+    }
+    // En passant - a pawn moving diagonally onto an empty square
+    return pieceType(board[rankOf(m.start)][fileOf(m.start)]) == 0 && fileOf(m.start) != fileOf(m.dest);
+}
+
+
+// Value of the piece a pawn is promoted to
+static int promotionValue(char promotion){
+    switch (promotion){
+        case 'n': return PIECE_VALUES[1];
+        case 'b': return PIECE_VALUES[2];
+        case 'r': return PIECE_VALUES[3];
+        default: return PIECE_VALUES[4];
+    }
+}
+
+
+MovePicker::MovePicker(Game& game, const std::vector<Move>& moves, const Move& hashMove, const OrderingTables* tables,
+                       int ply, const Move& prevMove, const OrderingOptions& options, bool capturesOnly)
+    : game(game), moves(moves), hashMove(hashMove), tables(tables), ply(ply), prevMove(prevMove), options(options), capturesOnly(capturesOnly) {
+
+    // The hash move is only used if it is legal here (the hash may collide with another position's)
+    if (!options.hashMove || capturesOnly || std::find(moves.begin(), moves.end(), hashMove) == moves.end()){
+        this->hashMove = noMove();
+    }
+    stage = Stage::HASH_MOVE;
+}
+
+
+// Captures are scored by MVV-LVA: victim value first, then least valuable attacker.
+// Underpromotions are always tried last, with the losing captures.
+void MovePicker::scoreCaptures(){
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    for (auto& m: moves){
+        if (m == hashMove){
+            continue;
+        }
+        if (!(options.captures || capturesOnly) || !isCaptureOrPromotion(game, m)){
+            if (!capturesOnly){
+                quiets.push_back({m, 0});
+            }
+            continue;
+        }
+
+        Piece* attacker = board[rankOf(m.start)][fileOf(m.start)];
+        Piece* victim = board[rankOf(m.dest)][fileOf(m.dest)];
+        int victimValue = (victim != nullptr) ? pieceValue(victim) : ((m.promotion != '\0') ? 0 : PIECE_VALUES[0]);
+        if (m.promotion != '\0'){
+            victimValue += promotionValue(m.promotion) - PIECE_VALUES[0];
+        }
+        int score = victimValue*8 - pieceType(attacker);
+
+        if (m.promotion != '\0' && m.promotion != 'q'){
+            badCaptures.push_back({m, score - 100000});
+        }
+        // Taking a piece worth at least as much as the attacker can't lose material, so only the other captures need an exchange evaluation
+        else if (victimValue >= pieceValue(attacker) || game.staticExchange(m) >= 0){
+            goodCaptures.push_back({m, score});
+        } else {
+            badCaptures.push_back({m, score});
+        }
+    }
+}
+
+
+void MovePicker::scoreQuiets(){
+    if (options.killers && tables != nullptr && ply < MAX_PLY){
+        for (auto& killer: tables->killers[ply]){
+            auto it = std::find_if(quiets.begin(), quiets.end(), [&](const ScoredMove& s){ return s.move == killer; });
+            if (it != quiets.end()){
+                killers.push_back(killer);
+                quiets.erase(it);
+            }
+        }
+    }
+
+    if (options.history && tables != nullptr){
+        int c = (game.getTurn()->getColor() == PieceColor::WHITE) ? 0 : 1;
+        Move counter = isNoMove(prevMove) ? noMove() : tables->counterMoves[prevMove.start][prevMove.dest];
+        for (auto& s: quiets){
+            s.score = tables->history[c][s.move.start][s.move.dest];
+            if (s.move == counter){
+                s.score += 1 << 20;
+            }
+        }
+    }
+}
+
+
+Move MovePicker::pickBest(std::vector<ScoredMove>& list, bool ordered){
+    size_t best = 0;
+    if (ordered){
+        for (size_t i = 1; i < list.size(); i++){
+            if (list[i].score > list[best].score){
+                best = i;
+            }
+        }
+    }
+    Move m = list[best].move;
+    list.erase(list.begin() + best);
+    return m;
+}
+
+
+bool MovePicker::next(Move& m){
+    while (true){
+        switch (stage){
+            case Stage::HASH_MOVE:
+                stage = Stage::SCORE_CAPTURES;
+                if (!isNoMove(hashMove)){
+                    m = hashMove;
+                    return true;
+                }
+                break;
+
+            // Not done until the hash move has been tried, as a cutoff on it saves generating and exchange-evaluating the captures
+            case Stage::SCORE_CAPTURES:
+                scoreCaptures();
+                stage = Stage::GOOD_CAPTURES;
+                break;
+
+            case Stage::GOOD_CAPTURES:
+                if (!goodCaptures.empty()){
+                    m = pickBest(goodCaptures, true);
+                    return true;
+                }
+                stage = capturesOnly ? Stage::DONE : Stage::KILLERS;
+                if (!capturesOnly){
+                    scoreQuiets();
+                }
+                break;
+
+            case Stage::KILLERS:
+                if (!killers.empty()){
+                    m = killers.front();
+                    killers.erase(killers.begin());
+                    return true;
+                }
+                stage = Stage::QUIETS;
+                break;
+
+            case Stage::QUIETS:
+                if (!quiets.empty()){
+                    m = pickBest(quiets, options.history && tables != nullptr);
+                    return true;
+                }
+                stage = Stage::BAD_CAPTURES;
+                break;
+
+            case Stage::BAD_CAPTURES:
+                if (!badCaptures.empty()){
+                    m = pickBest(badCaptures, true);
+                    return true;
+                }
+                stage = Stage::DONE;
+                break;
+
+            case Stage::DONE:
+                return false;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include <vector>
+#include <cstdint>
+
+#include "game.hpp"
+#include "move.hpp"
+
+#pragma once
+
+
+// Deepest ply the search keeps killer moves for
+const int MAX_PLY = 64;
+
+
+// A move that is never legal (a1 to a1), used where there is no move, e.g. no hash move
+Move noMove();
+bool isNoMove(const Move& m);
+
+
+// Move ordering state learned during a search, from the moves that caused beta cutoffs
+struct OrderingTables{
+    Move killers[MAX_PLY][2];  // Last 2 quiet moves to cause a cutoff at each ply, most recent first
+    int history[2][64][64];    // Per color (0 white, 1 black), start square and dest square: how often the quiet move caused cutoffs, weighted by depth
+    Move counterMoves[64][64]; // Per start and dest square of the previous move: the quiet reply that last caused a cutoff
+
+    OrderingTables();
+
+    // Forgets everything learned
+    void clear();
+
+    // Records a quiet move causing a cutoff at the given depth and ply, in reply to prevMove
+    void update(const Move& m, PieceColor color, int depth, int ply, const Move& prevMove);
+};
+
+
+// Which ordering techniques a picker uses. With all of them off, moves come out in the order they were generated.
+struct OrderingOptions{
+    bool hashMove = true;  // Try the hash move first
+    bool captures = true;  // Try captures before quiet moves, ordered by MVV-LVA, and split into winning and losing captures by SEE
+    bool killers = true;   // Try killer moves straight after the winning captures
+    bool history = true;   // Order quiet moves by the history and counter-move tables
+};
+
+
+// Hands out the legal moves of a position one at a time, in stages:
+//   1. the hash move (the best move found for the position by an earlier search)
+//   2. winning and equal captures (static exchange evaluation >= 0), most valuable victim first, then least valuable attacker
+//   3. killer moves
+//   4. quiet moves, by history score plus a bonus for the counter-move
+//   5. losing captures
+// Promotions count as captures. Each stage is only sorted when it is reached, so a cutoff early on saves the work of ordering
+// the later stages. Within a stage, the best remaining move is picked each time rather than sorting the whole stage.
+class MovePicker{
+
+    public:
+
+        // moves must be the legal moves of the game's current position, and must outlive the picker. tables may be nullptr.
+        // If capturesOnly is set, only stage 2 is used (for quiescence search), whatever the options.
+        MovePicker(Game& game, const std::vector<Move>& moves, const Move& hashMove, const OrderingTables* tables,
+                   int ply, const Move& prevMove, const OrderingOptions& options, bool capturesOnly = false);
+
+        // Sets m to the next move and returns true, or returns false if there are no moves left
+        bool next(Move& m);
+
+    private:
+
+        enum class Stage{ HASH_MOVE, SCORE_CAPTURES, GOOD_CAPTURES, KILLERS, QUIETS, BAD_CAPTURES, DONE };
+
+        struct ScoredMove{
+            Move move;
+            int score;
+        };
+
+        // Sorts the moves into captures and quiet moves, and scores the captures
+        void scoreCaptures();
+
+        // Scores the quiet moves, and takes the killers out of them
+        void scoreQuiets();
+
+        // Removes and returns the highest scoring move of a list (or the first, if not ordering)
+        Move pickBest(std::vector<ScoredMove>& list, bool ordered);
+
+        Game& game;
+        const std::vector<Move>& moves;
+        Move hashMove;
+        const OrderingTables* tables;
+        int ply;
+        Move prevMove;
+        OrderingOptions options;
+        bool capturesOnly;
+
+        Stage stage;
+        std::vector<ScoredMove> goodCaptures;
+        std::vector<ScoredMove> badCaptures;
+        std::vector<ScoredMove> quiets;
+        std::vector<Move> killers;
+};
+
+
+// True if a move captures a piece (including en passant) or is a promotion
+bool isCaptureOrPromotion(Game& game, const Move& m);
@@ -0,0 +1,177 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cctype>
+#include <cstdint>
+#include <algorithm>
+
+#include "packedgame.hpp"
+#include "square.hpp"
+
+
+static const std::string PIECE_CHARS = "PNBRQK";
+static const std::string CASTLING_CHARS = "KQkq";
+
+
+// Nibble value for a piece's FEN char, as described in PackedGame
+static uint8_t pieceCode(char c){
+    uint8_t code = PIECE_CHARS.find(toupper(c)) + 1;
+    return isupper(c) ? code : code + 8;
+}
+
+
+static char pieceChar(uint8_t code){
+    char c = PIECE_CHARS[(code & 7) - 1];
+    return (code & 8) ? tolower(c) : c;
+}
+
+
+PackedGame packFen(const std::string& fen){
+    std::istringstream stream(fen);
+    std::string placement, turn, castling, enPassant;
+    int halfmoveClock = 0, fullmoveNumber = 1;
+    stream >> placement >> turn >> castling >> enPassant;
+    stream >> halfmoveClock >> fullmoveNumber; // Optional, so keep the defaults if missing
+
+    PackedGame packed;
+    packed.squares.fill(0);
+    int i = 7, j = 0;
+    for (char c: placement){
+        if (c == '/'){
+            i--;
+            j = 0;
+        } else if (isdigit(c)){
+            j += c - '0';
+        } else {
+            int sq = i*8 + j;
+            packed.squares[sq / 2] |= pieceCode(c) << (4 * (sq % 2));
+            j++;
+        }
+    }
+
+    packed.flags = (turn == "b") ? 1 : 0;
+    for (int k = 0; k < 4; k++){
+        if (castling.find(CASTLING_CHARS[k]) != std::string::npos){
+            packed.flags |= 2 << k;
+        }
+    }
+
+    packed.enPassantFile = (enPassant == "-") ? -1 : squareFromStr(enPassant).col;
+    packed.halfmoveClock = std::min(halfmoveClock, 255);
+    packed.fullmoveNumber = fullmoveNumber;
+    packed.state = GameState::CONTESTED;
+    return packed;
+}
+
+
+// Castling rights are worked out as Game::castlingRights() does: the king and the rook still on the squares castling
+// starts from, and neither having moved
+PackedGame packPosition(const Position& position){
+    PackedGame packed;
+    packed.squares.fill(0);
+    for (int sq = 0; sq < 64; sq++){
+        if (position.pieces[sq] != '\0'){
+            packed.squares[sq / 2] |= pieceCode(position.pieces[sq]) << (4 * (sq % 2));
+        }
+    }
+
+    packed.flags = (position.turn == PieceColor::BLACK) ? 1 : 0;
+    for (int c = 0; c < 2; c++){
+        int row = (c == 0) ? 0 : 7;
+        int kingSq = row*8 + position.castlingKingCol[c];
+        if (position.pieces[kingSq] != ((c == 0) ? 'K' : 'k') || !(position.unmoved & ((uint64_t)1 << kingSq))){
+            continue;
+        }
+        for (int side = 0; side < 2; side++){
+            int rookSq = row*8 + position.castlingRookCol[c][side];
+            if (position.pieces[rookSq] == ((c == 0) ? 'R' : 'r') && (position.unmoved & ((uint64_t)1 << rookSq))){
+                packed.flags |= 2 << (2*c + side);
+            }
+        }
+    }
+
+    packed.enPassantFile = (position.enPassantSq < 0) ? -1 : position.enPassantSq % 8;
+    packed.halfmoveClock = std::min(position.halfmoveClock, 255);
+    packed.fullmoveNumber = position.ply/2 + 1;
+    packed.state = GameState::CONTESTED;
+    return packed;
+}
+
+
+std::string unpackToFen(const PackedGame& packed){
+    std::string fen;
+    for (int i = 7; i >= 0; i--){
+        int empty = 0;
+        for (int j = 0; j < 8; j++){
+            int sq = i*8 + j;
+            uint8_t code = (packed.squares[sq / 2] >> (4 * (sq % 2))) & 15;
+            if (code == 0){
+                empty++;
+                continue;
+            }
+            if (empty > 0){
+                fen += std::to_string(empty);
+                empty = 0;
+            }
+            fen += pieceChar(code);
+        }
+        if (empty > 0){
+            fen += std::to_string(empty);
+        }
+        if (i > 0){
+            fen += '/';
+        }
+    }
+
+    bool blackToMove = packed.flags & 1;
+    fen += blackToMove ? " b " : " w ";
+
+    std::string castling;
+    for (int k = 0; k < 4; k++){
+        if (packed.flags & (2 << k)){
+            castling += CASTLING_CHARS[k];
+        }
+    }
+    fen += castling.empty() ? "-" : castling;
+
+    // The en passant square is behind the pawn that has just advanced, which belongs to the player who is not to move
+    if (packed.enPassantFile < 0){
+        fen += " -";
+    } else {
+        fen += ' ';
+        fen += (char)('a' + packed.enPassantFile);
+        fen += blackToMove ? '3' : '6';
+    }
+
+    fen += " " + std::to_string(packed.halfmoveClock) + " " + std::to_string(packed.fullmoveNumber);
+    return fen;
+}
+
+
+int repetitionCount(const PackedGame& packed, uint64_t hash){
+    return std::count(packed.hashes.begin(), packed.hashes.end(), hash);
+}
+
+
+static const uint16_t PROMOTION_BIT = 1 << 12;
+
+
+void setLegalMoves(PackedGame& packed, const std::vector<Move>& moves){
+    packed.legalMoves.clear();
+    for (auto& m: moves){
+        if (m.promotion != '\0' && m.promotion != 'q'){ // Only keep 1 of the 4 promotions
+            continue;
+        }
+        uint16_t pair = m.start*64 + m.dest;
+        packed.legalMoves.push_back((m.promotion != '\0') ? (pair | PROMOTION_BIT) : pair);
+    }
+}
+
+
+bool isLegalMove(const PackedGame& packed, const Move& m){
+    uint16_t pair = m.start*64 + m.dest;
+    if (m.promotion != '\0'){
+        pair |= PROMOTION_BIT;
+    }
+    return std::find(packed.legalMoves.begin(), packed.legalMoves.end(), pair) != packed.legalMoves.end();
+}
@@ -0,0 +1,60 @@
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "game.hpp"
+#include "move.hpp"
+
+#pragma once
+
+
+// A game stored compactly, for holding many games at once (e.g. in the server).
+// A Game has 64 piece pointers, a heap-allocated piece for each piece on the board and a record of every move made,
+// whereas this holds 4 bits per square plus a few bytes of state, and only the hashes needed to detect repetitions.
+// To work with the game, unpack it into a Game with unpackToFen().
+struct PackedGame{
+    // 2 squares per byte (square row*8 + col is in byte (row*8 + col)/2, low 4 bits first).
+    // 0 is an empty square, 1-6 a white pawn, knight, bishop, rook, queen or king, and 9-14 the same black pieces.
+    std::array<uint8_t, 32> squares;
+
+    uint8_t flags;          // Bit 0 is set if black is to move, bits 1-4 are the castling rights K, Q, k, q
+    int8_t enPassantFile;   // File (col) of the en passant square, or -1 if there is none
+    uint8_t halfmoveClock;
+    uint16_t fullmoveNumber;
+    GameState state;        // State of the game after the last move
+
+    // Hashes (as given by Game::getHash()) of the positions since the last pawn move or capture, oldest first,
+    // as only these can be repeated.
+    std::vector<uint64_t> hashes;
+
+    // Legal moves in the position, as start*64 + dest with bit 12 set for a promotion (covering all 4 pieces).
+    // Kept so that a move can be validated without unpacking the game.
+    std::vector<uint16_t> legalMoves;
+};
+
+
+// Packs the position given by a FEN string. The hashes are left empty and the state CONTESTED.
+// THIS ASSUMES THAT THE FEN STRING IS VALID. USE GAME::ISVALIDFEN() TO CHECK FIRST.
+PackedGame packFen(const std::string& fen);
+
+
+// Packs a game's position taken with Game::snapshot(), the same as packFen() of the game's FEN but without building
+// and parsing the string. The hashes are left empty and the state CONTESTED.
+PackedGame packPosition(const Position& position);
+
+
+// Returns the packed game's position as a FEN string
+std::string unpackToFen(const PackedGame& packed);
+
+
+// Returns the number of times the position with the given hash has occurred in the packed game
+int repetitionCount(const PackedGame& packed, uint64_t hash);
+
+
+// Sets packed.legalMoves from the legal moves of the position (as returned by Game::legalMoves())
+void setLegalMoves(PackedGame& packed, const std::vector<Move>& moves);
+
+
+// Returns true if m is one of packed.legalMoves. A promotion must name the piece to promote to, and no other move may.
+bool isLegalMove(const PackedGame& packed, const Move& m);
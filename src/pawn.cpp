@@ -4,6 +4,8 @@
 
 #include "piece.hpp"
 #include "pawn.hpp"
+#include "instrument.hpp"
+#include "attacks.hpp"
 
 
 Pawn::Pawn(PieceColor color) : Piece(color){ 
@@ -11,13 +13,15 @@ Pawn::Pawn(PieceColor color) : Piece(color){
 }
 
 
-Pawn::Pawn() : Piece(){}
+Pawn::Pawn() : Piece(){
+    canBeCapturedEnPassant = false;
+}
 
 
 char Pawn::toChar(){ return (color==PieceColor::WHITE) ? 'P' : 'p'; }
 
 
-bool Pawn::isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board) {
+bool Pawn::isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board) {
     // PAWN MOVE CONDITIONS:
     // - Can move 1 row forward on same col if no piece at dest square
     // - Can move diagonally by 1 and take piece if opposition piece is on that square
@@ -30,7 +34,7 @@ bool Pawn::isLegalMove(const Square& start, const Square& dest, const std::array
     // as black pieces start on the last 2 rows and advance towards the first 2
 
 
-    Piece* pieceAtDest = board[dest.row][dest.col];
+    Piece* pieceAtDest = board[rankOf(dest)][fileOf(dest)];
     std::array<int, 2> disp = displacement(start, dest);
 
     // White pawns
@@ -44,7 +48,11 @@ bool Pawn::isLegalMove(const Square& start, const Square& dest, const std::array
                 return true;
             }
             // Moving 2 squares forward from starting rank
-            else if ( (disp[0] == 2 && disp[1] == 0) && !hasMoved && (board[dest.row-1][dest.col] == nullptr)){
+            else if ( (disp[0] == 2 && disp[1] == 0) && !hasMoved && (board[rankOf(dest)-1][fileOf(dest)] == nullptr)){
+                return true;
+            }
+            // Taking en passant
+            else if (isEnPassant(start, dest, board)){
                 return true;
             }
         }
@@ -65,7 +73,11 @@ bool Pawn::isLegalMove(const Square& start, const Square& dest, const std::array
                 return true;
             }
             // Moving 2 squares forward from starting rank
-            else if ( (disp[0] == -2 && disp[1] == 0) && !hasMoved && (board[dest.row+1][dest.col] == nullptr)){
+            else if ( (disp[0] == -2 && disp[1] == 0) && !hasMoved && (board[rankOf(dest)+1][fileOf(dest)] == nullptr)){
+                return true;
+            }
+            // Taking en passant
+            else if (isEnPassant(start, dest, board)){
                 return true;
             }
         }
@@ -79,57 +91,45 @@ bool Pawn::isLegalMove(const Square& start, const Square& dest, const std::array
 }
 
 
-std::vector<Square> Pawn::legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board) {
+std::vector<SquareIndex> Pawn::legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board) {
+    CHESS_TIME(LEGAL_DESTS);
+    CHESS_COUNT(LEGAL_DESTS_PAWN);
+    CHESS_COUNT(VECTORS_ALLOCATED);
     // Note that for black pawns, a move "forward" will have negative vertical (1st component) displacement,
     // as black pieces start on the last 2 rows and advance towards the first 2
 
-    std::vector<Square> dests;
+    std::vector<SquareIndex> dests;
 
-    // White pawns
-    if(color == PieceColor::WHITE){
-
-        // Moving 1 square forward
-        if (board[start.row+1][start.col] == nullptr){
-            dests.push_back( square(start.row+1, start.col) );
-
-            // Moving 2 squares forward from starting square
-            if (board[start.row+2][start.col] == nullptr && !hasMoved){
-                dests.push_back( square(start.row+2, start.col) );
-            }                
-        } 
-        
-        // Attacking diagonally by 1 square.
-        Piece* diagUpRight =  board[start.row+1][start.col+1]; // Piece diagonally right and upwards 1 square
-        Piece* diagUpLeft =  board[start.row+1][start.col-1]; // Piece diagonally left and upwards 1 square
-        if ( diagUpRight != nullptr && diagUpRight->getColor() == PieceColor::BLACK) { 
-            dests.push_back( square(start.row+1, start.col+1) );
-        }
-        if ( diagUpLeft != nullptr && diagUpLeft->getColor() == PieceColor::BLACK) { 
-            dests.push_back( square(start.row+1, start.col-1) ); 
+    // Direction pawn moves in: up the board (increasing rows) for white, down for black
+    int dir = (color == PieceColor::WHITE) ? 1 : -1;
+    int oneAhead = rankOf(start) + dir;
+    int twoAhead = rankOf(start) + 2*dir;
+
+    // A pawn on the last rank has no moves (it will have been promoted)
+    if (oneAhead < 0 || oneAhead > 7){
+        return dests;
+    }
+
+    // Moving 1 square forward
+    if (board[oneAhead][fileOf(start)] == nullptr){
+        dests.push_back( squareIndex(oneAhead, fileOf(start)) );
+
+        // Moving 2 squares forward from starting square
+        if (!hasMoved && twoAhead >= 0 && twoAhead < 8 && board[twoAhead][fileOf(start)] == nullptr){
+            dests.push_back( squareIndex(twoAhead, fileOf(start)) );
         }
     }
 
-    // Black pawns
-    else if(color == PieceColor::BLACK){
-
-        // Moving 1 square forward.
-        if (board[start.row-1][start.col] == nullptr){
-            dests.push_back( square(start.row-1, start.col) );
-
-            // Moving 2 squares forward from starting square.
-            if (board[start.row-2][start.col] == nullptr && !hasMoved){
-                dests.push_back( square(start.row-2, start.col) );
-            }                
-        } 
-        
-        // Attacking diagonally by 1 square.
-        Piece* diagUpRight = board[start.row-1][start.col+1]; // Piece diagonally right and upwards 1 square.
-        Piece* diagUpLeft = board[start.row-1][start.col-1]; // Piece diagonally left and upwards 1 square.
-        if ( diagUpRight != nullptr && diagUpRight->getColor() == PieceColor::WHITE ) { 
-            dests.push_back( square(start.row-1, start.col+1) );
+    // Attacking diagonally by 1 square, on either side: the squares are looked up in PAWN_ATTACKS, which leaves out
+    // those off the edge of the board
+    for (uint64_t mask = pawnAttacksFrom(color, start); mask != 0; mask &= mask - 1){
+        int sq = __builtin_ctzll(mask);
+        Piece* diag = board[sq / 8][sq % 8];
+        if ( diag != nullptr && diag->getColor() != color ) {
+            dests.push_back( sq );
         }
-        if ( diagUpLeft != nullptr && diagUpLeft->getColor() == PieceColor::WHITE ) { 
-            dests.push_back( square(start.row-1, start.col-1) ); 
+        else if ( isEnPassant(start, sq, board) ){
+            dests.push_back( sq );
         }
     }
 
@@ -137,6 +137,26 @@ std::vector<Square> Pawn::legalDests(const Square& start, const std::array<std::
 }
 
 
+// A pawn attacks the 2 squares diagonally in front of it.
+bool Pawn::attacks(SquareIndex start, SquareIndex target, const std::array<std::array<Piece*, 8>, 8>& /*board*/){
+    return pawnAttacksFrom(color, start) & squareBit(target);
+}
+
+
+bool Pawn::isEnPassant(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board){
+    int dir = (color == PieceColor::WHITE) ? 1 : -1;
+    std::array<int, 2> disp = displacement(start, dest);
+    if (disp[0] != dir || abs(disp[1]) != 1 || board[rankOf(dest)][fileOf(dest)] != nullptr){
+        return false;
+    }
+
+    // The pawn to be captured is beside this one, on the dest square's column
+    CHESS_COUNT(DYNAMIC_CASTS);
+    Pawn* beside = dynamic_cast<Pawn*>(board[rankOf(start)][fileOf(dest)]);
+    return beside != nullptr && beside->getColor() != color && beside->canBeCapturedEP();
+}
+
+
 bool Pawn::canBeCapturedEP(){
     return canBeCapturedEnPassant;
 }
@@ -144,4 +164,5 @@ bool Pawn::canBeCapturedEP(){
 
 bool Pawn::toggleEP(){
     canBeCapturedEnPassant = !canBeCapturedEnPassant;
+    return canBeCapturedEnPassant;
 }
\ No newline at end of file
@@ -17,19 +17,28 @@ class Pawn : public Piece {
 
         char toChar() override;
 
-        bool isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        bool isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
 
-        std::vector<Square> legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        std::vector<SquareIndex> legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board) override;
+
+        bool attacks(SquareIndex start, SquareIndex target, const std::array<std::array<Piece*, 8>, 8>& board) override;
 
         // Returns canBeCapturedEnPassant
         bool canBeCapturedEP();
 
         // If canBeCapturedEnPassant is true, sets it to false, and vice versa
+        // Returns the new value of canBeCapturedEnPassant
         bool toggleEP();
-    
+
     private:
 
+        // Determine if moving from start to dest is an en passant capture
+        // i.e. dest is 1 square diagonally forward, and is empty, and the square beside start on dest's column
+        // holds an opposition pawn that can be captured en passant.
+        bool isEnPassant(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board);
+
         // If the pawn can be captured en passant, is true.
         // Otherwise, false.
+        // Set by Game::movePiece() when the pawn advances 2 squares, and cleared when the next move is made.
         bool canBeCapturedEnPassant; 
 };
@@ -0,0 +1,188 @@
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "pawns.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "piece.hpp"
+#include "square.hpp"
+#include "zobrist.hpp"
+
+
+// Bonus for a passed pawn, by its row counted from its own side of the board
+static const int PASSED_BONUS[8] = {0, 10, 15, 25, 40, 65, 100, 0};
+
+static const int ISOLATED_PENALTY = 12;
+static const int DOUBLED_PENALTY = 12; // For each pawn on a file beyond the first
+static const int BACKWARD_PENALTY = 10;
+
+// Shield bonuses for a pawn 1 or 2 rows in front of the king, on the king's file or a file beside it,
+// and the penalty if there is neither
+static const int SHIELD_CLOSE_BONUS = 15;
+static const int SHIELD_FAR_BONUS = 8;
+static const int SHIELD_MISSING_PENALTY = 15;
+
+
+// Score for one color's pawns. pawnRows[c][f] has bit r set if color c has a pawn on file f and row r,
+// with rows counted from c's own side of the board, so both colors are scored the same way.
+static int scoreSide(const std::array<std::array<uint8_t, 8>, 2>& pawnRows, int us){
+    int them = 1 - us;
+    int score = 0;
+
+    for (int f = 0; f < 8; f++){
+        uint8_t ours = pawnRows[us][f];
+        if (ours == 0){
+            continue;
+        }
+        uint8_t left = (f > 0) ? pawnRows[us][f - 1] : 0;
+        uint8_t right = (f < 7) ? pawnRows[us][f + 1] : 0;
+
+        int count = __builtin_popcount(ours);
+        score -= DOUBLED_PENALTY * (count - 1);
+
+        for (int r = 1; r < 7; r++){
+            if (!(ours & (1 << r))){
+                continue;
+            }
+
+            bool isolated = (left | right) == 0;
+            if (isolated){
+                score -= ISOLATED_PENALTY;
+            }
+
+            // Passed - no opposition pawn in front of it on its own file or a file beside it.
+            // The opposition's rows are counted from the other side, so row r is row 7 - r for them.
+            bool passed = true;
+            for (int g = std::max(0, f - 1); g <= std::min(7, f + 1) && passed; g++){
+                uint8_t aheadMask = (uint8_t)((1 << (7 - r)) - 1); // Their rows 0 to 6 - r
+                if (pawnRows[them][g] & aheadMask){
+                    passed = false;
+                }
+            }
+            if (passed){
+                score += PASSED_BONUS[r];
+                continue;
+            }
+
+            // Backward - there are pawns beside it but they are all further forward, so none can support its advance,
+            // and the square in front of it is attacked by an opposition pawn. An isolated pawn is only penalised as such.
+            uint8_t levelOrBehind = (uint8_t)((2 << r) - 1); // Rows 0 to r
+            if (!isolated && ((left | right) & levelOrBehind) == 0 && r < 6){
+                int theirRow = 7 - (r + 2); // Their pawn 2 rows in front of ours attacks the square in front of it
+                bool stopAttacked = (f > 0 && (pawnRows[them][f - 1] & (1 << theirRow)))
+                                 || (f < 7 && (pawnRows[them][f + 1] & (1 << theirRow)));
+                if (stopAttacked){
+                    score -= BACKWARD_PENALTY;
+                }
+            }
+        }
+    }
+    return score;
+}
+
+
+PawnEntry evaluatePawnStructure(const std::array<std::array<Piece*, 8>, 8>& board, uint64_t key){
+    std::array<std::array<uint8_t, 8>, 2> pawnRows = {};
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            if (board[i][j] == nullptr){
+                continue;
+            }
+            int index = zobristPieceIndex(board[i][j]);
+            if (index == 0){ pawnRows[0][j] |= 1 << i; }
+            else if (index == 6){ pawnRows[1][j] |= 1 << (7 - i); }
+        }
+    }
+
+    PawnEntry entry;
+    entry.key = key;
+    entry.score = scoreSide(pawnRows, 0) - scoreSide(pawnRows, 1);
+    for (int c = 0; c < 2; c++){
+        for (int f = 0; f < 8; f++){
+            entry.rearmostPawn[c][f] = (pawnRows[c][f] == 0) ? 0 : __builtin_ctz(pawnRows[c][f]);
+        }
+    }
+    return entry;
+}
+
+
+int kingShield(const PawnEntry& entry, PieceColor color, SquareIndex kingSq){
+    int c = (color == PieceColor::WHITE) ? 0 : 1;
+    int kingRow = (c == 0) ? rankOf(kingSq) : 7 - rankOf(kingSq);
+    if (kingRow > 1){
+        return 0;
+    }
+
+    int score = 0;
+    int kingCol = fileOf(kingSq);
+    for (int f = std::max(0, kingCol - 1); f <= std::min(7, kingCol + 1); f++){
+        int pawnRow = entry.rearmostPawn[c][f];
+        if (pawnRow == kingRow + 1){ score += SHIELD_CLOSE_BONUS; }
+        else if (pawnRow == kingRow + 2){ score += SHIELD_FAR_BONUS; }
+        else { score -= SHIELD_MISSING_PENALTY; }
+    }
+    return score;
+}
+
+
+PawnTable::PawnTable(int bits){
+    entries.resize((size_t)1 << bits);
+    clear();
+}
+
+
+// An empty entry has key 0 and no pawns, which is also the correct entry for a position with no pawns (whose pawn hash is 0)
+void PawnTable::clear(){
+    PawnEntry empty;
+    empty.key = 0;
+    empty.score = 0;
+    empty.rearmostPawn = {};
+    std::fill(entries.begin(), entries.end(), empty);
+    hits = 0;
+    misses = 0;
+}
+
+
+const PawnEntry& PawnTable::probe(Game& game){
+    uint64_t key = game.getPawnHash();
+    PawnEntry& entry = entries[key & (entries.size() - 1)];
+    if (entry.key == key){
+        hits++;
+        return entry;
+    }
+    misses++;
+    entry = evaluatePawnStructure(game.getBoard(), key);
+    return entry;
+}
+
+
+uint64_t PawnTable::getHits(){
+    return hits;
+}
+
+
+uint64_t PawnTable::getMisses(){
+    return misses;
+}
+
+
+double PawnTable::getHitRate(){
+    uint64_t probes = hits + misses;
+    return (probes == 0) ? 0 : (double)hits / probes;
+}
+
+
+int evaluatePawns(Game& game, PawnTable* table){
+    PawnEntry uncached;
+    if (table == nullptr){
+        uncached = evaluatePawnStructure(game.getBoard(), game.getPawnHash());
+    }
+    const PawnEntry& entry = (table != nullptr) ? table->probe(game) : uncached;
+
+    int score = entry.score;
+    score += kingShield(entry, PieceColor::WHITE, game.getPlayer(PieceColor::WHITE)->getKingIndex());
+    score -= kingShield(entry, PieceColor::BLACK, game.getPlayer(PieceColor::BLACK)->getKingIndex());
+    return (game.getTurn()->getColor() == PieceColor::WHITE) ? score : -score;
+}
@@ -0,0 +1,69 @@
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "game.hpp"
+#include "piece.hpp"
+#include "square.hpp"
+
+#pragma once
+
+
+// Pawn structure of a position. Depends only on where the pawns are, so it can be cached by the game's pawn hash.
+struct PawnEntry{
+    uint64_t key; // Game::getPawnHash() of the position
+
+    // Passed, isolated, doubled and backward pawn terms, in centipawns, from white's point of view
+    int score;
+
+    // For each color (indexed by PieceColor) and file, the row of the color's rearmost pawn on the file,
+    // counted from the color's own side of the board (1-6), or 0 if the color has no pawn on the file.
+    // Used to score the pawn shield in front of wherever the king is.
+    std::array<std::array<int8_t, 8>, 2> rearmostPawn;
+};
+
+
+// Works out the pawn structure of the position on the board
+PawnEntry evaluatePawnStructure(const std::array<std::array<Piece*, 8>, 8>& board, uint64_t key);
+
+
+// Score for the pawns sheltering a king of the given color on kingSq, in centipawns, from that color's point of view.
+// Only a king on its first 2 rows is scored, as a king that has left them has no shield to speak of.
+int kingShield(const PawnEntry& entry, PieceColor color, SquareIndex kingSq);
+
+
+// Hash table of pawn structures, indexed by pawn hash. An entry is replaced whenever another position maps to its slot.
+// Pawns move in few of the positions a search visits, so most lookups are hits.
+class PawnTable{
+
+    public:
+
+        // Table of 2^bits entries
+        PawnTable(int bits = 12);
+
+        // Returns the game's pawn structure, working it out and storing it if it isn't in the table
+        const PawnEntry& probe(Game& game);
+
+        // Empties the table and resets the hit and miss counts
+        void clear();
+
+        uint64_t getHits();
+
+        uint64_t getMisses();
+
+        // Fraction of probes that were hits, or 0 if there haven't been any
+        double getHitRate();
+
+    private:
+
+        std::vector<PawnEntry> entries;
+
+        uint64_t hits;
+
+        uint64_t misses;
+};
+
+
+// Pawn structure and king shield score of the current position, in centipawns, from the point of view of the player
+// whose turn it is. The structure is taken from table if one is given, and worked out from scratch otherwise.
+int evaluatePawns(Game& game, PawnTable* table = nullptr);
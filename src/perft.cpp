@@ -0,0 +1,40 @@
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "perft.hpp"
+#include "game.hpp"
+#include "move.hpp"
+
+
+uint64_t perft(Game& game, int depth){
+    if (depth == 0){
+        return 1;
+    }
+
+    // At the last ply, the number of leaves is just the number of legal moves, which can be counted without generating them
+    if (depth == 1){
+        return game.countLegalMoves();
+    }
+
+    std::vector<Move> moves = game.legalMoves();
+
+    uint64_t nodes = 0;
+    for (auto& m: moves){
+        game.makeMove(m);
+        nodes += perft(game, depth - 1);
+        game.unmakeMove();
+    }
+    return nodes;
+}
+
+
+std::vector<std::pair<Move, uint64_t>> perftDivide(Game& game, int depth){
+    std::vector<std::pair<Move, uint64_t>> res;
+    for (auto& m: game.legalMoves()){
+        game.makeMove(m);
+        res.push_back(std::make_pair(m, (depth > 1) ? perft(game, depth - 1) : 1));
+        game.unmakeMove();
+    }
+    return res;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "game.hpp"
+#include "move.hpp"
+
+#pragma once
+
+
+// Counts the leaf nodes of the legal move tree of the given depth from the current position
+// (i.e. the number of distinct sequences of depth legal moves). Used to check move generation against
+// published reference counts. The game is left in the position it was in.
+uint64_t perft(Game& game, int depth);
+
+
+// Same as perft(), but broken down by the first move. Useful for finding which move a count differs on.
+std::vector<std::pair<Move, uint64_t>> perftDivide(Game& game, int depth);
\ No newline at end of file
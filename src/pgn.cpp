@@ -0,0 +1,284 @@
+#include <string>
+#include <vector>
+#include <array>
+#include <ostream>
+#include <istream>
+#include <sstream>
+#include <utility>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+
+#include "pgn.hpp"
+#include "game.hpp"
+#include "move.hpp"
+#include "piece.hpp"
+#include "square.hpp"
+
+
+std::string resultToStr(GameResult result){
+    switch (result){
+        case GameResult::WHITE_WINS: return "1-0";
+        case GameResult::BLACK_WINS: return "0-1";
+        case GameResult::DRAW: return "1/2-1/2";
+        default: return "*";
+    }
+}
+
+
+// SAN consists of:
+// - The piece letter (uppercase, omitted for pawns)
+// - If another piece of the same kind could also legally move to the dest square, the start file, rank or both,
+//   whichever is enough to tell the pieces apart. A pawn capture always gives the start file.
+// - 'x' if the move is a capture
+// - The dest square
+// - "=" followed by the promotion piece letter if the move is a promotion
+// Castling is written as "O-O" (short) or "O-O-O" (long).
+std::string moveToSan(Game& game, const Move& move){
+    return moveToSan(game, move, game.legalMoves());
+}
+
+
+std::string moveToSan(Game& game, const Move& move, const std::vector<Move>& legalMoves){
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    Piece* pieceToMove = board[rankOf(move.start)][fileOf(move.start)];
+    char pieceChar = toupper(pieceToMove->toChar());
+    int colDisp = fileOf(move.dest) - fileOf(move.start);
+
+    if (game.isCastling(move)){
+        return (colDisp > 0) ? "O-O" : "O-O-O";
+    }
+
+    // A pawn changing column is always a capture (including en passant, where the dest square is empty)
+    bool capture = board[rankOf(move.dest)][fileOf(move.dest)] != nullptr || (pieceChar == 'P' && colDisp != 0);
+
+    std::string res;
+    if (pieceChar == 'P'){
+        if (capture){
+            res += (char)('a' + fileOf(move.start));
+        }
+    } else {
+        res += pieceChar;
+
+        // Look for other pieces of the same kind that can move to the same dest square
+        bool ambiguous = false, sameFile = false, sameRank = false;
+        for (auto& other: legalMoves){
+            Piece* otherPiece = board[rankOf(other.start)][fileOf(other.start)];
+            bool sameStart = other.start == move.start;
+            bool sameDest = other.dest == move.dest;
+            if (!sameStart && sameDest && toupper(otherPiece->toChar()) == pieceChar){
+                ambiguous = true;
+                if (fileOf(other.start) == fileOf(move.start)){ sameFile = true; }
+                if (rankOf(other.start) == rankOf(move.start)){ sameRank = true; }
+            }
+        }
+        if (ambiguous){
+            if (!sameFile){
+                res += (char)('a' + fileOf(move.start));
+            } else if (!sameRank){
+                res += (char)('1' + rankOf(move.start));
+            } else {
+                res += (char)('a' + fileOf(move.start));
+                res += (char)('1' + rankOf(move.start));
+            }
+        }
+    }
+
+    if (capture){
+        res += 'x';
+    }
+    res += (char)('a' + fileOf(move.dest));
+    res += (char)('1' + rankOf(move.dest));
+
+    if (move.promotion != '\0'){
+        res += '=';
+        res += (char)toupper(move.promotion);
+    }
+
+    return res;
+}
+
+
+void writePgn(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& tags, const std::vector<std::string>& sanMoves, GameResult result){
+    writePgn(out, tags, sanMoves, std::vector<std::string>(sanMoves.size()), result);
+}
+
+
+void writePgn(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& tags, const std::vector<std::string>& sanMoves,
+              const std::vector<std::string>& annotations, GameResult result){
+    for (auto& tag: tags){
+        out << "[" << tag.first << " \"";
+        for (char c: tag.second){
+            if (c == '"' || c == '\\'){
+                out << '\\';
+            }
+            out << c;
+        }
+        out << "\"]\n";
+    }
+    out << "[Result \"" << resultToStr(result) << "\"]\n\n";
+
+    // Movetext, wrapped so that no line is longer than 80 chars (unless a single word is).
+    // Black's move is numbered too ("3... Nf6") when it follows an annotation, as it is no longer next to white's.
+    std::vector<std::string> words;
+    for (size_t i = 0; i < sanMoves.size(); i++){
+        std::string token;
+        if (i % 2 == 0){
+            token = std::to_string(i/2 + 1) + ". ";
+        } else if (!annotations[i - 1].empty()){
+            token = std::to_string(i/2 + 1) + "... ";
+        }
+        words.push_back(token + sanMoves[i]);
+
+        // A comment can be broken over lines like the rest of the movetext
+        std::istringstream annotation(annotations[i]);
+        std::string word;
+        while (annotation >> word){
+            words.push_back(word);
+        }
+    }
+    words.push_back(resultToStr(result));
+
+    std::string line;
+    for (auto& word: words){
+        if (!line.empty() && line.length() + 1 + word.length() > 80){
+            out << line << "\n";
+            line.clear();
+        }
+        if (!line.empty()){ line += " "; }
+        line += word;
+    }
+    out << line << "\n\n";
+}
+
+
+bool moveFromSan(Game& game, const std::string& san, Move& move){
+    std::string written = san;
+    while (!written.empty() && std::string("+#!?").find(written.back()) != std::string::npos){
+        written.pop_back();
+    }
+    if (written == "0-0" || written == "0-0-0"){
+        std::replace(written.begin(), written.end(), '0', 'O');
+    }
+    size_t n = written.size();
+    if (n >= 3 && std::string("QRBN").find(written[n - 1]) != std::string::npos && (written[n - 2] == '8' || written[n - 2] == '1')
+        && islower(written[0])){
+        written.insert(n - 1, "=");
+    }
+
+    std::vector<Move> legalMoves = game.legalMoves();
+    for (auto& m: legalMoves){
+        if (moveToSan(game, m, legalMoves) == written){
+            move = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Skips the rest of a comment or escape: up to the closing brace for '{', or the end of the line for ';' and '%'
+static void skipComment(std::istream& in, char opening){
+    char close = (opening == '{') ? '}' : '\n';
+    int c;
+    while ((c = in.get()) != EOF && c != close){}
+}
+
+
+// Reads a tag pair, after its opening '[': the name, then the value in quotes, in which \" and \\ are escapes
+static void readTag(std::istream& in, PgnGame& game){
+    std::string name, value;
+    bool quoted = false, escaped = false;
+    int c;
+    while ((c = in.get()) != EOF){
+        if (quoted){
+            if (escaped){ value += (char)c; escaped = false; }
+            else if (c == '\\'){ escaped = true; }
+            else if (c == '"'){ quoted = false; }
+            else { value += (char)c; }
+        } else if (c == '"'){
+            quoted = true;
+        } else if (c == ']'){
+            break;
+        } else if (!isspace(c)){
+            name += (char)c;
+        }
+    }
+    game.tags.push_back(std::make_pair(name, value));
+}
+
+
+bool readPgn(std::istream& in, PgnGame& game){
+    game.tags.clear();
+    game.sanMoves.clear();
+    game.result = GameResult::UNFINISHED;
+
+    bool started = false;
+    int variationDepth = 0;
+    std::string token;
+
+    // Returns true if the token ends the game
+    auto endToken = [&](){
+        std::string word;
+        std::swap(word, token);
+        if (word.empty() || variationDepth > 0 || word[0] == '$'){
+            return false;
+        }
+        if (word == "1-0" || word == "0-1" || word == "1/2-1/2" || word == "*"){
+            game.result = (word == "1-0") ? GameResult::WHITE_WINS : (word == "0-1") ? GameResult::BLACK_WINS
+                        : (word == "1/2-1/2") ? GameResult::DRAW : GameResult::UNFINISHED;
+            return true;
+        }
+        // A move number, possibly run into the move ("12.e4", "12...Nf6")
+        size_t start = 0;
+        while (start < word.size() && isdigit(word[start])){ start++; }
+        if (start < word.size() && word[start] == '.'){
+            while (start < word.size() && word[start] == '.'){ start++; }
+            word = word.substr(start);
+        }
+        if (!word.empty()){
+            game.sanMoves.push_back(word);
+        }
+        return false;
+    };
+
+    bool lineStart = true;
+    int c;
+    while ((c = in.get()) != EOF){
+        bool atLineStart = lineStart;
+        lineStart = c == '\n';
+
+        if (c == '[' && variationDepth == 0 && token.empty()){
+            if (!game.sanMoves.empty()){ // The next game's tags: this game's movetext had no result
+                in.unget();
+                return true;
+            }
+            readTag(in, game);
+            started = true;
+        } else if (c == '{' || c == ';' || (c == '%' && atLineStart)){
+            if (endToken()){ return true; }
+            skipComment(in, c);
+            lineStart = c != '{';
+        } else if (c == '(' || c == ')'){
+            if (endToken()){ return true; }
+            variationDepth = std::max(0, variationDepth + ((c == '(') ? 1 : -1));
+        } else if (isspace(c)){
+            if (endToken()){ return true; }
+        } else {
+            token += (char)c;
+            started = true;
+        }
+    }
+    endToken();
+    return started;
+}
+
+
+std::string pgnTag(const PgnGame& game, const std::string& name){
+    for (auto& tag: game.tags){
+        if (tag.first == name){
+            return tag.second;
+        }
+    }
+    return "";
+}
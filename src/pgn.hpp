@@ -0,0 +1,66 @@
+#include <string>
+#include <vector>
+#include <ostream>
+#include <istream>
+#include <utility>
+
+#include "game.hpp"
+#include "move.hpp"
+
+#pragma once
+
+
+// Result of a finished (or abandoned) game
+enum class GameResult{
+    WHITE_WINS,
+    BLACK_WINS,
+    DRAW,
+    UNFINISHED
+};
+
+
+// Returns the PGN result token for a game result: "1-0", "0-1", "1/2-1/2" or "*"
+std::string resultToStr(GameResult result);
+
+
+// Returns a move in standard algebraic notation (SAN), e.g. "e4", "Nxf3", "Rad1", "exd6", "e8=Q", "O-O".
+// The move must be legal for the player whose turn it is in game, and is not made.
+// Check (+) and checkmate (#) suffixes are not included, as these depend on the position after the move.
+std::string moveToSan(Game& game, const Move& move);
+
+// Same as above, but takes the legal moves in the position (as returned by game.legalMoves()) to save generating them again.
+std::string moveToSan(Game& game, const Move& move, const std::vector<Move>& legalMoves);
+
+
+// Finds the legal move, for the player whose turn it is, written in SAN as san, and sets move to it.
+// Check, checkmate and annotation suffixes (+, #, !, ?) are ignored, and castling can also be written with zeros ("0-0"),
+// and a promotion without the '=' ("e8Q"). Returns false if san isn't one of the legal moves.
+bool moveFromSan(Game& game, const std::string& san, Move& move);
+
+
+// A game read from PGN
+struct PgnGame{
+    std::vector<std::pair<std::string, std::string>> tags; // In the order given, including the Result tag
+    std::vector<std::string> sanMoves;                     // The main line, without move numbers, comments, NAGs or variations
+    GameResult result = GameResult::UNFINISHED;            // From the result at the end of the movetext
+};
+
+
+// Reads the next game from a stream of PGN games. Comments, NAGs and variations are skipped, and a game without a result
+// at the end of its movetext ends at the next game's tags. Returns false if there are no more games.
+// The moves are only split into tokens, not checked: use moveFromSan() to play them.
+bool readPgn(std::istream& in, PgnGame& game);
+
+// Returns the value of a game's tag, or an empty string if it has no such tag
+std::string pgnTag(const PgnGame& game, const std::string& name);
+
+
+// Writes a single game to a stream in PGN format.
+// sanMoves holds the game's moves in SAN, in the order they were played, starting with white's first move.
+// Tags are written in the order given, followed by the Result tag.
+void writePgn(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& tags, const std::vector<std::string>& sanMoves, GameResult result);
+
+// Same as above, with an annotation after each move, such as NAGs and a comment (e.g. "$2 {Mistake}").
+// annotations has an entry for each move, empty for a move without one.
+void writePgn(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& tags, const std::vector<std::string>& sanMoves,
+              const std::vector<std::string>& annotations, GameResult result);
@@ -2,6 +2,8 @@
 #include <string>
 
 #include "piece.hpp"
+#include "instrument.hpp"
+#include "attacks.hpp"
 
 
 Piece::Piece(){
@@ -24,6 +26,11 @@ bool Piece::getHasMoved(){
 }
 
 
+void Piece::setHasMoved(bool hasMoved){
+    this->hasMoved = hasMoved;
+}
+
+
 PieceColor Piece::getColor(){ 
     return color; 
 }
@@ -34,20 +41,46 @@ void Piece::setColor(PieceColor color){
 }
 
 
-// Determine if a target square is being attacked by opposition piece.
-// Do this by scanning the entire board, 
-// and checking if any opposition piece can legally move to the given square.
-bool isAttacked(Square target, const std::array<std::array<Piece*, 8>, 8>& board, PieceColor friendlyColor){
-    for (int i = 0; i < 8; i++){
-        for (int j = 0; j < 8; j++){
-            // If square contains enemy piece
-            if ( board[i][j] != nullptr && board[i][j]->getColor() != friendlyColor ){
-                Square sqAtIJ = square(i,j); 
-                if (board[i][j]->isLegalMove(sqAtIJ, target, board)){
-                    return true;
-                } 
+bool Piece::attacks(SquareIndex start, SquareIndex target, const std::array<std::array<Piece*, 8>, 8>& board){
+    return isLegalMove(start, target, board);
+}
+
+
+// Rather than asking every opposition piece whether it attacks the target, works outwards from the target:
+// - Sliders can only attack it from the first piece along each line from it: a rook or queen on a straight line,
+//   or a bishop or queen on a diagonal
+// - Knights, kings and pawns can only attack it from the squares given by the attack tables (a pawn attacks the target
+//   from the squares a friendly pawn on the target would attack)
+bool isAttacked(SquareIndex target, const std::array<std::array<Piece*, 8>, 8>& board, PieceColor friendlyColor){
+    CHESS_TIME(IS_ATTACKED);
+    CHESS_COUNT(IS_ATTACKED);
+
+    // Whether there is an opposition piece of the given kind (lowercase letter) on any of the squares in mask
+    auto enemyOn = [&](uint64_t mask, char kind){
+        for (; mask != 0; mask &= mask - 1){
+            int sq = __builtin_ctzll(mask);
+            Piece* piece = board[rankOf(sq)][fileOf(sq)];
+            if (piece != nullptr && piece->getColor() != friendlyColor && (piece->toChar() | 0x20) == kind){
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (int d = 0; d < 8; d++){
+        int dRow = KING_STEPS[d][0], dCol = KING_STEPS[d][1];
+        bool straight = dRow == 0 || dCol == 0;
+        for (int r = rankOf(target) + dRow, c = fileOf(target) + dCol; r >= 0 && r < 8 && c >= 0 && c < 8; r += dRow, c += dCol){
+            Piece* piece = board[r][c];
+            if (piece == nullptr){
+                continue;
+            }
+            char kind = piece->toChar() | 0x20; // Lowercase
+            if (piece->getColor() != friendlyColor && (kind == 'q' || kind == (straight ? 'r' : 'b'))){
+                return true;
             }
+            break;
         }
     }
-    return false; // If no enemy piece is found to be attacking the square
-}
\ No newline at end of file
+    return enemyOn(KNIGHT_ATTACKS[target], 'n') || enemyOn(pawnAttacksFrom(friendlyColor, target), 'p') || enemyOn(KING_ATTACKS[target], 'k');
+}
@@ -26,6 +26,9 @@ class Piece{
         // Each piece will have an overloaded default constructor
         Piece();
 
+        // Virtual, so that deleting a piece through a Piece* (e.g. when it is captured) destroys it properly
+        virtual ~Piece(){}
+
         // Returns piece's color
         PieceColor getColor();
         
@@ -36,6 +39,10 @@ class Piece{
         // Returns value of hasMovedFromOrigin.
         bool getHasMoved();
 
+        // Sets hasMoved to the given value
+        // Used when a move is taken back, or when setting up a position in which the piece may or may not have moved.
+        void setHasMoved(bool hasMoved);
+
         // Sets piece's color to provided PieceColor
         void setColor(PieceColor color);
 
@@ -58,11 +65,16 @@ class Piece{
         // - A dest square being provided that contains a friendly piece
         // - The move resulting in the player whose turn it is being in check
         // These are to be dealt with by the Game::isValidMove() method, which performs the relevant checks before calling this method.
-        virtual bool isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board) = 0;
+        virtual bool isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board) = 0;
 
         // Given a starting square (at which the piece is located), returns a vector of destination squares to which the piece can legally move
         // Also takes the board as a param.
-        virtual std::vector<Square> legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board) = 0;
+        virtual std::vector<SquareIndex> legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board) = 0;
+
+        // Given a starting square (at which the piece is located), determine if the piece attacks the target square
+        // i.e. would be able to capture an opposition piece on it. Also takes the board as a param.
+        // For most pieces this is the same as isLegalMove(), but a pawn only attacks diagonally, whether or not the target square is occupied.
+        virtual bool attacks(SquareIndex start, SquareIndex target, const std::array<std::array<Piece*, 8>, 8>& board);
 
     protected:
 
@@ -80,5 +92,9 @@ class Piece{
 // - target square
 // - game board array
 // - color of friendly (i.e. non-opposition) pieces
-bool isAttacked(Square target, const std::array<std::array<Piece*, 8>, 8>& board, PieceColor friendlyColor);
+bool isAttacked(SquareIndex target, const std::array<std::array<Piece*, 8>, 8>& board, PieceColor friendlyColor);
+
+inline bool isAttacked(const Square& target, const std::array<std::array<Piece*, 8>, 8>& board, PieceColor friendlyColor){
+    return isAttacked(squareIndex(target), board, friendlyColor);
+}
 
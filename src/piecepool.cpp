@@ -0,0 +1,67 @@
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cctype>
+
+#include "piecepool.hpp"
+#include "piece.hpp"
+#include "pawn.hpp"
+#include "knight.hpp"
+#include "bishop.hpp"
+#include "rook.hpp"
+#include "queen.hpp"
+#include "king.hpp"
+
+
+// Index of a piece's kind in the spare lists, from its FEN letter
+static int kindIndex(char letter){
+    switch (tolower(letter)){
+        case 'p': return 0;
+        case 'n': return 1;
+        case 'b': return 2;
+        case 'r': return 3;
+        case 'q': return 4;
+        default: return 5;
+    }
+}
+
+
+Piece* PiecePool::acquire(char letter){
+    std::vector<Piece*>& spares = spare[kindIndex(letter)];
+    Piece* piece;
+    if (!spares.empty()){
+        piece = spares.back();
+        spares.pop_back();
+    } else {
+        switch (kindIndex(letter)){
+            case 0: piece = new Pawn; break;
+            case 1: piece = new Knight; break;
+            case 2: piece = new Bishop; break;
+            case 3: piece = new Rook; break;
+            case 4: piece = new Queen; break;
+            default: piece = new King; break;
+        }
+        owned.emplace_back(piece);
+    }
+
+    piece->setColor(isupper(letter) ? PieceColor::WHITE : PieceColor::BLACK);
+    piece->setHasMoved(false);
+    if (kindIndex(letter) == 0){
+        Pawn* pawn = static_cast<Pawn*>(piece);
+        if (pawn->canBeCapturedEP()){
+            pawn->toggleEP();
+        }
+    }
+    return piece;
+}
+
+
+void PiecePool::release(Piece* piece){
+    spare[kindIndex(piece->toChar())].push_back(piece);
+}
+
+
+size_t PiecePool::getAllocated(){
+    return owned.size();
+}
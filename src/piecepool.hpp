@@ -0,0 +1,41 @@
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "piece.hpp"
+
+#pragma once
+
+
+// Owns every piece of a game: those on the board, those captured or promoted (kept to take moves back), and spare
+// pieces for reuse. Pieces are handed out by acquire() and handed back by release() rather than being created and
+// deleted, so a game that keeps being set up again (e.g. with Game::restore()) stops allocating once it has enough
+// of each kind. All the pieces are freed with the pool.
+class PiecePool{
+
+    public:
+
+        PiecePool() = default;
+        PiecePool(const PiecePool&) = delete;
+        PiecePool& operator=(const PiecePool&) = delete;
+
+        // Returns a piece of the kind and color given by its FEN letter (uppercase for white, lowercase for black),
+        // that hasn't moved and (for a pawn) can't be captured en passant
+        Piece* acquire(char letter);
+
+        // Returns a piece to the pool, to be handed out again by acquire().
+        // The piece must have come from this pool, and must no longer be used by the caller.
+        void release(Piece* piece);
+
+        // Returns the number of pieces the pool has created (in use or spare)
+        size_t getAllocated();
+
+    private:
+
+        // Every piece created, which the pool frees when it is destroyed
+        std::vector<std::unique_ptr<Piece>> owned;
+
+        // Released pieces, indexed by kind in the order pawn, knight, bishop, rook, queen, king
+        std::array<std::vector<Piece*>, 6> spare;
+};
@@ -5,9 +5,9 @@
 
 Player::Player(PieceColor color) : color(color) {
         if (color == PieceColor::WHITE){
-            this->kingSq = square(0, 4);
+            this->kingSq = squareIndex(0, 4);
         } else if (color == PieceColor::BLACK){
-            this->kingSq = square(7, 4);
+            this->kingSq = squareIndex(7, 4);
         }
 }
 
@@ -27,10 +27,12 @@ std::string Player::getOppColorStr(){
 }
 
 
-Square Player::getKingSq(){ return kingSq; }
+Square Player::getKingSq(){ return toSquare(kingSq); }
+SquareIndex Player::getKingIndex(){ return kingSq; }
 
 
-void Player::setKingSq(const Square& newSquare){ kingSq = newSquare; }
-void Player::setKingSq(int row, int col){ kingSq = square(row, col); }
+void Player::setKingSq(const Square& newSquare){ kingSq = squareIndex(newSquare); }
+void Player::setKingSq(int row, int col){ kingSq = squareIndex(row, col); }
+void Player::setKingSq(SquareIndex newSquare){ kingSq = newSquare; }
 
 
@@ -21,12 +21,14 @@ class Player{
         // Get the piece color of the opposition player, in the form of an all-caps string (for output purposes)
         std::string getOppColorStr();
 
-        // Returns kingSq
+        // Returns kingSq, as a Square or as the index it is stored as
         Square getKingSq();
+        SquareIndex getKingIndex();
 
-        // Can setKingSq either by passing a complete square object, or a row and col for the square
+        // Can setKingSq either by passing a complete square object, a row and col for the square, or its index
         void setKingSq(const Square& newSquare);
         void setKingSq(int row, int col);
+        void setKingSq(SquareIndex newSquare);
 
     private:
 
@@ -35,5 +37,5 @@ class Player{
 
         // The square the player's king is on, stored here for speedy access
         // Will be updated by game::movePiece() as the king moves
-        Square kingSq;
+        SquareIndex kingSq;
 };
\ No newline at end of file
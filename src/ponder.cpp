@@ -0,0 +1,69 @@
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "ponder.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+#include "movepick.hpp"
+#include "search.hpp"
+
+
+Ponderer::Ponderer(Searcher& searcher) : searcher(searcher), stopFlag(false) {
+    ponderHash = 0;
+}
+
+
+Ponderer::~Ponderer(){
+    if (thread.joinable()){
+        stopFlag = true;
+        thread.join();
+    }
+}
+
+
+void Ponderer::start(Game& game, const Move& expectedMove){
+    if (thread.joinable() || isNoMove(expectedMove)){
+        return;
+    }
+    std::vector<Move> moves = game.legalMoves();
+    if (std::find(moves.begin(), moves.end(), expectedMove) == moves.end()){
+        return;
+    }
+
+    white.reset(new Player(PieceColor::WHITE));
+    black.reset(new Player(PieceColor::BLACK));
+    ponderGame.reset(new Game(white.get(), black.get(), game.snapshot()));
+    ponderGame->makeMove(expectedMove);
+    if (ponderGame->legalMoves().empty()){
+        ponderGame.reset();
+        return;
+    }
+    ponderHash = ponderGame->getHash();
+
+    stopFlag = false;
+    thread = std::thread([this](){
+        SearchLimits limits;
+        limits.stop = &stopFlag;
+        searcher.search(*ponderGame, limits);
+    });
+}
+
+
+bool Ponderer::stop(Game& game){
+    if (!thread.joinable()){
+        return false;
+    }
+    stopFlag = true;
+    thread.join();
+    ponderGame.reset();
+    return game.getHash() == ponderHash;
+}
+
+
+bool Ponderer::isPondering(){
+    return thread.joinable();
+}
@@ -0,0 +1,53 @@
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <cstdint>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+#include "search.hpp"
+
+#pragma once
+
+
+// Thinks on the opposition's time: while they decide on their move, searches the position after the move they are
+// expected to play, on a background thread. If they do play it, the searcher's transposition table already holds
+// the results, so the search for the reply gets deep quickly.
+//
+// The searcher must not be used by anything else between start() and stop().
+class Ponderer{
+
+    public:
+
+        Ponderer(Searcher& searcher);
+
+        // Stops pondering, if it is still going
+        ~Ponderer();
+
+        // Starts pondering on the position after expectedMove is played in the game's current position.
+        // Does nothing if the move is noMove() or isn't legal, or if the position after it has no legal moves.
+        // The position is set up from a snapshot of the game, so it is unaffected by changes to the game while pondering.
+        void start(Game& game, const Move& expectedMove);
+
+        // Stops pondering and waits for the background search to finish. Returns true if the game is now in
+        // the position that was pondered on (a ponder hit), and false if not or if it wasn't pondering.
+        bool stop(Game& game);
+
+        bool isPondering();
+
+    private:
+
+        Searcher& searcher;
+
+        std::thread thread;
+
+        std::atomic<bool> stopFlag;
+
+        // The position pondered on, and the players it points to
+        std::unique_ptr<Player> white;
+        std::unique_ptr<Player> black;
+        std::unique_ptr<Game> ponderGame;
+
+        uint64_t ponderHash;
+};
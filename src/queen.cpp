@@ -7,6 +7,7 @@
 #include "queen.hpp"
 #include "bishop.hpp"
 #include "rook.hpp"
+#include "instrument.hpp"
 
 
 Queen::Queen(PieceColor color) : Piece(color){} 
@@ -18,7 +19,7 @@ Queen::Queen() : Piece(){}
 char Queen::toChar(){ return (color==PieceColor::WHITE) ? 'Q' : 'q'; }
 
 
-bool Queen::isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
+bool Queen::isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board){
     // QUEEN MOVE CONDITIONS: 
     // - Can move by any number of columns on the same row (horizontally).
     // - Can move by any number of rows on the same column (vertically).
@@ -35,24 +36,27 @@ bool Queen::isLegalMove(const Square& start, const Square& dest, const std::arra
 // This combines the bishop's and rook's implementations of legalDests(), 
 // to get the legal diagonal and straight (horizontal & vertical) destinations respectively.
 // These 2 lists of destinations are then combined and returned to give the complete list of legal destinations for the queen.
-std::vector<Square> Queen::legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board){
+std::vector<SquareIndex> Queen::legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board){
+    CHESS_TIME(LEGAL_DESTS);
+    CHESS_COUNT(LEGAL_DESTS_QUEEN);
+    CHESS_COUNT(VECTORS_ALLOCATED);
 
     std::array<std::array<Piece*, 8>, 8> boardCopy = board; // Make modifiable copy of board
 
     // Replace queen with a rook at the start square on the board copy, then get it's legal destinations.
     // This will get the legal horizontal and vertical destinations for the queen on the original board.
     Rook rook(color);
-    boardCopy[start.row][start.col] = &rook;
-    std::vector<Square> straightDests = rook.legalDests(start, boardCopy);
+    boardCopy[rankOf(start)][fileOf(start)] = &rook;
+    std::vector<SquareIndex> straightDests = rook.legalDests(start, boardCopy);
 
     // Put a bishop at the start square on the board copy, then get it's legal destinations.
     // This will get the legal diagonal destinations for the queen on the original board.
     Bishop bish(color);
-    boardCopy[start.row][start.col] = &bish;
-    std::vector<Square> diagDests = bish.legalDests(start, boardCopy);
+    boardCopy[rankOf(start)][fileOf(start)] = &bish;
+    std::vector<SquareIndex> diagDests = bish.legalDests(start, boardCopy);
 
     // Concatenate straight & diagonal dests into 1 vector to get all possible legal destinations
-    std::vector<Square> res;
+    std::vector<SquareIndex> res;
     res.insert(res.end(), straightDests.begin(), straightDests.end());
     res.insert(res.end(), diagDests.begin(), diagDests.end());
 
@@ -60,18 +64,18 @@ std::vector<Square> Queen::legalDests(const Square& start, const std::array<std:
 }
 
 
-bool Queen::isPathClear(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
+bool Queen::isPathClear(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board){
 
     std::array<int, 2> disp = displacement(start, dest);
 
     // Horizontal move
     if (disp[0] == 0){
         // Whether to increment or decrement j to scan from start to dest
-        bool incJ = start.col < dest.col;
-        int j = (incJ) ? start.col+1 : start.col-1;
+        bool incJ = fileOf(start) < fileOf(dest);
+        int j = (incJ) ? fileOf(start)+1 : fileOf(start)-1;
 
-        while(j != dest.col){
-            if (board[start.row][j] != nullptr){  // If piece encountered
+        while(j != fileOf(dest)){
+            if (board[rankOf(start)][j] != nullptr){  // If piece encountered
                 return false; 
             }
             if (incJ) { j++; } else { j--; }; // Bring j 1 square closer to dest
@@ -82,11 +86,11 @@ bool Queen::isPathClear(const Square& start, const Square& dest, const std::arra
     // Vertical move
     else if (disp[1] == 0){
         // Whether to increment or decrement i to scan from start to dest
-        bool incI = start.row < dest.row;
-        int i = (incI) ? start.row+1 : start.row-1;
+        bool incI = rankOf(start) < rankOf(dest);
+        int i = (incI) ? rankOf(start)+1 : rankOf(start)-1;
 
-        while(i != dest.row){
-            if (board[i][start.col] != nullptr){  // If piece encountered
+        while(i != rankOf(dest)){
+            if (board[i][fileOf(start)] != nullptr){  // If piece encountered
                 return false; 
             }
             if (incI) { i++; } else { i--; }; // Bring i 1 square closer to dest
@@ -96,14 +100,14 @@ bool Queen::isPathClear(const Square& start, const Square& dest, const std::arra
 
     // Diagonal move
     else if (abs(disp[0]) == abs(disp[1])){ // Move is diagonal if absolute value of row (vertical) displacement = absolute value of column (horizontal) displacement
-        bool incI = start.row < dest.row; // Whether to increment or decrement i to scan from start to dest
-        bool incJ = start.col < dest.col; // Whether to increment or decrement j to scan from start to dest
+        bool incI = rankOf(start) < rankOf(dest); // Whether to increment or decrement i to scan from start to dest
+        bool incJ = fileOf(start) < fileOf(dest); // Whether to increment or decrement j to scan from start to dest
 
-        int i = (incI) ? start.row+1 : start.row-1;
-        int j = (incJ) ? start.col+1 : start.col-1;
+        int i = (incI) ? rankOf(start)+1 : rankOf(start)-1;
+        int j = (incJ) ? fileOf(start)+1 : fileOf(start)-1;
 
         // Scan path from start to dest
-        while(i != dest.row && j != dest.col){
+        while(i != rankOf(dest) && j != fileOf(dest)){
             if ( board[i][j] != nullptr ){ // If piece encountered
                 return false;
             }
@@ -114,4 +118,5 @@ bool Queen::isPathClear(const Square& start, const Square& dest, const std::arra
         }
         return true; // Return true if no pieces encountered in the way
     }
+    return false;
 }
@@ -0,0 +1,123 @@
+#include <string>
+#include <array>
+#include <ostream>
+
+#include "render.hpp"
+#include "game.hpp"
+#include "io.hpp"
+#include "piece.hpp"
+
+
+static const char RESET[] = "\033[0m";
+static const char LIGHT_SQUARE[] = "\033[48;5;231m";
+static const char FILE_COLOR[] = "\033[38;5;2m";
+static const char RANK_COLOR[] = "\033[38;5;1m";
+
+// Room for a whole frame: 64 squares of at most 20 bytes, plus the file letters and rank numbers
+static const size_t FRAME_CAPACITY = 2048;
+
+// In DIFF mode, the board is drawn from the top line of the screen: the file letters, then the ranks
+static const int FIRST_RANK_LINE = 2;
+static const int LINE_BELOW_BOARD = FIRST_RANK_LINE + 8;
+
+
+BoardRenderer::BoardRenderer(Mode mode) : mode(mode) {
+    buffer.reserve(FRAME_CAPACITY);
+    squares.fill(' ');
+    shown.fill(' ');
+    drawn = false;
+}
+
+
+void BoardRenderer::invalidate(){
+    drawn = false;
+}
+
+
+// Squares are 5 chars wide, with the piece letter in the middle. a1 is a dark square, so a square is light
+// if its row and column add up to an odd number.
+void BoardRenderer::appendSquare(int row, int col, char pieceChar){
+    buffer += ((row + col) % 2 == 1) ? LIGHT_SQUARE : RESET;
+    buffer += "  ";
+    buffer += pieceChar;
+    buffer += "  ";
+}
+
+
+void BoardRenderer::appendBoard(){
+    buffer += FILE_COLOR;
+    buffer += "  a    b    c    d    e    f    g    h  \n";
+    buffer += RESET;
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            appendSquare(i, j, squares[i*8 + j]);
+        }
+        buffer += RESET;
+        buffer += RANK_COLOR;
+        buffer += "  ";
+        buffer += (char)('1' + i);
+        buffer += RESET;
+        buffer += '\n';
+    }
+}
+
+
+void BoardRenderer::appendCursor(int line, int col){
+    buffer += "\033[";
+    buffer += std::to_string(line);
+    buffer += ';';
+    buffer += std::to_string(col);
+    buffer += 'H';
+}
+
+
+const std::string& BoardRenderer::frame(Game& game){
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    for (int i = 0; i < 8; i++){
+        for (int j = 0; j < 8; j++){
+            squares[i*8 + j] = (board[i][j] == nullptr) ? ' ' : board[i][j]->toChar();
+        }
+    }
+
+    buffer.clear();
+    if (mode == Mode::FULL){
+        buffer += '\n';
+        appendBoard();
+        return buffer;
+    }
+
+    if (!drawn){
+        buffer += "\033[H\033[2J"; // Cursor to the top left, and clear the screen
+        appendBoard();
+        drawn = true;
+    } else {
+        for (int sq = 0; sq < 64; sq++){
+            if (squares[sq] != shown[sq]){
+                appendCursor(FIRST_RANK_LINE + sq / 8, 1 + 5 * (sq % 8));
+                appendSquare(sq / 8, sq % 8, squares[sq]);
+            }
+        }
+        if (!buffer.empty()){
+            buffer += RESET;
+            appendCursor(LINE_BELOW_BOARD, 1);
+            buffer += "\033[J"; // Clear the rest of the screen
+        }
+    }
+    shown = squares;
+    return buffer;
+}
+
+
+void BoardRenderer::render(Game& game, std::ostream& out){
+    const std::string& text = frame(game);
+    out.write(text.data(), text.size());
+    out.flush();
+}
+
+
+void BoardRenderer::render(Game& game, GameIO& io){
+    const std::string& text = frame(game);
+    if (!text.empty()){
+        io.write(text);
+    }
+}
@@ -0,0 +1,64 @@
+#include <string>
+#include <array>
+#include <ostream>
+
+#include "game.hpp"
+#include "io.hpp"
+
+#pragma once
+
+
+// Draws the board for a terminal, with ANSI escape codes: file letters above, rank numbers to the right,
+// and light squares painted with a white background.
+//
+// Each frame is built in a buffer kept by the renderer (so after the first frame nothing is allocated), then handed to
+// the sink in a single write. In DIFF mode, the first frame clears the screen and draws the whole board at the top, and
+// each later frame only redraws the squares that changed since the last one, moving the cursor to each with an escape
+// code, which makes a frame after a move a few dozen bytes rather than over a kilobyte. A DIFF frame leaves the cursor
+// under the board with the rest of the screen cleared, so text written after it doesn't pile up below the board.
+class BoardRenderer{
+
+    public:
+
+        enum class Mode{
+            FULL, // Every frame is the whole board, written at the cursor
+            DIFF  // Frames redraw the changed squares of a board drawn at the top of the screen
+        };
+
+        BoardRenderer(Mode mode = Mode::FULL);
+
+        // Builds the frame showing the game's board, and returns it. It stays valid until the next call.
+        // In DIFF mode, the frame is empty if nothing has changed.
+        const std::string& frame(Game& game);
+
+        // Builds the frame and writes it to a stream, then flushes the stream
+        void render(Game& game, std::ostream& out);
+
+        // Builds the frame and writes it through a game's IO, if it isn't empty
+        void render(Game& game, GameIO& io);
+
+        // In DIFF mode, makes the next frame redraw the whole board, e.g. after something else has written to the screen
+        void invalidate();
+
+    private:
+
+        // Appends the escape code for a square's background, then the square (5 chars wide)
+        void appendSquare(int row, int col, char pieceChar);
+
+        // Appends the whole board
+        void appendBoard();
+
+        // Appends the escape code moving the cursor to a line and column, counting from 1
+        void appendCursor(int line, int col);
+
+        Mode mode;
+
+        std::string buffer;
+
+        // Piece chars (' ' for empty) of the board being drawn, and of the board drawn by the last DIFF frame
+        std::array<char, 64> squares;
+        std::array<char, 64> shown;
+
+        // False until a DIFF frame has drawn the whole board, and after invalidate()
+        bool drawn;
+};
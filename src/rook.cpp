@@ -5,6 +5,7 @@
 
 #include "piece.hpp"
 #include "rook.hpp"
+#include "instrument.hpp"
 
 
 Rook::Rook(PieceColor color) : Piece(color){}
@@ -15,7 +16,7 @@ Rook::Rook() : Piece(){}
 char Rook::toChar(){ return (color==PieceColor::WHITE) ? 'R' : 'r'; }
 
 
-bool Rook::isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
+bool Rook::isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board){
     std::array<int, 2> disp = displacement(start, dest);
     // ROOK MOVE CONDITIONS: Can move by any number of columns on the same row (horizontally), 
     // or by any number of rows on the same column (vertically), 
@@ -23,6 +24,7 @@ bool Rook::isLegalMove(const Square& start, const Square& dest, const std::array
     if (disp[0] == 0 || disp[1] == 0){
         return isPathClear(start, dest, board);
     }
+    return false;
 }
 
 
@@ -51,10 +53,13 @@ bool Rook::isLegalMove(const Square& start, const Square& dest, const std::array
 //
 // 
 // Then we apply this same process, but along the horizontal axis (i.e. keep row constant, iterate over columns)
-std::vector<Square> Rook::legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board){
+std::vector<SquareIndex> Rook::legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board){
+    CHESS_TIME(LEGAL_DESTS);
+    CHESS_COUNT(LEGAL_DESTS_ROOK);
+    CHESS_COUNT_BY(VECTORS_ALLOCATED, 3);
 
     // VERTICAL AXIS
-    std::vector<Square> verticalDests; // Legal destination squares on vertical axis
+    std::vector<SquareIndex> verticalDests; // Legal destination squares on vertical axis
 
     // Scanning possible vertical moves (i.e. where start column = dest column)
     // Start from first row on the starting square's column, scan to last row on the same column.
@@ -62,37 +67,37 @@ std::vector<Square> Rook::legalDests(const Square& start, const std::array<std::
     while (i < 8){
 
         // If encounters non-empty square before reaching rook's position
-        if (board[i][start.col] != nullptr && i < start.row){
+        if (board[i][fileOf(start)] != nullptr && i < rankOf(start)){
             verticalDests.clear(); // Clear dests - Those squares are not valid dests if there is a piece between them and the start square
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
-            if (board[i][start.col]->getColor() != color){
-                    verticalDests.push_back( square(i, start.col) );
+            if (board[i][fileOf(start)]->getColor() != color){
+                    verticalDests.push_back( squareIndex(i, fileOf(start)) );
             }
         }
 
         // If encounters non-empty square after rook's position
-        else if (board[i][start.col] != nullptr && i > start.row){
+        else if (board[i][fileOf(start)] != nullptr && i > rankOf(start)){
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
-            if (board[i][start.col]->getColor() != color){
-                    verticalDests.push_back( square(i, start.col) );
+            if (board[i][fileOf(start)]->getColor() != color){
+                    verticalDests.push_back( squareIndex(i, fileOf(start)) );
             }
             break; // Stop scanning - found all possible destinations on this column
         }
         
         // Default case - If i is on an empty square
-        else if (board[i][start.col] == nullptr){
-            verticalDests.push_back( square(i, start.col) );
+        else if (board[i][fileOf(start)] == nullptr){
+            verticalDests.push_back( squareIndex(i, fileOf(start)) );
         }
         
         i++;
     }
 
     // HORIZONTAL AXIS
-    std::vector<Square> horizontalDests; // Legal destination squares on horizontal axis
+    std::vector<SquareIndex> horizontalDests; // Legal destination squares on horizontal axis
 
     // Scanning possible horizontal moves (i.e. where start row = dest row)
     // Use the same principles as above, except instead of vertical, scan horizontally.
@@ -101,55 +106,55 @@ std::vector<Square> Rook::legalDests(const Square& start, const std::array<std::
     while (j < 8){
 
         // If encounters non-empty square before reaching rook's position
-        if (board[start.row][j] != nullptr && j < start.col){
+        if (board[rankOf(start)][j] != nullptr && j < fileOf(start)){
             horizontalDests.clear(); // Clear dests - Those squares are not valid dests if there is a piece between them and the start square
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
-            if (board[start.row][j]->getColor() != color){
-                    horizontalDests.push_back( square(start.row, j) );
+            if (board[rankOf(start)][j]->getColor() != color){
+                    horizontalDests.push_back( squareIndex(rankOf(start), j) );
             }
         }
 
         // If encounters non-empty square after rook's position
-        else if (board[start.row][j] != nullptr && j > start.col){
+        else if (board[rankOf(start)][j] != nullptr && j > fileOf(start)){
 
             // If encountered piece is enemy, can capture that piece
             // So add its square to legal dests
-            if (board[start.row][j]->getColor() != color){
-                    horizontalDests.push_back( square(start.row, j) );
+            if (board[rankOf(start)][j]->getColor() != color){
+                    horizontalDests.push_back( squareIndex(rankOf(start), j) );
             }
             break; // Stop scanning - found all possible destinations on this row
         }
         
         // Default case - If j is on an empty square
-        else if (board[start.row][j] == nullptr){
-            horizontalDests.push_back( square(start.row, j) );
+        else if (board[rankOf(start)][j] == nullptr){
+            horizontalDests.push_back( squareIndex(rankOf(start), j) );
         }
         
         j++;
     }
 
     // Concatenate vertical and horizontal destinations into single dests vector, then return
-    std::vector<Square> dests;
+    std::vector<SquareIndex> dests;
     dests.insert(dests.end(), verticalDests.begin(), verticalDests.end());
     dests.insert(dests.end(), horizontalDests.begin(), horizontalDests.end());
     return dests;
 }
 
 
-bool Rook::isPathClear(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board){
+bool Rook::isPathClear(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board){
 
     std::array<int, 2> disp = displacement(start, dest);
 
     // Horizontal move
     if (disp[0] == 0){
         // Whether to increment or decrement j to scan from start to dest
-        bool incJ = start.col < dest.col;
-        int j = (incJ) ? start.col+1 : start.col-1;
+        bool incJ = fileOf(start) < fileOf(dest);
+        int j = (incJ) ? fileOf(start)+1 : fileOf(start)-1;
 
-        while(j != dest.col){
-            if (board[start.row][j] != nullptr){  // If piece encountered
+        while(j != fileOf(dest)){
+            if (board[rankOf(start)][j] != nullptr){  // If piece encountered
                 return false; 
             }
             if (incJ) { j++; } else { j--; }; // Bring j 1 square closer to dest
@@ -160,15 +165,16 @@ bool Rook::isPathClear(const Square& start, const Square& dest, const std::array
     // Vertical move
     else if (disp[1] == 0){
         // Whether to increment or decrement i to scan from start to dest
-        bool incI = start.row < dest.row;
-        int i = (incI) ? start.row+1 : start.row-1;
+        bool incI = rankOf(start) < rankOf(dest);
+        int i = (incI) ? rankOf(start)+1 : rankOf(start)-1;
 
-        while(i != dest.row){
-            if (board[i][start.col] != nullptr){  // If piece encountered
+        while(i != rankOf(dest)){
+            if (board[i][fileOf(start)] != nullptr){  // If piece encountered
                 return false; 
             }
             if (incI) { i++; } else { i--; }; // Bring i 1 square closer to dest
         }
         return true; // Return true if no pieces encountered in the way
     }
+    return false;
 }
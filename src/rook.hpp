@@ -17,14 +17,14 @@ class Rook : public Piece {
 
         char toChar() override;
 
-        bool isLegalMove(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        bool isLegalMove(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board) override;
 
-        std::vector<Square> legalDests(const Square& start, const std::array<std::array<Piece*, 8>, 8>& board) override;
+        std::vector<SquareIndex> legalDests(SquareIndex start, const std::array<std::array<Piece*, 8>, 8>& board) override;
     
     private:
 
         // Given a move, determines if the path along that move is clear i.e. there are no pieces in the way.
         // Since this is the rook class, THIS IMPLEMENTATION ASSUMES THAT THE MOVE PROVIDED IS EITHER COMPLETELY HORIZONTAL OR VERTICAL.
         // Used by isLegalMove(), which will determine if the move meets the above condition in advance of calling this.
-        bool isPathClear(const Square& start, const Square& dest, const std::array<std::array<Piece*, 8>, 8>& board);
+        bool isPathClear(SquareIndex start, SquareIndex dest, const std::array<std::array<Piece*, 8>, 8>& board);
 };
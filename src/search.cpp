@@ -0,0 +1,291 @@
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "search.hpp"
+#include "movepick.hpp"
+#include "eval.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+
+
+static const int INFINITE_SCORE = MATE_SCORE + 1;
+
+// Nodes between checks of the search limits (a power of 2)
+static const uint64_t LIMIT_CHECK_INTERVAL = 256;
+
+
+// Mate scores are stored in the transposition table relative to the position they are stored for,
+// rather than to the root, as the same position can be reached at different plies.
+static int scoreToTT(int score, int ply){
+    if (score > MATE_SCORE - MAX_PLY){ return score + ply; }
+    if (score < -(MATE_SCORE - MAX_PLY)){ return score - ply; }
+    return score;
+}
+
+
+static int scoreFromTT(int score, int ply){
+    if (score > MATE_SCORE - MAX_PLY){ return score - ply; }
+    if (score < -(MATE_SCORE - MAX_PLY)){ return score + ply; }
+    return score;
+}
+
+
+Searcher::Searcher(const SearchOptions& options) : options(options), pawnTable(options.pawnHashBits) {
+    tt.resize((size_t)1 << options.hashBits);
+    clear();
+}
+
+
+void Searcher::clear(){
+    TTEntry empty;
+    empty.key = 0;
+    empty.move = noMove();
+    empty.score = 0;
+    empty.depth = -1;
+    empty.bound = Bound::EXACT;
+    std::fill(tt.begin(), tt.end(), empty);
+    tables.clear();
+}
+
+
+PawnTable& Searcher::getPawnTable(){
+    return pawnTable;
+}
+
+
+Searcher::TTEntry& Searcher::ttEntry(uint64_t key){
+    return tt[key & (tt.size() - 1)];
+}
+
+
+SearchResult Searcher::search(Game& game, int depth){
+    SearchLimits depthOnly;
+    depthOnly.depth = depth;
+    return search(game, depthOnly);
+}
+
+
+// Each iteration's best move is stored in the transposition table, so the next, deeper iteration tries it first.
+// The principal variation is read back after each completed iteration, as an aborted one may leave partial results in the table.
+SearchResult Searcher::search(Game& game, const SearchLimits& searchLimits){
+    limits = searchLimits;
+    startTime = std::chrono::steady_clock::now();
+    aborted = false;
+    abortable = false;
+    nodes = 0;
+
+    SearchResult result;
+    result.bestMove = noMove();
+    result.score = 0;
+    result.depth = 0;
+
+    for (int d = 1; d <= std::max(limits.depth, 1); d++){
+        int score = alphaBeta(game, d, 0, -INFINITE_SCORE, INFINITE_SCORE, noMove());
+        if (aborted){
+            break;
+        }
+        result.score = score;
+        result.depth = d;
+        result.pv = principalVariation(game, d);
+        if (!result.pv.empty()){
+            result.bestMove = result.pv[0];
+        }
+        abortable = true;
+        if (limits.onIteration){
+            result.nodes = nodes;
+            limits.onIteration(result);
+        }
+
+        if (limits.softTimeMs > 0){
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+            if (elapsed.count() >= limits.softTimeMs){
+                break;
+            }
+        }
+        if (limitReached()){
+            break;
+        }
+    }
+
+    result.nodes = nodes;
+    return result;
+}
+
+
+bool Searcher::limitReached(){
+    if (limits.stop != nullptr && limits.stop->load(std::memory_order_relaxed)){
+        return true;
+    }
+    if (limits.nodes > 0 && nodes >= limits.nodes){
+        return true;
+    }
+    if (limits.timeMs > 0){
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+        if (elapsed.count() >= limits.timeMs){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+int Searcher::alphaBeta(Game& game, int depth, int ply, int alpha, int beta, const Move& prevMove){
+    if (depth <= 0 && options.quiescence){
+        return quiescence(game, ply, alpha, beta);
+    }
+    nodes++;
+    if (abortable && (nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0 && limitReached()){
+        aborted = true;
+    }
+    if (aborted){
+        return 0;
+    }
+
+    std::vector<Move> moves = game.legalMoves();
+    if (moves.empty()){
+        return game.isCheck() ? -(MATE_SCORE - ply) : 0; // Checkmate or stalemate
+    }
+    if (ply > 0 && game.getGameState() != GameState::CONTESTED){ // Drawn by rule. Answered from the legal moves just generated.
+        return 0;
+    }
+    if (depth <= 0 || ply >= MAX_PLY - 1){
+        return evaluate(game, &pawnTable);
+    }
+
+    // The transposition table gives the best move found for the position before, and may give a score good enough to use.
+    // Scores aren't taken at the root, where the move has to be found.
+    TTEntry& entry = ttEntry(game.getHash());
+    Move hashMove = noMove();
+    if (entry.key == game.getHash()){
+        hashMove = entry.move;
+        int score = scoreFromTT(entry.score, ply);
+        if (ply > 0 && entry.depth >= depth){
+            if (entry.bound == Bound::EXACT){ return score; }
+            if (entry.bound == Bound::LOWER && score >= beta){ return score; }
+            if (entry.bound == Bound::UPPER && score <= alpha){ return score; }
+        }
+    }
+
+    if (ply == 0 && !limits.excludedMoves.empty()){
+        const std::vector<Move>& excluded = limits.excludedMoves;
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [&](const Move& m){
+            return std::find(excluded.begin(), excluded.end(), m) != excluded.end();
+        }), moves.end());
+        if (std::find(excluded.begin(), excluded.end(), hashMove) != excluded.end()){
+            hashMove = noMove();
+        }
+    }
+
+    int originalAlpha = alpha;
+    int best = -INFINITE_SCORE;
+    Move bestMove = noMove();
+    PieceColor color = game.getTurn()->getColor();
+
+    MovePicker picker(game, moves, hashMove, &tables, ply, prevMove, options.ordering);
+    Move m;
+    while (picker.next(m)){
+        bool quiet = !isCaptureOrPromotion(game, m);
+
+        game.makeMove(m);
+        int score = -alphaBeta(game, depth - 1, ply + 1, -beta, -alpha, m);
+        game.unmakeMove();
+        if (aborted){
+            return 0; // Nothing is stored in the transposition table from an unfinished search
+        }
+
+        if (score > best){
+            best = score;
+            bestMove = m;
+        }
+        if (score > alpha){
+            alpha = score;
+        }
+        if (alpha >= beta){
+            // Quiet moves that cause cutoffs are remembered, to be tried early in similar positions
+            if (quiet){
+                tables.update(m, color, depth, ply, prevMove);
+            }
+            break;
+        }
+    }
+
+    TTEntry& slot = ttEntry(game.getHash()); // Looked up again, as the search below may have replaced the entry
+    slot.key = game.getHash();
+    slot.move = bestMove;
+    slot.score = scoreToTT(best, ply);
+    slot.depth = depth;
+    slot.bound = (best >= beta) ? Bound::LOWER : ((best > originalAlpha) ? Bound::EXACT : Bound::UPPER);
+    return best;
+}
+
+
+// Only captures (and promotions) are searched, unless in check, when every move is, as there is no option of standing pat.
+// Otherwise the player can stand pat, i.e. take the static evaluation rather than capture, and losing captures are skipped.
+int Searcher::quiescence(Game& game, int ply, int alpha, int beta){
+    nodes++;
+    if (abortable && (nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0 && limitReached()){
+        aborted = true;
+    }
+    if (aborted){
+        return 0;
+    }
+
+    std::vector<Move> moves = game.legalMoves();
+    if (moves.empty()){
+        return game.isCheck() ? -(MATE_SCORE - ply) : 0;
+    }
+    if (ply >= MAX_PLY - 1){
+        return evaluate(game, &pawnTable);
+    }
+
+    bool inCheck = game.isCheck();
+    int best = -INFINITE_SCORE;
+    if (!inCheck){
+        best = evaluate(game, &pawnTable);
+        if (best >= beta){
+            return best;
+        }
+        alpha = std::max(alpha, best);
+    }
+
+    MovePicker picker(game, moves, noMove(), nullptr, ply, noMove(), options.ordering, !inCheck);
+    Move m;
+    while (picker.next(m)){
+        game.makeMove(m);
+        int score = -quiescence(game, ply + 1, -beta, -alpha);
+        game.unmakeMove();
+        if (aborted){
+            return 0;
+        }
+
+        best = std::max(best, score);
+        alpha = std::max(alpha, score);
+        if (alpha >= beta){
+            break;
+        }
+    }
+    return best;
+}
+
+
+std::vector<Move> Searcher::principalVariation(Game& game, int maxLength){
+    std::vector<Move> pv;
+    while ((int)pv.size() < maxLength){
+        TTEntry& entry = ttEntry(game.getHash());
+        if (entry.key != game.getHash()){
+            break;
+        }
+        std::vector<Move> moves = game.legalMoves();
+        if (std::find(moves.begin(), moves.end(), entry.move) == moves.end()){
+            break;
+        }
+        pv.push_back(entry.move);
+        game.makeMove(entry.move);
+    }
+    for (size_t i = 0; i < pv.size(); i++){
+        game.unmakeMove();
+    }
+    return pv;
+}
@@ -0,0 +1,137 @@
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "game.hpp"
+#include "move.hpp"
+#include "movepick.hpp"
+#include "pawns.hpp"
+
+#pragma once
+
+
+// Score of being checkmated at the root. Being mated in n plies scores -(MATE_SCORE - n), so any score
+// further from 0 than MATE_SCORE - MAX_PLY is a forced mate.
+const int MATE_SCORE = 100000;
+
+
+struct SearchOptions{
+    OrderingOptions ordering;
+
+    // Search captures at the leaves until the position is quiet
+    bool quiescence = true;
+
+    // Size of the transposition table, as a power of 2 entries
+    int hashBits = 16;
+
+    // Size of the pawn structure table, as a power of 2 entries
+    int pawnHashBits = 12;
+};
+
+
+struct SearchResult;
+
+
+// When to stop searching. Iterative deepening always completes depth 1, so there is a move to play;
+// after that, an iteration cut short by a limit is thrown away and the previous iteration's result is returned.
+struct SearchLimits{
+    int depth = MAX_PLY - 1;
+
+    // Wall-clock time limit in milliseconds, or 0 for none
+    int64_t timeMs = 0;
+
+    // No new iteration is started once this many milliseconds have passed (0 for no such limit).
+    // An iteration takes several times as long as the one before, so one started late would rarely finish before timeMs.
+    int64_t softTimeMs = 0;
+
+    // Node limit, or 0 for none
+    uint64_t nodes = 0;
+
+    // Set to true (e.g. by another thread) to stop the search
+    const std::atomic<bool>* stop = nullptr;
+
+    // Root moves not to search, e.g. the best moves already found when looking for the next best line (multi-PV).
+    // At least one legal move must be left.
+    std::vector<Move> excludedMoves;
+
+    // Called with the result so far after each completed iteration, e.g. to see when the best move was found
+    std::function<void(const SearchResult&)> onIteration;
+};
+
+
+struct SearchResult{
+    Move bestMove;
+    int score;             // In centipawns, from the point of view of the player whose turn it was
+    int depth;
+    uint64_t nodes;        // Positions searched, including in the quiescence search and in the earlier iterations
+    std::vector<Move> pv;  // Principal variation, starting with bestMove
+};
+
+
+// Alpha-beta (negamax) search with a transposition table and iterative deepening.
+// The transposition table and the move ordering tables are kept between searches, until clear() is called.
+class Searcher{
+
+    public:
+
+        Searcher(const SearchOptions& options = SearchOptions());
+
+        // Searches the current position to the given depth (in plies), and returns the best move for the player whose turn it is.
+        // The game is left in the position it was in. There must be at least one legal move.
+        SearchResult search(Game& game, int depth);
+
+        // Searches the current position until one of the limits is reached
+        SearchResult search(Game& game, const SearchLimits& limits);
+
+        // Forgets all previous searches
+        void clear();
+
+        // The table caching pawn structure evaluations, for its hit rate
+        PawnTable& getPawnTable();
+
+    private:
+
+        enum class Bound : uint8_t{ EXACT, LOWER, UPPER };
+
+        struct TTEntry{
+            uint64_t key;
+            Move move;
+            int score;
+            int8_t depth;
+            Bound bound;
+        };
+
+        int alphaBeta(Game& game, int depth, int ply, int alpha, int beta, const Move& prevMove);
+
+        int quiescence(Game& game, int ply, int alpha, int beta);
+
+        // Follows the hash moves from the current position to build the principal variation
+        std::vector<Move> principalVariation(Game& game, int maxLength);
+
+        TTEntry& ttEntry(uint64_t key);
+
+        // Whether a limit has been reached. Only checked every few hundred nodes, as reading the clock isn't free.
+        bool limitReached();
+
+        SearchOptions options;
+
+        std::vector<TTEntry> tt;
+
+        OrderingTables tables;
+
+        PawnTable pawnTable;
+
+        uint64_t nodes;
+
+        // Limits of the current search, and the time it started
+        SearchLimits limits;
+        std::chrono::steady_clock::time_point startTime;
+
+        // Set once a limit has been reached during an iteration, after which every node returns straight away
+        bool aborted;
+
+        // False during the first iteration, which is never cut short
+        bool abortable;
+};
@@ -0,0 +1,264 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+
+#include "selfplay.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+#include "pgn.hpp"
+#include "instrument.hpp"
+
+
+RandomChooser::RandomChooser(uint64_t seed) : seed(seed), rng(seed) {}
+
+
+std::unique_ptr<MoveChooser> RandomChooser::forGame(int gameIndex){
+    return std::unique_ptr<MoveChooser>(new RandomChooser(seed + gameIndex));
+}
+
+
+Move RandomChooser::chooseMove(Game& /*game*/, const std::vector<Move>& legalMoves){
+    std::uniform_int_distribution<size_t> dist(0, legalMoves.size() - 1);
+    return legalMoves[dist(rng)];
+}
+
+
+ScriptedChooser::ScriptedChooser(const std::vector<std::vector<Move>>& scripts, std::shared_ptr<MoveChooser> fallback)
+    : scripts(scripts), fallback(fallback) {
+    nextMove = 0;
+    offScript = false;
+}
+
+
+// The per-game chooser only keeps the game's own script, and its own fallback chooser for that game.
+std::unique_ptr<MoveChooser> ScriptedChooser::forGame(int gameIndex){
+    std::vector<std::vector<Move>> gameScript;
+    if (!scripts.empty()){
+        gameScript.push_back(scripts[gameIndex % scripts.size()]);
+    }
+    std::shared_ptr<MoveChooser> gameFallback(fallback->forGame(gameIndex));
+    return std::unique_ptr<MoveChooser>(new ScriptedChooser(gameScript, gameFallback));
+}
+
+
+Move ScriptedChooser::chooseMove(Game& game, const std::vector<Move>& legalMoves){
+    if (!offScript && !scripts.empty() && nextMove < scripts[0].size()){
+        Move scripted = scripts[0][nextMove];
+        if (std::find(legalMoves.begin(), legalMoves.end(), scripted) != legalMoves.end()){
+            nextMove++;
+            return scripted;
+        }
+    }
+    offScript = true;
+    return fallback->chooseMove(game, legalMoves);
+}
+
+
+CallbackChooser::CallbackChooser(Callback callback) : callback(callback) {}
+
+
+std::unique_ptr<MoveChooser> CallbackChooser::forGame(int /*gameIndex*/){
+    return std::unique_ptr<MoveChooser>(new CallbackChooser(callback));
+}
+
+
+Move CallbackChooser::chooseMove(Game& game, const std::vector<Move>& legalMoves){
+    return callback(game, legalMoves);
+}
+
+
+SelfPlayRunner::SelfPlayRunner(const SelfPlayConfig& config) : config(config) {
+    elapsedSeconds = 0;
+}
+
+
+// Games are handed out to the workers one at a time through a shared counter,
+// so a worker that gets short games simply plays more of them.
+bool SelfPlayRunner::run(){
+    records.assign(config.numGames, GameRecord());
+    std::atomic<int> nextGame(0);
+
+    auto worker = [&](){
+        while (true){
+            int i = nextGame++;
+            if (i >= config.numGames){
+                break;
+            }
+            records[i] = playGame(i);
+        }
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    int numThreads = std::max(1, config.numThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; t++){
+        workers.push_back(std::thread(worker));
+    }
+    for (auto& w: workers){
+        w.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    elapsedSeconds = elapsed.count();
+
+    bool ok = true;
+    if (!config.pgnPath.empty()){ ok = writePgnFile() && ok; }
+    if (!config.binPath.empty()){ ok = writeBinFile() && ok; }
+    return ok;
+}
+
+
+const std::vector<GameRecord>& SelfPlayRunner::getRecords(){
+    return records;
+}
+
+
+double SelfPlayRunner::getElapsedSeconds(){
+    return elapsedSeconds;
+}
+
+
+double SelfPlayRunner::getGamesPerHour(){
+    if (elapsedSeconds <= 0){ return 0; }
+    return records.size() * 3600.0 / elapsedSeconds;
+}
+
+
+Profile SelfPlayRunner::getProfile(){
+    Profile profile;
+    for (auto& record: records){
+        profile += record.profile;
+    }
+    return profile;
+}
+
+
+// A game ends when the player whose turn it is has no legal moves (checkmate or stalemate), when it is drawn by rule,
+// when a chooser returns an illegal move (which forfeits the game),
+// or when the ply limit is reached.
+//
+// Each game is played start to finish on one thread, so the thread's instrumentation profile is taken
+// at the start of the game (discarding anything done before it) and at the end, to give the game's profile.
+GameRecord SelfPlayRunner::playGame(int gameIndex){
+    takeProfile();
+
+    GameRecord record;
+    record.result = GameResult::UNFINISHED;
+    if (config.chess960){
+        std::mt19937 positionRng(gameIndex);
+        record.startPosition = positionRng() % 960;
+    }
+
+    Player white(PieceColor::WHITE);
+    Player black(PieceColor::BLACK);
+    std::unique_ptr<Game> gamePtr(config.chess960 ? new Game(&white, &black, record.startPosition) : new Game(&white, &black));
+    Game& game = *gamePtr;
+
+    std::unique_ptr<MoveChooser> whiteChooser = config.whiteChooser->forGame(gameIndex);
+    std::unique_ptr<MoveChooser> blackChooser;
+    if (config.blackChooser != config.whiteChooser){
+        blackChooser = config.blackChooser->forGame(gameIndex);
+    }
+
+    std::vector<Move> legal = game.legalMoves();
+    while (true){
+        bool whiteToMove = game.getTurn() == &white;
+
+        GameState state = game.getGameState();
+        if (state == GameState::CHECKMATE){
+            record.result = whiteToMove ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
+            break;
+        }
+        if (state != GameState::CONTESTED){ // Stalemate, or drawn by rule
+            record.result = GameResult::DRAW;
+            break;
+        }
+
+        if ((int)record.moves.size() >= config.maxPlies){
+            break;
+        }
+
+        MoveChooser* chooser = (whiteToMove || !blackChooser) ? whiteChooser.get() : blackChooser.get();
+        Move m = chooser->chooseMove(game, legal);
+        if (std::find(legal.begin(), legal.end(), m) == legal.end()){
+            record.result = whiteToMove ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
+            break;
+        }
+
+        std::string san = moveToSan(game, m, legal);
+        game.makeMove(m);
+        legal = game.legalMoves();
+        if (game.isCheck()){
+            san += legal.empty() ? "#" : "+";
+        }
+
+        record.moves.push_back(m);
+        record.sanMoves.push_back(san);
+    }
+
+    record.profile = takeProfile();
+    return record;
+}
+
+
+bool SelfPlayRunner::writePgnFile(){
+    std::ofstream out(config.pgnPath);
+    if (!out){
+        return false;
+    }
+
+    for (size_t i = 0; i < records.size(); i++){
+        std::vector<std::pair<std::string, std::string>> tags = {
+            {"Event", "Self-play"},
+            {"Site", "?"},
+            {"Date", "????.??.??"},
+            {"Round", std::to_string(i + 1)},
+            {"White", "White"},
+            {"Black", "Black"}
+        };
+        if (records[i].startPosition >= 0){
+            tags.push_back({"Variant", "Chess960"});
+            tags.push_back({"SetUp", "1"});
+            tags.push_back({"FEN", Game::chess960Fen(records[i].startPosition)});
+        }
+        writePgn(out, tags, records[i].sanMoves, records[i].result);
+    }
+    return (bool)out;
+}
+
+
+// Writes an integer of the given size in little-endian byte order
+static void writeLE(std::ofstream& out, uint32_t value, int numBytes){
+    for (int i = 0; i < numBytes; i++){
+        out.put((char)((value >> (8*i)) & 0xFF));
+    }
+}
+
+
+bool SelfPlayRunner::writeBinFile(){
+    std::ofstream out(config.binPath, std::ios::binary);
+    if (!out){
+        return false;
+    }
+
+    out.write(config.chess960 ? "CSP2" : "CSP1", 4);
+    writeLE(out, records.size(), 4);
+    for (auto& record: records){
+        writeLE(out, (uint32_t)record.result, 1);
+        if (config.chess960){
+            writeLE(out, record.startPosition, 2);
+        }
+        writeLE(out, record.moves.size(), 2);
+        for (auto& m: record.moves){
+            writeLE(out, packMove(m), 2);
+        }
+    }
+    return (bool)out;
+}
\ No newline at end of file
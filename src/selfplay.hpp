@@ -0,0 +1,178 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <random>
+#include <cstdint>
+
+#include "game.hpp"
+#include "move.hpp"
+#include "pgn.hpp"
+#include "instrument.hpp"
+
+#pragma once
+
+
+// Picks the move to play in a self-play game.
+// The runner gives each game its own choosers by calling forGame() on the choosers it was configured with,
+// so a chooser's state (e.g. a random number generator or a position in a script) is never shared between threads.
+class MoveChooser{
+
+    public:
+
+        virtual ~MoveChooser(){}
+
+        // Returns a new chooser to be used for the game with the given index
+        virtual std::unique_ptr<MoveChooser> forGame(int gameIndex) = 0;
+
+        // Returns one of legalMoves, which are the legal moves for the player whose turn it is in game.
+        // legalMoves is never empty.
+        virtual Move chooseMove(Game& game, const std::vector<Move>& legalMoves) = 0;
+};
+
+
+// Picks a move uniformly at random.
+// Each game's chooser is seeded with the base seed plus the game's index, so runs are reproducible.
+class RandomChooser : public MoveChooser{
+
+    public:
+
+        RandomChooser(uint64_t seed);
+
+        std::unique_ptr<MoveChooser> forGame(int gameIndex) override;
+
+        Move chooseMove(Game& game, const std::vector<Move>& legalMoves) override;
+
+    private:
+
+        uint64_t seed;
+
+        std::mt19937_64 rng;
+};
+
+
+// Plays a fixed sequence of moves (e.g. an opening line), then hands over to a fallback chooser
+// once the script runs out, or if the next scripted move is not legal.
+// Scripts are indexed by game: game i plays scripts[i % scripts.size()].
+// A script holds the moves of both players, so the same chooser should be used for white and black.
+class ScriptedChooser : public MoveChooser{
+
+    public:
+
+        ScriptedChooser(const std::vector<std::vector<Move>>& scripts, std::shared_ptr<MoveChooser> fallback);
+
+        std::unique_ptr<MoveChooser> forGame(int gameIndex) override;
+
+        Move chooseMove(Game& game, const std::vector<Move>& legalMoves) override;
+
+    private:
+
+        std::vector<std::vector<Move>> scripts;
+
+        // Chooser to use once the script has run out
+        std::shared_ptr<MoveChooser> fallback;
+
+        // Index of the next scripted move to play
+        size_t nextMove;
+
+        // Set to true once the game has left the script
+        bool offScript;
+};
+
+
+// Passes the choice on to a user-provided function, for in-process engines.
+// The same function is used for every game, so it must be safe to call from several threads at once.
+class CallbackChooser : public MoveChooser{
+
+    public:
+
+        typedef std::function<Move(Game&, const std::vector<Move>&)> Callback;
+
+        CallbackChooser(Callback callback);
+
+        std::unique_ptr<MoveChooser> forGame(int gameIndex) override;
+
+        Move chooseMove(Game& game, const std::vector<Move>& legalMoves) override;
+
+    private:
+
+        Callback callback;
+};
+
+
+// A game played by the runner
+struct GameRecord{
+    std::vector<Move> moves;
+    std::vector<std::string> sanMoves; // Moves in SAN, with check/checkmate suffixes
+    GameResult result;
+    int startPosition = -1; // Chess960 starting position number (see Game), or -1 for the standard starting position
+    Profile profile; // Instrumentation profile of the game, including its choosers (empty unless built with CHESS_INSTRUMENT)
+};
+
+
+// Settings for a self-play run
+struct SelfPlayConfig{
+    int numGames = 100;
+    int numThreads = 1;
+
+    // Games still going after this many plies (half-moves) are stopped and recorded as unfinished
+    int maxPlies = 400;
+
+    // If both players are given the same chooser, each game gets a single chooser that picks the moves of both players
+    std::shared_ptr<MoveChooser> whiteChooser;
+    std::shared_ptr<MoveChooser> blackChooser;
+
+    // Start each game from a Chess960 starting position, picked at random (the same one for the same game index on every run)
+    bool chess960 = false;
+
+    // If non-empty, finished games are written to these files
+    std::string pgnPath;
+    std::string binPath;
+};
+
+
+// Plays many games with no terminal input or output, each on its own Game instance,
+// spread over a pool of worker threads.
+class SelfPlayRunner{
+
+    public:
+
+        SelfPlayRunner(const SelfPlayConfig& config);
+
+        // Plays all the games, then writes the PGN and/or binary output files
+        // Returns false if an output file could not be written
+        bool run();
+
+        // Returns the games played, indexed by game number
+        const std::vector<GameRecord>& getRecords();
+
+        // Wall-clock duration of the last run (excluding writing output files), in seconds
+        double getElapsedSeconds();
+
+        // Throughput of the last run
+        double getGamesPerHour();
+
+        // Instrumentation profile of the whole batch of games, i.e. the sum of the games' profiles
+        Profile getProfile();
+
+    private:
+
+        // Plays the game with the given index from the starting position, and returns its record
+        GameRecord playGame(int gameIndex);
+
+        // Writes all records to config.pgnPath / config.binPath
+        bool writePgnFile();
+        bool writeBinFile();
+
+        SelfPlayConfig config;
+
+        std::vector<GameRecord> records;
+
+        double elapsedSeconds;
+};
+
+
+// Binary output format (all integers little-endian):
+//   "CSP1" magic, uint32 game count, then for each game:
+//   uint8 result (as GameResult), uint16 ply count, then a uint16 per move packed by packMove() (see move.hpp).
+// Chess960 runs write "CSP2" instead, with a uint16 starting position number after each game's result.
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+
+#include "selfplay.hpp"
+#include "move.hpp"
+#include "instrument.hpp"
+
+
+// Headless self-play: plays games between move choosers with no board printing or prompts,
+// and reports throughput once all games are done.
+//
+// Usage: chess_selfplay [options]
+//   --games N       number of games to play (default 100)
+//   --threads N     number of worker threads (default: number of hardware threads)
+//   --max-plies N   stop games after N plies (default 400)
+//   --seed N        base seed for the random chooser (default 1)
+//   --script FILE   play opening lines from FILE (one line per game, moves in coordinate notation
+//                   separated by spaces, e.g. "e2e4 e7e5 g1f3"), then continue randomly
+//   --pgn FILE      write games in PGN format to FILE
+//   --bin FILE      write games in binary format to FILE
+//   --chess960 on   start each game from a Chess960 starting position
+//   --profile MODE  print an instrumentation report for the whole batch (MODE "batch"), or for each game then the batch
+//                   (MODE "games"). Needs a build with -DCHESS_INSTRUMENT=ON.
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_selfplay [--games N] [--threads N] [--max-plies N] [--seed N] [--script FILE] [--pgn FILE] [--bin FILE] [--chess960 on|off] [--profile batch|games]" << std::endl;
+}
+
+
+// Reads opening lines from a script file. Exits if the file can't be read or contains an invalid move string.
+std::vector<std::vector<Move>> readScripts(const std::string& path){
+    std::ifstream in(path);
+    if (!in){
+        std::cerr << "ERROR: COULD NOT OPEN SCRIPT FILE " << path << std::endl;
+        exit(1);
+    }
+
+    std::vector<std::vector<Move>> scripts;
+    std::string line;
+    while (std::getline(in, line)){
+        std::istringstream moves(line);
+        std::vector<Move> script;
+        std::string moveStr;
+        while (moves >> moveStr){
+            if (!isValidMoveStr(moveStr)){
+                std::cerr << "ERROR: INVALID MOVE " << moveStr << " IN SCRIPT FILE" << std::endl;
+                exit(1);
+            }
+            script.push_back(moveFromStr(moveStr));
+        }
+        if (!script.empty()){
+            scripts.push_back(script);
+        }
+    }
+    return scripts;
+}
+
+
+int main(int argc, char* argv[]){
+    SelfPlayConfig config;
+    config.numThreads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    std::string scriptPath;
+    std::string profileMode;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--games"){ config.numGames = atoi(value.c_str()); }
+        else if (arg == "--threads"){ config.numThreads = atoi(value.c_str()); }
+        else if (arg == "--max-plies"){ config.maxPlies = atoi(value.c_str()); }
+        else if (arg == "--seed"){ seed = strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--script"){ scriptPath = value; }
+        else if (arg == "--pgn"){ config.pgnPath = value; }
+        else if (arg == "--bin"){ config.binPath = value; }
+        else if (arg == "--chess960" && (value == "on" || value == "off")){ config.chess960 = (value == "on"); }
+        else if (arg == "--profile" && (value == "batch" || value == "games")){ profileMode = value; }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::shared_ptr<MoveChooser> chooser(new RandomChooser(seed));
+    if (!scriptPath.empty()){
+        chooser = std::shared_ptr<MoveChooser>(new ScriptedChooser(readScripts(scriptPath), chooser));
+    }
+    config.whiteChooser = chooser;
+    config.blackChooser = chooser;
+
+    SelfPlayRunner runner(config);
+    if (!runner.run()){
+        std::cerr << "ERROR: FAILED TO WRITE OUTPUT FILES" << std::endl;
+        return 1;
+    }
+
+    // Tally results
+    int whiteWins = 0, blackWins = 0, draws = 0, unfinished = 0;
+    long totalPlies = 0;
+    for (auto& record: runner.getRecords()){
+        switch (record.result){
+            case GameResult::WHITE_WINS: whiteWins++; break;
+            case GameResult::BLACK_WINS: blackWins++; break;
+            case GameResult::DRAW: draws++; break;
+            case GameResult::UNFINISHED: unfinished++; break;
+        }
+        totalPlies += record.moves.size();
+    }
+
+    std::cout << "GAMES: " << runner.getRecords().size() << " (THREADS: " << config.numThreads << ")" << std::endl;
+    std::cout << "WHITE WINS: " << whiteWins << "  BLACK WINS: " << blackWins << "  DRAWS: " << draws << "  UNFINISHED: " << unfinished << std::endl;
+    std::cout << "PLIES: " << totalPlies << std::endl;
+    std::cout << "TIME: " << runner.getElapsedSeconds() << " s" << std::endl;
+    std::cout << "GAMES/HOUR: " << (long)runner.getGamesPerHour() << std::endl;
+
+    if (profileMode == "games"){
+        for (size_t i = 0; i < runner.getRecords().size(); i++){
+            writeProfile(std::cout, runner.getRecords()[i].profile, "GAME " + std::to_string(i + 1));
+        }
+    }
+    if (!profileMode.empty()){
+        writeProfile(std::cout, runner.getProfile(), "BATCH");
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,497 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "server.hpp"
+#include "packedgame.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "move.hpp"
+
+
+// epoll user data for the listening socket and the wake eventfd. Connection ids start after these.
+static const uint64_t LISTEN_ID = 0;
+static const uint64_t WAKE_ID = 1;
+
+// Longest request line accepted. A connection sending a longer one is closed.
+static const size_t MAX_LINE = 512;
+
+static const std::string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+
+// True if a (valid) FEN's castling field is "-" or made of K, Q, k and q. File letters (Shredder-FEN, or X-FEN naming an
+// inner rook) are for Chess960, which PackedGame can't hold, as it doesn't keep which rooks can castle.
+static bool hasStandardCastling(const std::string& fen){
+    std::istringstream fields(fen);
+    std::string placement, turn, castling;
+    fields >> placement >> turn >> castling;
+    return castling == "-" || castling.find_first_not_of("KQkq") == std::string::npos;
+}
+
+
+static void setNonBlocking(int fd){
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+
+GameServer::GameServer(const std::string& socketPath, int numWorkers, const std::string& journalDir)
+    : socketPath(socketPath), journalDir(journalDir) {
+    listenFd = -1;
+    epollFd = -1;
+    wakeFd = -1;
+    stopping = false;
+    nextConnId = WAKE_ID + 1;
+    nextGameId = 1;
+    for (int i = 0; i < std::max(1, numWorkers); i++){
+        workers.push_back(std::unique_ptr<Worker>(new Worker));
+    }
+}
+
+
+GameServer::~GameServer(){
+    for (auto& conn: connections){
+        close(conn.second.fd);
+    }
+    if (listenFd >= 0){
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+    if (epollFd >= 0){ close(epollFd); }
+    if (wakeFd >= 0){ close(wakeFd); }
+}
+
+
+bool GameServer::run(){
+    if (!journalDir.empty() && !recoverJournal()){
+        return false;
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (listenFd < 0 || socketPath.size() >= sizeof(addr.sun_path)){
+        std::cerr << "ERROR: COULD NOT CREATE SOCKET" << std::endl;
+        return false;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+    unlink(socketPath.c_str()); // Remove the socket file left by a previous run, if any
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, SOMAXCONN) < 0){
+        std::cerr << "ERROR: COULD NOT LISTEN ON " << socketPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    setNonBlocking(listenFd);
+
+    epollFd = epoll_create1(0);
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.u64 = WAKE_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    for (auto& worker: workers){
+        Worker* w = worker.get();
+        w->thread = std::thread([this, w](){ workerLoop(*w); });
+    }
+
+    const int MAX_EVENTS = 256;
+    epoll_event events[MAX_EVENTS];
+    while (!stopping){
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (n < 0 && errno != EINTR){
+            break;
+        }
+        for (int i = 0; i < n; i++){
+            uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID){
+                acceptConnections();
+            } else if (id == WAKE_ID){
+                uint64_t count;
+                while (read(wakeFd, &count, sizeof(count)) > 0){}
+                collectResults();
+            } else {
+                // The connection may have been closed by an earlier event in this batch
+                if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && connections.count(id)){
+                    readConnection(id);
+                }
+                if ((events[i].events & EPOLLOUT) && connections.count(id)){
+                    writeConnection(id);
+                }
+            }
+        }
+    }
+
+    // Let the workers finish, then shut down
+    for (auto& worker: workers){
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+        }
+        worker->wake.notify_one();
+    }
+    for (auto& worker: workers){
+        worker->thread.join();
+    }
+    return true;
+}
+
+
+// Games are routed to workers by id, so the journal must have been written with as many workers as there are now
+bool GameServer::recoverJournal(){
+    int numShards = MoveJournal::countShards(journalDir);
+    if (numShards != 0 && numShards != (int)workers.size()){
+        std::cerr << "ERROR: JOURNAL IN " << journalDir << " HAS " << numShards << " SHARDS, SO NEEDS " << numShards << " WORKERS" << std::endl;
+        return false;
+    }
+
+    uint32_t maxGameId = 0;
+    size_t numGames = 0;
+    for (size_t i = 0; i < workers.size(); i++){
+        Worker& worker = *workers[i];
+        worker.journal.reset(new MoveJournal(journalDir, i));
+        if (!worker.journal->open(worker.games, maxGameId)){
+            std::cerr << "ERROR: COULD NOT RECOVER JOURNAL SHARD " << i << " IN " << journalDir << std::endl;
+            return false;
+        }
+        numGames += worker.games.size();
+    }
+    nextGameId = maxGameId + 1;
+    std::cout << "RECOVERED " << numGames << " GAMES FROM " << journalDir << std::endl;
+    return true;
+}
+
+
+void GameServer::stop(){
+    stopping = true;
+    if (wakeFd >= 0){
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+
+void GameServer::acceptConnections(){
+    while (true){
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0){
+            return;
+        }
+        setNonBlocking(fd);
+
+        uint64_t connId = nextConnId++;
+        Connection& conn = connections[connId];
+        conn.fd = fd;
+        conn.nextSeq = 0;
+        conn.nextSend = 0;
+        conn.wantWrite = false;
+
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = connId;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+
+void GameServer::readConnection(uint64_t connId){
+    char buf[4096];
+    while (true){
+        Connection& conn = connections[connId];
+        ssize_t n = read(conn.fd, buf, sizeof(buf));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+            closeConnection(connId);
+            return;
+        }
+        if (n < 0){
+            return;
+        }
+
+        conn.in.append(buf, n);
+        size_t lineStart = 0;
+        size_t newline;
+        while ((newline = conn.in.find('\n', lineStart)) != std::string::npos){
+            std::string line = conn.in.substr(lineStart, newline - lineStart);
+            if (!line.empty() && line.back() == '\r'){
+                line.pop_back();
+            }
+            handleLine(connId, line);
+            lineStart = newline + 1;
+        }
+        conn.in.erase(0, lineStart);
+        if (conn.in.size() > MAX_LINE){
+            closeConnection(connId);
+            return;
+        }
+    }
+}
+
+
+// On an error the socket is shut down rather than closed, as this can be called while the connection is being read.
+// The shutdown wakes the event loop, which then closes it.
+void GameServer::writeConnection(uint64_t connId){
+    Connection& conn = connections[connId];
+    while (!conn.out.empty()){
+        ssize_t n = write(conn.fd, conn.out.data(), conn.out.size());
+        if (n < 0){
+            if (errno == EAGAIN || errno == EWOULDBLOCK){
+                break;
+            }
+            if (errno == EINTR){
+                continue;
+            }
+            conn.out.clear();
+            shutdown(conn.fd, SHUT_RDWR);
+            break;
+        }
+        conn.out.erase(0, n);
+    }
+
+    // Only ask to be told when the socket is writable while there is something left to write
+    bool wantWrite = !conn.out.empty();
+    if (wantWrite != conn.wantWrite){
+        epoll_event ev;
+        ev.events = wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        ev.data.u64 = connId;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+        conn.wantWrite = wantWrite;
+    }
+}
+
+
+// Responses still being worked on for the connection are dropped when they arrive (see collectResults()).
+// Its games stay open, so a client can reconnect and carry on.
+void GameServer::closeConnection(uint64_t connId){
+    auto it = connections.find(connId);
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    connections.erase(it);
+}
+
+
+// Requests are parsed here, so only well-formed ones reach the workers.
+// NEW is given its game id here, then handed to the worker that will own the game.
+void GameServer::handleLine(uint64_t connId, const std::string& line){
+    uint64_t seq = connections[connId].nextSeq++;
+
+    std::istringstream stream(line);
+    std::string command;
+    stream >> command;
+
+    Job job;
+    job.connId = connId;
+    job.seq = seq;
+    job.gameId = 0;
+
+    if (command == "NEW"){
+        job.command = Command::NEW;
+        std::getline(stream >> std::ws, job.arg);
+        if (job.arg.empty()){
+            job.arg = START_FEN;
+        } else if (!Game::isValidFen(job.arg)){
+            respond(connId, seq, "ERR INVALID FEN");
+            return;
+        } else if (!hasStandardCastling(job.arg)){
+            respond(connId, seq, "ERR CHESS960 NOT SUPPORTED");
+            return;
+        }
+        job.gameId = nextGameId++;
+    } else {
+        if (command == "MOVE"){ job.command = Command::MOVE; }
+        else if (command == "FEN"){ job.command = Command::FEN; }
+        else if (command == "END"){ job.command = Command::END; }
+        else {
+            respond(connId, seq, "ERR BAD REQUEST");
+            return;
+        }
+
+        std::string extra;
+        if (!(stream >> job.gameId) || (job.command == Command::MOVE && !(stream >> job.arg)) || (stream >> extra)){
+            respond(connId, seq, "ERR BAD REQUEST");
+            return;
+        }
+        if (job.command == Command::MOVE && !isValidMoveStr(job.arg)){
+            respond(connId, seq, "ERR BAD MOVE");
+            return;
+        }
+    }
+
+    Worker& worker = *workers[job.gameId % workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(job);
+    }
+    worker.wake.notify_one();
+}
+
+
+// Results for connections that have since closed are dropped
+void GameServer::collectResults(){
+    std::vector<Result> ready;
+    {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        ready.swap(results);
+    }
+    for (auto& result: ready){
+        if (connections.count(result.connId)){
+            respond(result.connId, result.seq, result.response);
+        }
+    }
+}
+
+
+void GameServer::respond(uint64_t connId, uint64_t seq, const std::string& response){
+    Connection& conn = connections[connId];
+    conn.pending[seq] = response;
+    bool added = false;
+    auto it = conn.pending.begin();
+    while (it != conn.pending.end() && it->first == conn.nextSend){
+        conn.out += it->second + "\n";
+        conn.nextSend++;
+        it = conn.pending.erase(it);
+        added = true;
+    }
+    if (added && !conn.wantWrite){ // If waiting for writability, the rest is written once the socket is writable
+        writeConnection(connId);
+    }
+}
+
+
+// Jobs are taken in batches, and their results passed back to the event loop in a single batch, waking it once.
+void GameServer::workerLoop(Worker& worker){
+    while (true){
+        std::deque<Job> jobs;
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.wake.wait(lock, [&](){ return !worker.jobs.empty() || stopping; });
+            if (worker.jobs.empty()){
+                return; // Stopping
+            }
+            jobs.swap(worker.jobs);
+        }
+
+        std::vector<Result> done;
+        for (auto& job: jobs){
+            done.push_back({job.connId, job.seq, handleJob(worker, job)});
+        }
+
+        // The batch's records must be on disk before it is answered. If they can't be written, games would be
+        // lost on a restart after being answered, so the server stops instead.
+        if (worker.journal != nullptr){
+            bool ok = worker.journal->commit();
+            if (ok && worker.journal->snapshotDue()){
+                ok = worker.journal->snapshot(worker.games);
+            }
+            if (!ok){
+                std::cerr << "ERROR: COULD NOT WRITE JOURNAL" << std::endl;
+                stop();
+                return;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            results.insert(results.end(), done.begin(), done.end());
+        }
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+
+std::string GameServer::handleJob(Worker& worker, const Job& job){
+    if (job.command == Command::NEW){
+        Player white(PieceColor::WHITE);
+        Player black(PieceColor::BLACK);
+        Game game(&white, &black, job.arg);
+        if (game.isChess960()){
+            return "ERR CHESS960 NOT SUPPORTED"; // KQkq with the king off the e-file
+        }
+        PackedGame packed = packFen(game.toFen()); // Via the Game, so castling rights the position doesn't allow are dropped
+        packed.hashes.push_back(game.getHash());
+        setLegalMoves(packed, game.legalMoves());
+        packed.state = game.getGameState();
+        worker.games[job.gameId] = packed;
+        if (worker.journal != nullptr){
+            worker.journal->logNew(job.gameId, game.toFen());
+        }
+        return "OK " + std::to_string(job.gameId);
+    }
+
+    auto it = worker.games.find(job.gameId);
+    if (it == worker.games.end()){
+        return "ERR NO SUCH GAME";
+    }
+
+    switch (job.command){
+        case Command::MOVE: {
+            std::string response = handleMove(it->second, job.arg);
+            if (worker.journal != nullptr && response.compare(0, 3, "OK ") == 0){
+                worker.journal->logMove(job.gameId, moveFromStr(job.arg));
+            }
+            return response;
+        }
+        case Command::FEN:
+            return "OK " + unpackToFen(it->second);
+        default: // END
+            worker.games.erase(it);
+            if (worker.journal != nullptr){
+                worker.journal->logEnd(job.gameId);
+            }
+            return "OK";
+    }
+}
+
+
+// The move is validated against the legal moves kept in the packed game, so an illegal move is rejected without unpacking it.
+// A legal move is made on a Game unpacked from the packed game, and the legal moves of the new position are worked out
+// once, both to keep for the next move and for getGameState() to answer from.
+//
+// The unpacked Game only knows the position, not the moves that led to it, so repetitions are counted from the hashes
+// kept in the packed game. getGameState() handles every other way the game can end.
+std::string GameServer::handleMove(PackedGame& packed, const std::string& moveStr){
+    if (packed.state != GameState::CONTESTED){
+        return "ERR GAME OVER";
+    }
+
+    Move m = moveFromStr(moveStr);
+    if (!isLegalMove(packed, m)){
+        return "ILLEGAL";
+    }
+
+    Player white(PieceColor::WHITE);
+    Player black(PieceColor::BLACK);
+    Game game(&white, &black, unpackToFen(packed));
+    game.makeMove(m);
+
+    // A pawn move or capture means no earlier position can occur again
+    if (game.getHalfmoveClock() == 0){
+        packed.hashes.clear();
+    }
+    std::vector<uint64_t> hashes;
+    hashes.swap(packed.hashes);
+    hashes.push_back(game.getHash());
+
+    packed = packFen(game.toFen());
+    packed.hashes.swap(hashes);
+    setLegalMoves(packed, game.legalMoves());
+    packed.state = game.getGameState();
+    if (packed.state == GameState::CONTESTED && repetitionCount(packed, game.getHash()) >= 3){
+        packed.state = GameState::THREEFOLD_REPETITION;
+    }
+    return "OK " + gameStateToStr(packed.state);
+}
@@ -0,0 +1,134 @@
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+#include "packedgame.hpp"
+#include "journal.hpp"
+
+#pragma once
+
+
+// Hosts many games in a single process, taking requests from clients over a local (Unix domain) socket.
+//
+// Requests and responses are lines of text. Responses on a connection are sent in the same order as the requests,
+// so a client can send many requests (e.g. a move in each of its games) before reading the responses.
+//
+//   NEW [FEN]         start a game, from the starting position or the position given  -> OK <game id>
+//                     (standard chess only: a Chess960 position gets ERR CHESS960 NOT SUPPORTED)
+//   MOVE <id> <move>  play a move in coordinate notation (e.g. e2e4, e7e8q, e1g1 to castle short)
+//                     -> OK <state after the move, as named by gameStateToStr()>, or ILLEGAL
+//   FEN <id>          -> OK <FEN of the game's current position>
+//   END <id>          forget a game -> OK
+// Any request can instead get ERR <reason>, e.g. ERR NO SUCH GAME or ERR GAME OVER.
+//
+// A single thread runs the event loop (epoll), which accepts connections, reads and parses requests, and writes responses.
+// Games are split between a pool of worker threads by id, and only the worker that owns a game touches it,
+// so moves in the same game are handled in order without any locking.
+// Each game is kept as a PackedGame, which holds the legal moves of its position so that a move is validated with a single lookup.
+// A legal move is made on a Game unpacked from it, and the state of the game then found with getGameState().
+//
+// With a journal directory, each worker logs its games to a MoveJournal of its own (see journal.hpp), committing once
+// per batch of requests before answering them, so a game whose move has been answered survives a crash or restart.
+// The games are recovered from the journal when the server starts.
+class GameServer{
+
+    public:
+
+        // journalDir is the directory to keep the journal in, or empty for none
+        GameServer(const std::string& socketPath, int numWorkers, const std::string& journalDir = "");
+
+        ~GameServer();
+
+        // Recovers the games in the journal, if there is one, then listens on the socket and runs the event loop until
+        // stop() is called. Returns false if the journal could not be recovered or the socket could not be set up.
+        bool run();
+
+        // Makes run() return. Safe to call from another thread or a signal handler.
+        void stop();
+
+    private:
+
+        enum class Command{ NEW, MOVE, FEN, END };
+
+        // A parsed request, for a worker to handle
+        struct Job{
+            uint64_t connId;
+            uint64_t seq; // Position of the request on its connection
+            Command command;
+            uint32_t gameId;
+            std::string arg; // FEN for NEW, move string for MOVE
+        };
+
+        // A response for the event loop to send
+        struct Result{
+            uint64_t connId;
+            uint64_t seq;
+            std::string response;
+        };
+
+        struct Worker{
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::deque<Job> jobs;
+            std::unordered_map<uint32_t, PackedGame> games; // Only touched by the worker's thread
+            std::unique_ptr<MoveJournal> journal; // Null if there is no journal
+        };
+
+        struct Connection{
+            int fd;
+            std::string in;  // Received data not yet making up a full line
+            std::string out; // Responses not yet written
+            uint64_t nextSeq;  // Sequence number for the next request
+            uint64_t nextSend; // Sequence number of the next response to send
+            std::map<uint64_t, std::string> pending; // Finished responses waiting for earlier ones
+            bool wantWrite; // True if registered with epoll for writability
+        };
+
+        // Event loop handlers
+        void acceptConnections();
+        void readConnection(uint64_t connId);
+        void writeConnection(uint64_t connId);
+        void closeConnection(uint64_t connId);
+        void handleLine(uint64_t connId, const std::string& line);
+        void collectResults();
+
+        // Queues a response to the request with the given sequence number on a connection, and sends whatever responses are now in order
+        void respond(uint64_t connId, uint64_t seq, const std::string& response);
+
+        // Worker thread body, and the handling of a single job
+        void workerLoop(Worker& worker);
+        std::string handleJob(Worker& worker, const Job& job);
+        std::string handleMove(PackedGame& packed, const std::string& moveStr);
+
+        // Opens each worker's journal and recovers its games
+        bool recoverJournal();
+
+        std::string socketPath;
+
+        std::string journalDir;
+
+        int listenFd;
+        int epollFd;
+        int wakeFd; // eventfd written to wake the event loop, when results are ready or on stop()
+
+        std::atomic<bool> stopping;
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        std::mutex resultsMutex;
+        std::vector<Result> results;
+
+        std::unordered_map<uint64_t, Connection> connections; // By connection id. Only touched by the event loop.
+        uint64_t nextConnId;
+
+        uint32_t nextGameId;
+};
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <csignal>
+#include <thread>
+#include <algorithm>
+
+#include "server.hpp"
+
+
+// Hosts many concurrent games over a Unix domain socket (see server.hpp for the protocol).
+// Runs until interrupted (Ctrl-C) or terminated.
+//
+// Usage: chess_server [options]
+//   --socket PATH   socket to listen on (default /tmp/chess.sock)
+//   --workers N     number of worker threads validating moves (default: number of hardware threads)
+//   --journal DIR   log games to a journal in DIR (which must exist), and recover the games in it on starting.
+//                   The number of workers must stay the same between runs using the same journal.
+
+
+static GameServer* runningServer = nullptr;
+
+
+static void handleSignal(int){
+    if (runningServer != nullptr){
+        runningServer->stop();
+    }
+}
+
+
+void printUsage(){
+    std::cerr << "USAGE: chess_server [--socket PATH] [--workers N] [--journal DIR]" << std::endl;
+}
+
+
+int main(int argc, char* argv[]){
+    std::string socketPath = "/tmp/chess.sock";
+    int numWorkers = std::max(1u, std::thread::hardware_concurrency());
+    std::string journalDir;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (i + 1 >= argc){
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--socket"){ socketPath = value; }
+        else if (arg == "--workers"){ numWorkers = atoi(value.c_str()); }
+        else if (arg == "--journal"){ journalDir = value; }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    GameServer server(socketPath, numWorkers, journalDir);
+    runningServer = &server;
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    signal(SIGPIPE, SIG_IGN); // A client disconnecting mid-write shows up as a write error instead
+
+    std::cout << "LISTENING ON " << socketPath << " (WORKERS: " << std::max(1, numWorkers) << ")" << std::endl;
+    bool ok = server.run();
+    runningServer = nullptr;
+    return ok ? 0 : 1;
+}
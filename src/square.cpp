@@ -12,10 +12,13 @@ Square square(int row, int col){
 
 
 Square squareFromStr(const std::string& str){
-    int row = str[1] - '1'; // Difference in ASCII value between 2nd char and '1' gives row no.
-    int col = str[0] - 'a'; // Difference in ASCII value between 1st char and 'a' gives column no.
-    Square res = square(row, col);
-    return res;
+    return toSquare(squareIndexFromStr(str));
+}
+
+
+std::string squareToStr(SquareIndex sq){
+    std::array<char, 2> chars = squareChars(sq);
+    return std::string(chars.begin(), chars.end());
 }
 
 
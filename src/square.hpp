@@ -1,5 +1,7 @@
 #include <string>
+#include <string_view>
 #include <array>
+#include <cstdint>
 
 #pragma once
 
@@ -38,4 +40,89 @@ bool isValidSquareStr(const std::string& str);
 // This is returned in the form of a 2-element int array, 
 // of which the first element is the vertical displacement (i.e. difference in rows) 
 // and the second is the horizontal displacement (i.e. difference in columns).
-std::array<int, 2> displacement(const Square& start, const Square& dest);
\ No newline at end of file
+std::array<int, 2> displacement(const Square& start, const Square& dest);
+
+// A square as a single byte: row*8 + col, so 0 is "a1", 7 is "h1", 8 is "a2" and 63 is "h8".
+// This is what moves, the pieces, the players and Game work with, and what the attack tables are indexed by.
+// The Square struct is kept for code written in terms of rows and columns (e.g. the terminal front end), which Game
+// also accepts through overloads, and the two convert with squareIndex() and toSquare().
+typedef uint8_t SquareIndex;
+
+// Stands for no square, e.g. when there is no en passant square, or an offset runs off the board
+constexpr SquareIndex NO_SQUARE = 64;
+
+
+constexpr SquareIndex squareIndex(int row, int col){
+    return (SquareIndex)(row*8 + col);
+}
+
+constexpr SquareIndex squareIndex(const Square& sq){
+    return squareIndex(sq.row, sq.col);
+}
+
+
+// Row (0 for rank 1 through 7 for rank 8) and column (0 for file a through 7 for file h) of a square
+constexpr int rankOf(SquareIndex sq){
+    return sq >> 3;
+}
+
+constexpr int fileOf(SquareIndex sq){
+    return sq & 7;
+}
+
+
+constexpr Square toSquare(SquareIndex sq){
+    return Square{ rankOf(sq), fileOf(sq) };
+}
+
+
+constexpr bool isOnBoard(int row, int col){
+    return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+
+// The square rows rows up and cols columns across from sq, or NO_SQUARE if that is off the board
+constexpr SquareIndex offsetSquare(SquareIndex sq, int rows, int cols){
+    return isOnBoard(rankOf(sq) + rows, fileOf(sq) + cols) ? squareIndex(rankOf(sq) + rows, fileOf(sq) + cols) : NO_SQUARE;
+}
+
+
+// Distances between 2 squares: in rows, in columns, and in king moves (the larger of the two)
+constexpr int rankDistance(SquareIndex a, SquareIndex b){
+    return (rankOf(a) > rankOf(b)) ? rankOf(a) - rankOf(b) : rankOf(b) - rankOf(a);
+}
+
+constexpr int fileDistance(SquareIndex a, SquareIndex b){
+    return (fileOf(a) > fileOf(b)) ? fileOf(a) - fileOf(b) : fileOf(b) - fileOf(a);
+}
+
+constexpr int squareDistance(SquareIndex a, SquareIndex b){
+    return (rankDistance(a, b) > fileDistance(a, b)) ? rankDistance(a, b) : fileDistance(a, b);
+}
+
+
+// Same as displacement() for Squares: {rows, columns} from start to dest
+constexpr std::array<int, 2> displacement(SquareIndex start, SquareIndex dest){
+    return std::array<int, 2>{ {rankOf(dest) - rankOf(start), fileOf(dest) - fileOf(start)} };
+}
+
+
+// Square of a square string (e.g. "e4"). THIS ASSUMES THAT THE STRING IS VALID. USE ISVALIDSQUARESTR() TO CHECK FIRST.
+constexpr SquareIndex squareIndexFromStr(std::string_view str){
+    return squareIndex(str[1] - '1', str[0] - 'a');
+}
+
+
+// Letter and number of a square, e.g. {'e', '4'}
+constexpr std::array<char, 2> squareChars(SquareIndex sq){
+    return std::array<char, 2>{ {(char)('a' + fileOf(sq)), (char)('1' + rankOf(sq))} };
+}
+
+
+// Square string of a square, e.g. "e4"
+std::string squareToStr(SquareIndex sq);
+
+
+static_assert(squareIndexFromStr("e4") == squareIndex(3, 4) && squareChars(squareIndex(3, 4))[0] == 'e', "e4 is row 3, col 4");
+static_assert(offsetSquare(squareIndex(0, 0), -1, 0) == NO_SQUARE && offsetSquare(squareIndex(0, 0), 2, 1) == squareIndex(2, 1), "offsets stay on the board");
+static_assert(squareDistance(squareIndex(0, 0), squareIndex(7, 3)) == 7, "a1 to d8 is 7 king moves");
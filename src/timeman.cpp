@@ -0,0 +1,141 @@
+#include <array>
+#include <ostream>
+#include <iomanip>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+#include "timeman.hpp"
+#include "clock.hpp"
+
+
+// Number of moves the game is expected to last; the time left is shared out over the moves still to come
+static const int EXPECTED_GAME_MOVES = 60;
+
+// The time left is never shared out over fewer than this many moves, however long the game goes on
+static const int MIN_MOVES_TO_GO = 20;
+
+// The hard limit is at most this fraction of the time left, and this many times the soft limit
+static const int HARD_LIMIT_DIVISOR = 4;
+static const int HARD_LIMIT_MULTIPLE = 4;
+
+
+LatencyHistogram::LatencyHistogram(){
+    buckets.fill(0);
+    count = 0;
+    total = 0;
+    max = 0;
+}
+
+
+void LatencyHistogram::record(int64_t micros){
+    micros = std::max<int64_t>(0, micros);
+    int bucket = (micros == 0) ? 0 : 64 - __builtin_clzll((uint64_t)micros);
+    buckets[std::min(bucket, NUM_BUCKETS - 1)]++;
+    count++;
+    total += micros;
+    max = std::max(max, micros);
+}
+
+
+uint64_t LatencyHistogram::getCount(){
+    return count;
+}
+
+
+int64_t LatencyHistogram::getMax(){
+    return max;
+}
+
+
+double LatencyHistogram::getMean(){
+    return (count == 0) ? 0 : (double)total / count;
+}
+
+
+int64_t LatencyHistogram::percentile(double p){
+    if (count == 0){
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(p / 100 * count + 0.5));
+    uint64_t seen = 0;
+    for (int b = 0; b < NUM_BUCKETS; b++){
+        seen += buckets[b];
+        if (seen >= rank){
+            int64_t upper = (b == 0) ? 0 : ((int64_t)1 << b) - 1;
+            return std::min(upper, max);
+        }
+    }
+    return max;
+}
+
+
+void LatencyHistogram::write(std::ostream& out, const std::string& title){
+    out << std::fixed << std::setprecision(3);
+    out << title << std::endl;
+    out << "  COUNT " << count << "  MEAN " << getMean() / 1000 << "MS  P50 " << percentile(50) / 1000.0
+        << "MS  P90 " << percentile(90) / 1000.0 << "MS  P99 " << percentile(99) / 1000.0 << "MS  MAX " << max / 1000.0 << "MS" << std::endl;
+    for (int b = 0; b < NUM_BUCKETS; b++){
+        if (buckets[b] == 0){
+            continue;
+        }
+        int64_t lower = (b == 0) ? 0 : (int64_t)1 << (b - 1);
+        int64_t upper = (b == 0) ? 0 : ((int64_t)1 << b) - 1;
+        out << "    " << std::setw(12) << lower / 1000.0 << " - " << std::setw(12) << upper / 1000.0 << "MS"
+            << std::setw(10) << buckets[b] << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+
+TimeManager::TimeManager(const TimeControl& control, int64_t overheadMs) : control(control), overheadMs(overheadMs) {
+    overruns = 0;
+    ponderHits = 0;
+    ponderMisses = 0;
+}
+
+
+TimeManager::Budget TimeManager::budget(int64_t remainingMs, int moveNumber){
+    int64_t usable = std::max<int64_t>(0, remainingMs - overheadMs);
+    int movesToGo = std::max(MIN_MOVES_TO_GO, EXPECTED_GAME_MOVES - moveNumber);
+
+    Budget result;
+    result.softMs = usable / movesToGo + control.incrementMs * 3 / 4;
+    result.hardMs = std::min(usable / HARD_LIMIT_DIVISOR, result.softMs * HARD_LIMIT_MULTIPLE);
+
+    // Time within the delay isn't charged, so it can all be used (less the overhead)
+    int64_t freeMs = std::max<int64_t>(0, control.delayMs - overheadMs);
+    result.softMs += freeMs;
+    result.hardMs += freeMs;
+
+    result.hardMs = std::max<int64_t>(1, result.hardMs);
+    result.softMs = std::max<int64_t>(1, std::min(result.softMs, result.hardMs));
+    return result;
+}
+
+
+void TimeManager::recordMove(int64_t micros, const Budget& moveBudget){
+    latencies.record(micros);
+    if (micros > moveBudget.hardMs * 1000){
+        overruns++;
+    }
+}
+
+
+void TimeManager::recordPonder(bool hit){
+    if (hit){ ponderHits++; }
+    else { ponderMisses++; }
+}
+
+
+LatencyHistogram& TimeManager::getLatencies(){
+    return latencies;
+}
+
+
+void TimeManager::writeReport(std::ostream& out){
+    latencies.write(out, "TIME TO MOVE");
+    out << "  HARD LIMIT OVERRUNS " << overruns << std::endl;
+    uint64_t pondered = ponderHits + ponderMisses;
+    out << "  PONDER HITS " << ponderHits << " OF " << pondered << std::endl;
+}
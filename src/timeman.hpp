@@ -0,0 +1,92 @@
+#include <array>
+#include <ostream>
+#include <string>
+#include <cstdint>
+
+#include "clock.hpp"
+
+#pragma once
+
+
+// Histogram of latencies in microseconds, in power-of-2 buckets: bucket b counts latencies from 2^(b-1) up to 2^b - 1
+// (bucket 0 counts latencies of 0), so percentiles are accurate to within a factor of 2 while recording costs next to nothing.
+class LatencyHistogram{
+
+    public:
+
+        static const int NUM_BUCKETS = 40;
+
+        LatencyHistogram();
+
+        void record(int64_t micros);
+
+        uint64_t getCount();
+
+        int64_t getMax();
+
+        double getMean();
+
+        // Upper bound of the bucket holding the latency at the given percentile (0-100), capped at the maximum latency recorded
+        int64_t percentile(double p);
+
+        // Writes the count, mean, percentiles and the non-empty buckets, with times in milliseconds
+        void write(std::ostream& out, const std::string& title);
+
+    private:
+
+        std::array<uint64_t, NUM_BUCKETS> buckets;
+
+        uint64_t count;
+
+        int64_t total;
+
+        int64_t max;
+};
+
+
+// Decides how long to think about each move, and keeps statistics on how long moves actually took.
+//
+// The time left is shared out over the moves the game is expected to last, so the budget shrinks as the clock runs down
+// and the game goes on. Most of the increment, and the whole delay (which is never charged), are added on top.
+// Each budget is a soft limit, after which no new search iteration should be started, and a hard limit at which
+// the search must stop. The hard limit leaves a safety margin for the time taken to get the move to the opponent.
+class TimeManager{
+
+    public:
+
+        TimeManager(const TimeControl& control, int64_t overheadMs = 30);
+
+        struct Budget{
+            int64_t softMs;
+            int64_t hardMs;
+        };
+
+        // Budget for a move, given the player's remaining time and the fullmove number
+        Budget budget(int64_t remainingMs, int moveNumber);
+
+        // Records the time to move of a move (from the start of the player's turn until the move was made),
+        // and whether it went over the budget's hard limit
+        void recordMove(int64_t micros, const Budget& moveBudget);
+
+        // Records whether the opposition played the move that was pondered on
+        void recordPonder(bool hit);
+
+        LatencyHistogram& getLatencies();
+
+        // Writes the time-to-move histogram, hard limit overruns and ponder hit rate
+        void writeReport(std::ostream& out);
+
+    private:
+
+        TimeControl control;
+
+        int64_t overheadMs;
+
+        LatencyHistogram latencies;
+
+        uint64_t overruns;
+
+        uint64_t ponderHits;
+
+        uint64_t ponderMisses;
+};
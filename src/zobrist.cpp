@@ -0,0 +1,46 @@
+#include <cstdint>
+#include <string>
+
+#include "zobrist.hpp"
+#include "piece.hpp"
+
+
+// splitmix64 - a small, fast generator that gives well-distributed 64-bit values from consecutive seeds
+static uint64_t splitmix64(uint64_t& state){
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+static ZobristKeys generateKeys(){
+    ZobristKeys keys;
+    uint64_t state = 0x43686573735A6F62ULL; // Fixed seed
+
+    for (int p = 0; p < 12; p++){
+        for (int sq = 0; sq < 64; sq++){
+            keys.pieces[p][sq] = splitmix64(state);
+        }
+    }
+    keys.blackToMove = splitmix64(state);
+    for (int i = 0; i < 4; i++){
+        keys.castling[i] = splitmix64(state);
+    }
+    for (int i = 0; i < 8; i++){
+        keys.enPassantFile[i] = splitmix64(state);
+    }
+    return keys;
+}
+
+
+const ZobristKeys& zobristKeys(){
+    static const ZobristKeys keys = generateKeys(); // Initialized once, on first call (thread-safe)
+    return keys;
+}
+
+
+int zobristPieceIndex(Piece* piece){
+    static const std::string order = "PNBRQKpnbrqk";
+    return order.find(piece->toChar());
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include <cstdint>
+
+#include "piece.hpp"
+
+#pragma once
+
+
+// Random keys used to hash positions (Zobrist hashing).
+// A position's hash is the XOR of the key for each piece on its square, plus the keys for
+// black being to move, each castling right that is still available, and the en passant file (if any).
+// As XOR is its own inverse, the hash can be updated as each move is made by XORing out the old keys and XORing in the new ones.
+struct ZobristKeys{
+    uint64_t pieces[12][64]; // Indexed by zobristPieceIndex() then square (row*8 + col)
+    uint64_t blackToMove;
+    uint64_t castling[4]; // White short, white long, black short, black long
+    uint64_t enPassantFile[8];
+};
+
+
+// Returns the keys. They are generated from a fixed seed the first time this is called, so hashes are the same from run to run.
+const ZobristKeys& zobristKeys();
+
+
+// Index of a piece in ZobristKeys::pieces:
+// 0-5 for a white pawn, knight, bishop, rook, queen or king, and 6-11 for the same black pieces.
+int zobristPieceIndex(Piece* piece);
\ No newline at end of file
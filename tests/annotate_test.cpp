@@ -0,0 +1,55 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "annotate.hpp"
+#include "pgn.hpp"
+
+
+// Checks that annotation replays games as they were played: past a threefold repetition (a draw only if claimed),
+// but not past checkmate or a move that isn't legal. Exits with 1 if a game is read differently.
+
+
+struct AnnotateCase{
+    const char* name;
+    const char* pgn;
+    bool valid;
+    size_t numMoves; // Moves annotated
+};
+
+
+static const AnnotateCase CASES[] = {
+    {"played on past threefold", "[Result \"*\"]\n\n1. Nf3 Nf6 2. Ng1 Ng8 3. Nf3 Nf6 4. Ng1 Ng8 5. e4 e5 *\n", true, 10},
+    {"moves after checkmate", "[Result \"0-1\"]\n\n1. f3 e5 2. g4 Qh4# 3. a3 0-1\n", false, 4},
+    {"illegal move", "[Result \"*\"]\n\n1. e4 e5 2. Ke3 *\n", false, 2},
+};
+
+
+int main(){
+    AnnotateConfig config;
+    config.limits.nodes = 500;
+    GameAnnotator annotator(config);
+    int failures = 0;
+    for (const AnnotateCase& c: CASES){
+        std::istringstream in(c.pgn);
+        PgnGame game;
+        if (!readPgn(in, game)){
+            std::cerr << "FAIL: " << c.name << ": PGN NOT READ" << std::endl;
+            failures++;
+            continue;
+        }
+        GameAnnotation annotation = annotator.annotate(game);
+        if (annotation.valid != c.valid || annotation.moves.size() != c.numMoves){
+            std::cerr << "FAIL: " << c.name << ": " << (annotation.valid ? "VALID" : "INVALID") << " WITH "
+                      << annotation.moves.size() << " MOVES (EXPECTED " << (c.valid ? "VALID" : "INVALID") << " WITH "
+                      << c.numMoves << ")" << std::endl;
+            failures++;
+        }
+    }
+    if (failures > 0){
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
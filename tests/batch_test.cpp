@@ -0,0 +1,120 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <random>
+#include <cctype>
+#include <cstdint>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "piece.hpp"
+#include "eval.hpp"
+#include "batch.hpp"
+
+
+// Checks evaluateBatch() against the same features worked out square by square with the piece classes, over positions
+// reached by random moves from the standard perft positions. Positions are added to one batch from their Games and
+// to another from their FENs, which must agree. Exits with 1 if any feature is off.
+
+
+static const char* STARTS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+};
+
+static const int NUM_POSITIONS = 400;
+
+
+// Material, mobility and attacks of the game's position, from white's point of view (see BatchFeatures)
+static std::array<int, 3> bruteForceFeatures(Game& game){
+    std::array<std::array<Piece*, 8>, 8> board = game.getBoard();
+    std::array<int, 3> features = {0, 0, 0};
+    for (PieceColor color: {PieceColor::WHITE, PieceColor::BLACK}){
+        PieceColor opp = (color == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+        int sign = (color == PieceColor::WHITE) ? 1 : -1;
+
+        // Mobility counts each square once per kind of piece
+        for (char kind: std::string("nbrq")){
+            uint64_t reached = 0;
+            for (int from = 0; from < 64; from++){
+                Piece* piece = board[from / 8][from % 8];
+                if (piece == nullptr || piece->getColor() != color || tolower(piece->toChar()) != kind){
+                    continue;
+                }
+                for (int to = 0; to < 64; to++){
+                    Piece* target = board[to / 8][to % 8];
+                    if (to != from && (target == nullptr || target->getColor() != color) && piece->attacks(from, to, board)){
+                        reached |= (uint64_t)1 << to;
+                    }
+                }
+            }
+            features[1] += sign * __builtin_popcountll(reached);
+        }
+
+        for (int sq = 0; sq < 64; sq++){
+            Piece* piece = board[sq / 8][sq % 8];
+            if (piece == nullptr){
+                continue;
+            }
+            if (piece->getColor() == color && tolower(piece->toChar()) != 'k'){
+                features[0] += sign * pieceValue(piece);
+            } else if (piece->getColor() == opp && isAttacked((SquareIndex)sq, board, opp)){
+                features[2] += sign;
+            }
+        }
+    }
+    return features;
+}
+
+
+int main(){
+    std::mt19937 rng(1);
+    PositionBatch fromGames, fromFens;
+    std::vector<std::array<int, 3>> expected;
+    std::vector<std::string> fens;
+    for (int i = 0; i < NUM_POSITIONS; i++){
+        Player white(PieceColor::WHITE);
+        Player black(PieceColor::BLACK);
+        Game game(&white, &black, STARTS[i % 4]);
+        int plies = rng() % 60;
+        for (int ply = 0; ply < plies; ply++){
+            std::vector<Move> moves = game.legalMoves();
+            if (moves.empty()){
+                break;
+            }
+            game.makeMove(moves[rng() % moves.size()]);
+        }
+        expected.push_back(bruteForceFeatures(game));
+        fens.push_back(game.toFen());
+        fromGames.add(game);
+        fromFens.add(game.toFen());
+    }
+
+    int failures = 0;
+    if (fromFens.add("not a fen") || fromFens.size() != fens.size()){
+        std::cerr << "FAIL: AN INVALID FEN WAS ADDED" << std::endl;
+        failures++;
+    }
+
+    BatchFeatures gameFeatures, fenFeatures;
+    evaluateBatch(fromGames, gameFeatures);
+    evaluateBatch(fromFens, fenFeatures);
+    for (size_t i = 0; i < fens.size(); i++){
+        std::array<int, 3> got = {gameFeatures.material[i], gameFeatures.mobility[i], gameFeatures.attacks[i]};
+        bool fensAgree = fenFeatures.material[i] == got[0] && fenFeatures.mobility[i] == got[1]
+            && fenFeatures.attacks[i] == got[2] && fenFeatures.score[i] == gameFeatures.score[i];
+        if (got != expected[i] || !fensAgree){
+            std::cerr << "FAIL: " << fens[i] << ": MATERIAL " << got[0] << " MOBILITY " << got[1] << " ATTACKS " << got[2]
+                      << " (EXPECTED " << expected[i][0] << " " << expected[i][1] << " " << expected[i][2] << ")" << std::endl;
+            failures++;
+        }
+    }
+    if (failures > 0){
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "packedgame.hpp"
+#include "datagen.hpp"
+
+
+// Checks the way datagen stores positions, over positions reached by random moves from the standard perft positions
+// (which between them have castling rights, en passant squares and promotions): packPosition() must agree with
+// packFen() of the game's FEN, and a record built from it must survive encodeRecord() and decodeRecord() and give the
+// game's FEN back from recordToFen(). Exits with 1 if any position doesn't.
+
+
+static const char* STARTS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+};
+
+static const int NUM_POSITIONS = 2000;
+
+
+// The FEN without its fullmove number, which records don't keep
+static std::string withoutFullmove(const std::string& fen){
+    return fen.substr(0, fen.find_last_of(' '));
+}
+
+
+static bool samePacked(const PackedGame& a, const PackedGame& b){
+    return a.squares == b.squares && a.flags == b.flags && a.enPassantFile == b.enPassantFile
+        && a.halfmoveClock == b.halfmoveClock && a.fullmoveNumber == b.fullmoveNumber && a.state == b.state;
+}
+
+
+int main(){
+    std::mt19937 rng(1);
+    int failures = 0;
+    for (int i = 0; i < NUM_POSITIONS; i++){
+        Player white(PieceColor::WHITE);
+        Player black(PieceColor::BLACK);
+        Game game(&white, &black, STARTS[i % 4]);
+        int plies = rng() % 80;
+        for (int ply = 0; ply < plies; ply++){
+            std::vector<Move> moves = game.legalMoves();
+            if (moves.empty()){
+                break;
+            }
+            game.makeMove(moves[rng() % moves.size()]);
+        }
+        std::string fen = game.toFen();
+
+        PackedGame packed = packPosition(game.snapshot());
+        if (!samePacked(packed, packFen(fen))){
+            std::cerr << "FAIL: " << fen << ": PACKED AS " << unpackToFen(packed) << std::endl;
+            failures++;
+            continue;
+        }
+
+        TrainingRecord record;
+        record.squares = packed.squares;
+        record.flags = packed.flags;
+        record.enPassantFile = packed.enPassantFile;
+        record.halfmoveClock = packed.halfmoveClock;
+        record.result = (GameResult)(i % 3);
+        record.score = (int16_t)((int)(rng() % (2*MAX_RECORD_SCORE + 1)) - MAX_RECORD_SCORE);
+        std::vector<Move> moves = game.legalMoves();
+        record.bestMove = moves.empty() ? 0 : packMove(moves[rng() % moves.size()]);
+
+        uint8_t bytes[TRAINING_RECORD_BYTES];
+        encodeRecord(record, bytes);
+        TrainingRecord decoded = decodeRecord(bytes);
+        if (decoded.squares != record.squares || decoded.flags != record.flags || decoded.enPassantFile != record.enPassantFile
+            || decoded.halfmoveClock != record.halfmoveClock || decoded.result != record.result
+            || decoded.score != record.score || decoded.bestMove != record.bestMove){
+            std::cerr << "FAIL: " << fen << ": RECORD CHANGED BY ENCODING" << std::endl;
+            failures++;
+            continue;
+        }
+        if (withoutFullmove(recordToFen(decoded)) != withoutFullmove(fen)){
+            std::cerr << "FAIL: " << fen << ": RECORD GIVES " << recordToFen(decoded) << std::endl;
+            failures++;
+        }
+    }
+    if (failures > 0){
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <iostream>
+#include <string>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "pawns.hpp"
+
+
+// Checks evaluatePawnStructure() against scores worked out by hand, from white's point of view, with each pawn's terms
+// (isolated -12, backward -10, passed +10/+15/+25 on its 2nd/3rd/4th row). Exits with 1 if any score is off.
+
+
+struct PawnCase{
+    const char* name;
+    const char* fen;
+    int score;
+};
+
+
+static const PawnCase CASES[] = {
+    {"no pawns", "4k3/8/8/8/8/8/8/4K3 w - - 0 1", 0},
+    // d4 isolated, with d5 attacked by e6, but not also backward (-12). e6 supported by f7 (0), f7 passed (+10).
+    {"isolated, stop square attacked", "4k3/5p2/4p3/8/3P4/8/8/4K3 w - - 0 1", -22},
+    // c4 passed (+25), d3 backward as e5 attacks d4 (-10). e5 isolated, with e4 attacked by d3, but not also backward (-12).
+    {"backward", "4k3/8/8/4p3/2P5/3P4/8/4K3 w - - 0 1", 27},
+};
+
+
+int main(){
+    int failures = 0;
+    for (const PawnCase& c: CASES){
+        Player white(PieceColor::WHITE);
+        Player black(PieceColor::BLACK);
+        Game game(&white, &black, c.fen);
+        int score = evaluatePawnStructure(game.getBoard(), game.getPawnHash()).score;
+        if (score != c.score){
+            std::cerr << "FAIL: " << c.name << ": " << score << " (EXPECTED " << c.score << ")" << std::endl;
+            failures++;
+        }
+    }
+    if (failures > 0){
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "perft.hpp"
+
+
+// Checks perft() against published reference counts, so any change to move generation that loses or adds a move
+// (castling, en passant, promotions, pins, Chess960 castling) fails here. Exits with 1 if any count is off.
+
+
+struct PerftCase{
+    const char* name;
+    const char* fen;
+    bool chess960;
+    std::vector<uint64_t> counts; // counts[d] is the count at depth d + 1
+};
+
+
+static const PerftCase CASES[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", false,
+        {20, 400, 8902, 197281, 4865609}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", false,
+        {48, 2039, 97862, 4085603}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", false,
+        {14, 191, 2812, 43238, 674624}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", false,
+        {6, 264, 9467, 422333}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", false,
+        {44, 1486, 62379, 2103487}},
+    {"chess960 #1", "bqnb1rkr/pp3ppp/3ppn2/2p5/5P2/P2P4/NPP1P1PP/BQ1BNRKR w HFhf - 2 9", true,
+        {21, 528, 12189, 326672}},
+    {"chess960 #2", "2nnrbkr/p1qppppp/8/1ppb4/6PP/3PP3/PPP2P2/BQNNRBKR w HEhe - 1 9", true,
+        {21, 807, 18002, 667366}},
+};
+
+
+int main(){
+    int failures = 0;
+    for (const PerftCase& c: CASES){
+        Player white(PieceColor::WHITE);
+        Player black(PieceColor::BLACK);
+        Game game(&white, &black, c.fen, c.chess960);
+        std::string fen = game.toFen(); // Chess960 castling rights come out as X-FEN, so not always as given
+        for (size_t d = 0; d < c.counts.size(); d++){
+            uint64_t nodes = perft(game, d + 1);
+            if (nodes != c.counts[d]){
+                std::cerr << "FAIL: " << c.name << " DEPTH " << d + 1 << ": " << nodes << " (EXPECTED " << c.counts[d] << ")" << std::endl;
+                failures++;
+            }
+        }
+        if (game.toFen() != fen){
+            std::cerr << "FAIL: " << c.name << ": PERFT LEFT THE GAME IN " << game.toFen() << std::endl;
+            failures++;
+        }
+    }
+    if (failures > 0){
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}